@@ -0,0 +1,151 @@
+// Benchmark: svg_color_parse against the sscanf and linear-search decoding it replaced
+// Build: make bench   Run: build/bench_color.exe [count]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/svg_color.h"
+#include "../include/svg_color_table.h"
+
+#define COLOR_LEN 32
+
+typedef struct {
+    const char *name;
+    char *text;//count entries of COLOR_LEN bytes, NUL-terminated
+    size_t *len;
+    uint32_t *expected;//0xRRGGBBAA
+} Corpus;
+
+static const SvgNamedColor *keywords[SVG_COLOR_SLOTS];
+static int keyword_count;
+
+static unsigned next_random(unsigned *state) {
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 8) & 0xFFFFFF;
+}
+
+// Write one color of the requested kind into buf and its value into *expected
+static size_t make_color(char *buf, int kind, unsigned *state, uint32_t *expected) {
+    unsigned rgb = next_random(state);
+    switch (kind) {
+        case 0: { // keyword, in the mixed case people write
+            const SvgNamedColor *named = keywords[next_random(state) % keyword_count];
+            memcpy(buf, named->name, named->len + 1);
+            if (rgb & 1) buf[0] = (char)(buf[0] - 'a' + 'A');
+            *expected = (named->rgb << 8) | 0xFF;
+            return named->len;
+        }
+        case 1: // #RRGGBB
+            *expected = (rgb << 8) | 0xFF;
+            return (size_t)sprintf(buf, "#%06x", rgb);
+        case 2: // #RGB
+            rgb &= 0xFFF;
+            *expected = SVG_RGBA((rgb >> 8) * 17, ((rgb >> 4) & 0xF) * 17, (rgb & 0xF) * 17, 0xFF);
+            return (size_t)sprintf(buf, "#%03x", rgb);
+        default: // rgb()
+            *expected = (rgb << 8) | 0xFF;
+            return (size_t)sprintf(buf, "rgb(%u, %u, %u)", rgb >> 16, (rgb >> 8) & 0xFF, rgb & 0xFF);
+    }
+}
+
+static Corpus make_corpus(const char *name, int kind, size_t count) {
+    Corpus c;
+    unsigned state = 777u + (unsigned)kind;
+    c.name = name;
+    c.text = (char *)malloc(count * COLOR_LEN);
+    c.len = (size_t *)malloc(count * sizeof(size_t));
+    c.expected = (uint32_t *)malloc(count * sizeof(uint32_t));
+    for (size_t i = 0; i < count; i++) {
+        c.len[i] = make_color(c.text + i * COLOR_LEN, kind, &state, &c.expected[i]);
+    }
+    return c;
+}
+
+static double seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static int same_name(const char *a, const char *b, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = a[i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != b[i]) return 0;
+    }
+    return 1;
+}
+
+// What a decoder without the hash does: sscanf the forms it knows and scan
+// the keyword list in order
+static uint32_t decode_baseline(const char *s, size_t len) {
+    unsigned r, g, b;
+    if (s[0] == '#' && len == 7 && sscanf(s + 1, "%6x", &r) == 1) return (r << 8) | 0xFF;
+    if (s[0] == '#' && len == 4 && sscanf(s + 1, "%3x", &r) == 1)
+        return SVG_RGBA((r >> 8) * 17, ((r >> 4) & 0xF) * 17, (r & 0xF) * 17, 0xFF);
+    if (sscanf(s, "rgb(%u , %u , %u )", &r, &g, &b) == 3) return SVG_RGBA(r, g, b, 0xFF);
+    for (int i = 0; i < keyword_count; i++) {
+        if (keywords[i]->len == len && same_name(s, keywords[i]->name, len))
+            return (keywords[i]->rgb << 8) | 0xFF;
+    }
+    return 0;
+}
+
+static void run(const Corpus *c, size_t count, int rounds) {
+    volatile uint32_t sink = 0;
+    size_t mismatches = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const char *s = c->text + i * COLOR_LEN;
+        uint32_t got = 0;
+        if (svg_color_parse(s, c->len[i], &got) != 0 || got != c->expected[i]) {
+            if (mismatches < 5) printf("  mismatch: %s -> %08X (expected %08X)\n", s, got, c->expected[i]);
+            mismatches++;
+        }
+    }
+
+    clock_t start = clock();
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < count; i++) sink += decode_baseline(c->text + i * COLOR_LEN, c->len[i]);
+    double t_baseline = seconds(start);
+
+    start = clock();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) {
+            uint32_t rgba = 0;
+            svg_color_parse(c->text + i * COLOR_LEN, c->len[i], &rgba);
+            sink += rgba;
+        }
+    }
+    double t_svg = seconds(start);
+    (void)sink;
+
+    double n = (double)count * rounds;
+    printf("%-8s sscanf/linear %6.1f ns  svg_color_parse %6.1f ns  (%.1fx)  mismatches %lu\n",
+           c->name, t_baseline * 1e9 / n, t_svg * 1e9 / n,
+           t_svg > 0 ? t_baseline / t_svg : 0.0, (unsigned long)mismatches);
+}
+
+int main(int argc, char *argv[]) {
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 1000000;
+    const char *names[] = {"keyword", "#rrggbb", "#rgb", "rgb()"};
+
+    // The keyword list in alphabetical order, as a hand-written table would be
+    for (int i = 0; i < SVG_COLOR_SLOTS; i++) {
+        if (!svg_color_slots[i].name) continue;
+        int at = keyword_count++;
+        while (at > 0 && strcmp(keywords[at - 1]->name, svg_color_slots[i].name) > 0) {
+            keywords[at] = keywords[at - 1];
+            at--;
+        }
+        keywords[at] = &svg_color_slots[i];
+    }
+
+    printf("Decoding %lu colors per kind, 5 rounds\n", (unsigned long)count);
+    for (int kind = 0; kind < 4; kind++) {
+        Corpus c = make_corpus(names[kind], kind, count);
+        run(&c, count, 5);
+        free(c.text);
+        free(c.len);
+        free(c.expected);
+    }
+    return 0;
+}
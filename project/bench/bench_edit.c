@@ -0,0 +1,75 @@
+// Benchmark: the GUI's edits (find by id, move, delete) against document size
+// Build: make bench   Run: build/bench_edit.exe [max_shapes]
+//
+// Each size loads a generated document, then times random ids being looked up,
+// moved by set_shape and finally removed. The cost per edit should not grow
+// with the document.
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/svg_parser.h"
+#include "../include/svg_platform.h"
+#include "svg_corpus.h"
+
+#define BENCH_FILE "bench_edit.svg"
+#define BENCH_EDITS 100000
+
+static int bench_size(long shapes) {
+    SvgCorpusConfig corpus;
+    svg_corpus_defaults(&corpus);
+    corpus.seed = 7;
+    corpus.shapes = shapes;
+    SvgDocument *doc = NULL;
+    if (svg_corpus_write(BENCH_FILE, &corpus) != 0 || svg_load_from_file(BENCH_FILE, &doc) != 0) {
+        fprintf(stderr, "Cannot build %ld shapes\n", shapes);
+        return -1;
+    }
+
+    // Distinct random ids: a shuffled prefix of 1..shapes
+    long edits = shapes < BENCH_EDITS ? shapes : BENCH_EDITS;
+    int *ids = (int *)malloc(shapes * sizeof(int));
+    if (!ids) {
+        svg_free_document(doc);
+        return -1;
+    }
+    for (long i = 0; i < shapes; i++) ids[i] = (int)i + 1;
+    unsigned seed = 1;
+    for (long i = 0; i < edits; i++) {
+        seed = seed * 1103515245u + 12345u;
+        long j = i + (long)((seed >> 4) % (unsigned long)(shapes - i));
+        int t = ids[i];
+        ids[i] = ids[j];
+        ids[j] = t;
+    }
+
+    double start = svg_wall_seconds();
+    for (long i = 0; i < edits; i++) {
+        SvgShapeHandle handle = svg_document_find_shape(doc, ids[i]);
+        SvgShape shape;
+        if (svg_document_get_shape(doc, handle, &shape) != 0) continue;
+        if (shape.type == SVG_SHAPE_CIRCLE) shape.data.circle.cx += 1.0;
+        else if (shape.type == SVG_SHAPE_RECT) shape.data.rect.x += 1.0;
+        else if (shape.type == SVG_SHAPE_LINE) shape.data.line.x1 += 1.0;
+        svg_document_set_shape(doc, handle, &shape);
+    }
+    double moved = svg_wall_seconds() - start;
+
+    start = svg_wall_seconds();
+    for (long i = 0; i < edits; i++) svg_document_remove_shape(doc, svg_document_find_shape(doc, ids[i]));
+    double removed = svg_wall_seconds() - start;
+
+    printf("  %9ld shapes  move %7.1f ns  delete %7.1f ns  (%lu left)\n", shapes, moved / edits * 1e9,
+           removed / edits * 1e9, (unsigned long)svg_document_shape_count(doc));
+    free(ids);
+    svg_free_document(doc);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    long max_shapes = argc > 1 ? atol(argv[1]) : 1000000;
+    printf("%d random edits per size\n", BENCH_EDITS);
+    int status = 0;
+    for (long shapes = 10000; shapes <= max_shapes && status == 0; shapes *= 10)
+        status = bench_size(shapes);
+    remove(BENCH_FILE);
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+// Benchmark: region queries and picking, grid index against a packed R-tree and a linear scan
+// Build: make bench   Run: build/bench_index.exe [shapes]
+//
+// The document is shapes small circles, rects and lines spread over a square
+// of about 40 x 40 units per shape, filled through svg_document_add_shape.
+// Each structure answers the same random 800 x 600 crops and the grid also
+// picks points. The packed R-tree (sort-tile-recursive, 16 boxes a node) is
+// built here only for comparison: its nodes cannot follow a moved shape, so
+// every GUI edit would rebuild it, which is why the document uses the grid.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/svg_parser.h"
+#include "../include/svg_platform.h"
+#include "../include/svg_store.h"
+
+#define BENCH_QUERIES 2000
+#define BENCH_EDITS 100000
+#define RTREE_FANOUT 16
+
+static SvgDocument *build_document(long shapes, double span) {
+    SvgDocument *doc = create_svg_document(span, span);
+    if (!doc) return NULL;
+    unsigned seed = 42;
+    for (long i = 0; i < shapes; i++) {
+        SvgShape shape;
+        memset(&shape, 0, sizeof(shape));
+        seed = seed * 1103515245u + 12345u;
+        double a = (seed >> 8) / 16777216.0 * span;
+        seed = seed * 1103515245u + 12345u;
+        double b = (seed >> 8) / 16777216.0 * span;
+        switch (i % 3) {
+            case 0:
+                shape.type = SVG_SHAPE_CIRCLE;
+                shape.data.circle.cx = a;
+                shape.data.circle.cy = b;
+                shape.data.circle.r = 5.0;
+                break;
+            case 1:
+                shape.type = SVG_SHAPE_RECT;
+                shape.data.rect.x = a;
+                shape.data.rect.y = b;
+                shape.data.rect.width = 12.0;
+                shape.data.rect.height = 8.0;
+                break;
+            default:
+                shape.type = SVG_SHAPE_LINE;
+                shape.data.line.x1 = a;
+                shape.data.line.y1 = b;
+                shape.data.line.x2 = a + 15.0;
+                shape.data.line.y2 = b + 4.0;
+                break;
+        }
+        if (svg_document_add_shape(doc, &shape) == SVG_NO_SHAPE) {
+            svg_free_document(doc);
+            return NULL;
+        }
+    }
+    return doc;
+}
+
+// ---- packed R-tree: shapes in sort-tile-recursive order, each level grouping the one below ----
+
+#define RTREE_MAX_LEVELS 32
+
+typedef struct {
+    size_t *items;//positions, in tile order
+    double (*item_boxes)[4];
+    size_t count;
+    double (*nodes)[4];//every level, bottom first
+    size_t level_start[RTREE_MAX_LEVELS], level_count[RTREE_MAX_LEVELS];
+    int levels;
+} RTree;
+
+static double (*sort_boxes)[4];
+static int sort_axis;
+
+static int compare_center(const void *a, const void *b) {
+    const double *p = sort_boxes[*(const size_t *)a], *q = sort_boxes[*(const size_t *)b];
+    double x = p[sort_axis] + p[sort_axis + 2], y = q[sort_axis] + q[sort_axis + 2];
+    return x < y ? -1 : x > y;
+}
+
+static void grow(double box[4], const double add[4]) {
+    if (add[0] < box[0]) box[0] = add[0];
+    if (add[1] < box[1]) box[1] = add[1];
+    if (add[2] > box[2]) box[2] = add[2];
+    if (add[3] > box[3]) box[3] = add[3];
+}
+
+// Union of count boxes from first
+static void merge(double out[4], double (*boxes)[4], size_t first, size_t count) {
+    memcpy(out, boxes[first], 4 * sizeof(double));
+    for (size_t k = 1; k < count; k++) grow(out, boxes[first + k]);
+}
+
+static int rtree_build(RTree *tree, const SvgShapeStore *store) {
+    memset(tree, 0, sizeof(*tree));
+    size_t n = store->count;
+    size_t node_total = n / (RTREE_FANOUT - 1) + RTREE_MAX_LEVELS;
+    tree->items = (size_t *)malloc((n ? n : 1) * sizeof(size_t));
+    tree->item_boxes = (double (*)[4])malloc((n ? n : 1) * sizeof(*tree->item_boxes));
+    tree->nodes = (double (*)[4])malloc(node_total * sizeof(*tree->nodes));
+    if (!tree->items || !tree->item_boxes || !tree->nodes) return -1;
+    tree->count = n;
+
+    // Order by x, cut into vertical slices of whole nodes, order each slice by y
+    for (size_t i = 0; i < n; i++) tree->items[i] = i;
+    size_t leaves = (n + RTREE_FANOUT - 1) / RTREE_FANOUT;
+    size_t slice = (size_t)ceil(sqrt((double)leaves)) * RTREE_FANOUT;
+    sort_boxes = store->bounds;
+    sort_axis = 0;
+    qsort(tree->items, n, sizeof(size_t), compare_center);
+    sort_axis = 1;
+    for (size_t s = 0; s < n; s += slice)
+        qsort(tree->items + s, n - s < slice ? n - s : slice, sizeof(size_t), compare_center);
+    for (size_t i = 0; i < n; i++) memcpy(tree->item_boxes[i], store->bounds[tree->items[i]], 4 * sizeof(double));
+
+    // Each level groups RTREE_FANOUT consecutive entries of the one below
+    size_t below = n, used = 0;
+    double (*below_boxes)[4] = tree->item_boxes;
+    while (tree->levels < RTREE_MAX_LEVELS) {
+        size_t count = (below + RTREE_FANOUT - 1) / RTREE_FANOUT;
+        tree->level_start[tree->levels] = used;
+        tree->level_count[tree->levels] = count;
+        for (size_t i = 0; i < count; i++) {
+            size_t first = i * RTREE_FANOUT;
+            merge(tree->nodes[used + i], below_boxes, first, below - first < RTREE_FANOUT ? below - first : RTREE_FANOUT);
+        }
+        below_boxes = tree->nodes + used;
+        used += count;
+        below = count;
+        tree->levels++;
+        if (count <= 1) break;
+    }
+    return 0;
+}
+
+static void rtree_free(RTree *tree) {
+    free(tree->items);
+    free(tree->item_boxes);
+    free(tree->nodes);
+}
+
+static int meets(const double box[4], const double rect[4]) {
+    return !(box[2] < rect[0] || box[0] > rect[2] || box[3] < rect[1] || box[1] > rect[3]);
+}
+
+// Positions are gathered, then sorted into draw order and made handles, as the grid does
+static int add_found(SvgShapeQuery *found, size_t position) {
+    if (found->count == found->capacity) {
+        size_t capacity = found->capacity ? found->capacity * 2 : 64;
+        SvgShapeHandle *handles = (SvgShapeHandle *)realloc(found->handles, capacity * sizeof(SvgShapeHandle));
+        if (!handles) return -1;
+        found->handles = handles;
+        found->capacity = capacity;
+    }
+    found->handles[found->count++] = position;
+    return 0;
+}
+
+static void rtree_visit(const RTree *tree, int level, size_t node, const double rect[4], SvgShapeQuery *found) {
+    size_t first = node * RTREE_FANOUT;
+    if (level == 0) {
+        size_t end = first + RTREE_FANOUT < tree->count ? first + RTREE_FANOUT : tree->count;
+        for (size_t i = first; i < end; i++) {
+            if (meets(tree->item_boxes[i], rect)) add_found(found, tree->items[i]);
+        }
+        return;
+    }
+    size_t below = tree->level_count[level - 1];
+    size_t end = first + RTREE_FANOUT < below ? first + RTREE_FANOUT : below;
+    for (size_t i = first; i < end; i++) {
+        if (meets(tree->nodes[tree->level_start[level - 1] + i], rect)) rtree_visit(tree, level - 1, i, rect, found);
+    }
+}
+
+static int compare_positions(const void *a, const void *b) {
+    SvgShapeHandle x = *(const SvgShapeHandle *)a, y = *(const SvgShapeHandle *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void rtree_query(const RTree *tree, const SvgShapeStore *store, const double rect[4], SvgShapeQuery *found) {
+    found->count = 0;
+    if (tree->count == 0) return;
+    int top = tree->levels - 1;
+    if (meets(tree->nodes[tree->level_start[top]], rect)) rtree_visit(tree, top, 0, rect, found);
+    qsort(found->handles, found->count, sizeof(SvgShapeHandle), compare_positions);
+    for (size_t i = 0; i < found->count; i++) found->handles[i] = svg_store_handle(store, (size_t)found->handles[i]);
+}
+
+static size_t linear_query(const SvgShapeStore *store, const double rect[4]) {
+    size_t found = 0;
+    for (size_t i = 0; i < store->count; i++) found += meets(store->bounds[i], rect);
+    return found;
+}
+
+int main(int argc, char *argv[]) {
+    long shapes = argc > 1 ? atol(argv[1]) : 1000000;
+    double span = sqrt((double)shapes) * 40.0;
+    SvgDocument *doc = build_document(shapes, span);
+    if (!doc) {
+        fprintf(stderr, "Out of memory building %ld shapes\n", shapes);
+        return 1;
+    }
+
+    // The same crops for every structure
+    double (*crops)[4] = (double (*)[4])malloc(BENCH_QUERIES * sizeof(*crops));
+    if (!crops) return 1;
+    unsigned seed = 7;
+    for (int q = 0; q < BENCH_QUERIES; q++) {
+        seed = seed * 1103515245u + 12345u;
+        crops[q][0] = (seed >> 8) / 16777216.0 * span;
+        seed = seed * 1103515245u + 12345u;
+        crops[q][1] = (seed >> 8) / 16777216.0 * span;
+        crops[q][2] = crops[q][0] + 800.0;
+        crops[q][3] = crops[q][1] + 600.0;
+    }
+
+    SvgShapeQuery query = {NULL, 0, 0};
+    double start = svg_wall_seconds();
+    double first[4] = {0.0, 0.0, 0.0, 0.0};
+    svg_document_query_rect(doc, first, &query); // builds the grid
+    double grid_build = svg_wall_seconds() - start;
+    size_t grid_found = 0;
+    start = svg_wall_seconds();
+    for (int q = 0; q < BENCH_QUERIES; q++) {
+        if (svg_document_query_rect(doc, crops[q], &query) != 0) return 1;
+        grid_found += query.count;
+    }
+    double grid_query = (svg_wall_seconds() - start) / BENCH_QUERIES;
+
+    start = svg_wall_seconds();
+    size_t picked = 0;
+    for (int q = 0; q < BENCH_QUERIES; q++)
+        picked += svg_document_shape_at(doc, crops[q][0], crops[q][1], 5.0) != SVG_NO_SHAPE;
+    double grid_pick = (svg_wall_seconds() - start) / BENCH_QUERIES;
+
+    RTree tree;
+    start = svg_wall_seconds();
+    if (rtree_build(&tree, &doc->shapes) != 0) return 1;
+    double rtree_time = svg_wall_seconds() - start;
+    size_t rtree_found = 0;
+    start = svg_wall_seconds();
+    for (int q = 0; q < BENCH_QUERIES; q++) {
+        rtree_query(&tree, &doc->shapes, crops[q], &query);
+        rtree_found += query.count;
+    }
+    double rtree_each = (svg_wall_seconds() - start) / BENCH_QUERIES;
+
+    size_t linear_found = 0;
+    int linear_runs = BENCH_QUERIES / 20;
+    start = svg_wall_seconds();
+    for (int q = 0; q < linear_runs; q++) linear_found += linear_query(&doc->shapes, crops[q]);
+    double linear_each = (svg_wall_seconds() - start) / linear_runs;
+
+    // Moving shapes: the grid takes each out of its cells and puts it back
+    start = svg_wall_seconds();
+    long edits = shapes < BENCH_EDITS ? shapes : BENCH_EDITS;
+    for (long i = 0; i < edits; i++) {
+        SvgShapeHandle handle = svg_document_find_shape(doc, (int)(i * 7919 % shapes) + 1);
+        SvgShape shape;
+        if (svg_document_get_shape(doc, handle, &shape) != 0) continue;
+        if (shape.type == SVG_SHAPE_CIRCLE) shape.data.circle.cx += 30.0;
+        else if (shape.type == SVG_SHAPE_RECT) shape.data.rect.x += 30.0;
+        else shape.data.line.x2 += 30.0;
+        svg_document_set_shape(doc, handle, &shape);
+    }
+    double grid_edit = (svg_wall_seconds() - start) / edits;
+
+    printf("%ld shapes over %.0f x %.0f, 800 x 600 crops (%.1f shapes each)\n", shapes, span, span,
+           (double)grid_found / BENCH_QUERIES);
+    printf("  grid    build %8.1f ms  crop %8.2f us  pick %6.2f us  move %6.1f ns  (%lu picked)\n",
+           grid_build * 1e3, grid_query * 1e6, grid_pick * 1e6, grid_edit * 1e9, (unsigned long)picked);
+    printf("  R-tree  build %8.1f ms  crop %8.2f us  move = rebuild  (%lu found)\n",
+           rtree_time * 1e3, rtree_each * 1e6, (unsigned long)rtree_found);
+    printf("  linear            crop %8.2f us  (%lu found in %d)\n", linear_each * 1e6,
+           (unsigned long)linear_found, linear_runs);
+
+    rtree_free(&tree);
+    svg_shape_query_release(&query);
+    free(crops);
+    svg_free_document(doc);
+    return 0;
+}
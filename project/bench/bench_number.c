@@ -0,0 +1,111 @@
+// Benchmark: svg_parse_number against atof and strtod
+// Build: make bench   Run: build/bench_number.exe [count]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/svg_number.h"
+
+#define NUMBER_LEN 40
+
+typedef struct {
+    const char *name;
+    char *text;//count entries of NUMBER_LEN bytes, NUL-terminated
+    size_t *len;
+} Corpus;
+
+static unsigned next_random(unsigned *state) {
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 8) & 0xFFFFFF;
+}
+
+// Write one number of the requested kind into buf
+static size_t make_number(char *buf, int kind, unsigned *state) {
+    unsigned a = next_random(state);
+    unsigned b = next_random(state);
+    switch (kind) {
+        case 0: // short coordinate, e.g. 123.45
+            return (size_t)sprintf(buf, "%u.%02u", a % 2000, b % 100);
+        case 1: // integer
+            return (size_t)sprintf(buf, "%u", a % 100000);
+        case 2: // long machine output, 17 significant digits
+            return (size_t)sprintf(buf, "%.17g", (double)a / (double)(b + 1) * 1000.0);
+        default: // exponent form
+            return (size_t)sprintf(buf, "%s%u.%03ue%s%u", (a & 1) ? "-" : "",
+                                   a % 10, b % 1000, (b & 1) ? "-" : "", b % 40);
+    }
+}
+
+static Corpus make_corpus(const char *name, int kind, size_t count) {
+    Corpus c;
+    unsigned state = 12345u + (unsigned)kind;
+    c.name = name;
+    c.text = (char *)malloc(count * NUMBER_LEN);
+    c.len = (size_t *)malloc(count * sizeof(size_t));
+    for (size_t i = 0; i < count; i++) {
+        c.len[i] = make_number(c.text + i * NUMBER_LEN, kind, &state);
+    }
+    return c;
+}
+
+static double seconds(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void run(const Corpus *c, size_t count, int rounds) {
+    volatile double sink = 0.0;
+    size_t mismatches = 0;
+
+    // Correctness: bit-identical to strtod
+    for (size_t i = 0; i < count; i++) {
+        const char *s = c->text + i * NUMBER_LEN;
+        double expected = strtod(s, NULL);
+        double got = 0.0;
+        svg_parse_number(s, s + c->len[i], &got);
+        if (memcmp(&expected, &got, sizeof(double)) != 0) {
+            if (mismatches < 5) printf("  mismatch: %s -> %.17g (strtod %.17g)\n", s, got, expected);
+            mismatches++;
+        }
+    }
+
+    clock_t start = clock();
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < count; i++) sink += atof(c->text + i * NUMBER_LEN);
+    double t_atof = seconds(start);
+
+    start = clock();
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < count; i++) sink += strtod(c->text + i * NUMBER_LEN, NULL);
+    double t_strtod = seconds(start);
+
+    start = clock();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) {
+            const char *s = c->text + i * NUMBER_LEN;
+            double v;
+            svg_parse_number(s, s + c->len[i], &v);
+            sink += v;
+        }
+    }
+    double t_svg = seconds(start);
+    (void)sink;
+
+    double n = (double)count * rounds;
+    printf("%-10s atof %6.1f ns  strtod %6.1f ns  svg_parse_number %6.1f ns  (%.1fx vs strtod)  mismatches %lu\n",
+           c->name, t_atof * 1e9 / n, t_strtod * 1e9 / n, t_svg * 1e9 / n,
+           t_svg > 0 ? t_strtod / t_svg : 0.0, (unsigned long)mismatches);
+}
+
+int main(int argc, char *argv[]) {
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 1000000;
+    const char *names[] = {"short", "integer", "long", "exponent"};
+
+    printf("Parsing %lu numbers per kind, 5 rounds\n", (unsigned long)count);
+    for (int kind = 0; kind < 4; kind++) {
+        Corpus c = make_corpus(names[kind], kind, count);
+        run(&c, count, 5);
+        free(c.text);
+        free(c.len);
+    }
+    return 0;
+}
@@ -0,0 +1,232 @@
+// Benchmark: parser throughput, allocations and peak memory for every loader
+// Build: make bench
+// Run:   build/bench_parse.exe [--shapes n] [--mix c:r:l] [--seed s] [--threads n]
+//
+// Each loader runs in its own child process (the program re-runs itself with
+// --run) so peak RSS belongs to that loader alone. Allocations are counted by
+// linking with -Wl,--wrap=malloc,... (see the Makefile), so only calls made by
+// the project are counted, not those inside the C library. MB/s is always
+// measured against the size of the .svg text, including for .svgb.
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "../include/svg_parser.h"
+#include "../include/svg_binary.h"
+#include "../include/svg_platform.h"
+#include "svg_corpus.h"
+
+#define BENCH_FILE "bench_parse.svg"
+#define BENCH_BINARY "bench_parse.svgb"
+#define BENCH_OUTPUT "bench_parse.out"
+#define BENCH_RUNS 3
+
+// ---- allocation counting (the linker routes our malloc calls here) ----
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static long alloc_count;
+
+void *__wrap_malloc(size_t size) {
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    alloc_count++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    if (!ptr) alloc_count++;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+    __real_free(ptr);
+}
+
+static long peak_rss_kb(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_maxrss;//kilobytes on Linux
+#endif
+}
+
+// ---- loaders ----
+
+static const char *loaders[] = {"file", "mmap", "parallel", "stream", "svgb", "lazy"};
+#define LOADER_COUNT (int)(sizeof(loaders) / sizeof(loaders[0]))
+
+static int count_shape(void *ctx, const SvgShape *shape) {
+    (void)shape;
+    (*(long *)ctx)++;
+    return 0;
+}
+
+// One load with the named loader; returns the number of shapes, or -1
+static long run_loader(const char *loader, int threads) {
+    SvgDocument *doc = NULL;
+    int result = -1;
+
+    if (strcmp(loader, "stream") == 0) {
+        long shapes = 0;
+        SvgShapeSink sink = {NULL, count_shape, &shapes};
+        return svg_stream_file(BENCH_FILE, &sink) == 0 ? shapes : -1;
+    } else if (strcmp(loader, "svgb") == 0) {
+        SvgbFile file;
+        if (svgb_open(BENCH_BINARY, &file) != 0) return -1;
+        doc = svgb_to_document(&file);
+        svgb_close(&file);
+        result = doc ? 0 : -1;
+    } else if (strcmp(loader, "lazy") == 0) {
+        result = svg_load_from_file_lazy(BENCH_FILE, &doc); // shapes stay undecoded
+    } else if (strcmp(loader, "mmap") == 0) {
+        result = svg_load_from_file_mmap(BENCH_FILE, &doc);
+    } else if (strcmp(loader, "parallel") == 0) {
+        result = svg_load_from_file_parallel(BENCH_FILE, threads, &doc);
+    } else {
+        result = svg_load_from_file(BENCH_FILE, &doc);
+    }
+
+    if (result != 0) return -1;
+    long shapes = (long)svg_document_shape_count(doc);
+    svg_free_document(doc);
+    return shapes;
+}
+
+// Child process: best time of BENCH_RUNS, allocations of one run, peak RSS
+static int run_child(const char *loader, int threads) {
+    double best = 1e30;
+    long shapes = 0, allocs = 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        long before = alloc_count;
+        double start = svg_wall_seconds();
+        shapes = run_loader(loader, threads);
+        double elapsed = svg_wall_seconds() - start;
+        if (shapes < 0) return 1;
+        if (run == 0) allocs = alloc_count - before;
+        if (elapsed < best) best = elapsed;
+    }
+    printf("%.9f %ld %ld %ld\n", best, shapes, allocs, peak_rss_kb());
+    return 0;
+}
+
+// ---- driver ----
+
+static long file_size(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+// Re-run this program for one loader and read back its result line
+static int spawn_child(const char *self, const char *loader, int threads,
+                       double *seconds, long *shapes, long *allocs, long *rss_kb) {
+    char command[1024];
+#ifdef _WIN32
+    //cmd.exe strips the outer quotes of the whole line
+    snprintf(command, sizeof(command), "\"\"%s\" --run %s %d > %s\"", self, loader, threads, BENCH_OUTPUT);
+#else
+    snprintf(command, sizeof(command), "\"%s\" --run %s %d > %s", self, loader, threads, BENCH_OUTPUT);
+#endif
+    if (system(command) != 0) return -1;
+
+    FILE *file = fopen(BENCH_OUTPUT, "r");
+    if (!file) return -1;
+    int fields = fscanf(file, "%lf %ld %ld %ld", seconds, shapes, allocs, rss_kb);
+    fclose(file);
+    return fields == 4 ? 0 : -1;
+}
+
+static int bench_corpus(const char *self, const SvgCorpusConfig *corpus, int threads) {
+    if (svg_corpus_write(BENCH_FILE, corpus) != 0) {
+        fprintf(stderr, "Cannot write %s\n", BENCH_FILE);
+        return -1;
+    }
+
+    SvgDocument *doc = NULL;
+    if (svg_load_from_file(BENCH_FILE, &doc) != 0 || svgb_write(BENCH_BINARY, doc) != 0) {
+        fprintf(stderr, "Cannot compile %s\n", BENCH_FILE);
+        if (doc) svg_free_document(doc);
+        return -1;
+    }
+    svg_free_document(doc);
+
+    long bytes = file_size(BENCH_FILE);
+    printf("%s: %.1f MB\n", svg_corpus_name(corpus), bytes / 1e6);
+    for (int i = 0; i < LOADER_COUNT; i++) {
+        double seconds;
+        long shapes, allocs, rss_kb;
+        if (spawn_child(self, loaders[i], threads, &seconds, &shapes, &allocs, &rss_kb) != 0) {
+            printf("  %-9s failed\n", loaders[i]);
+            continue;
+        }
+        printf("  %-9s %8.1f MB/s  %7.2f Mshapes/s  %9ld allocs  %7.1f MB peak RSS\n",
+               loaders[i], bytes / seconds / 1e6, shapes / seconds / 1e6, allocs, rss_kb / 1024.0);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 4 && strcmp(argv[1], "--run") == 0) {
+        return run_child(argv[2], atoi(argv[3]));
+    }
+
+    SvgCorpusConfig corpus;
+    svg_corpus_defaults(&corpus);
+    int threads = 0;//0 = one per CPU
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--shapes") == 0) {
+            corpus.shapes = atol(argv[i + 1]);
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            corpus.seed = (unsigned)strtoul(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--mix") == 0) {
+            if (sscanf(argv[i + 1], "%d:%d:%d", &corpus.circle_weight,
+                       &corpus.rect_weight, &corpus.line_weight) != 3) {
+                fprintf(stderr, "Expected --mix circles:rects:lines\n");
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    printf("%ld shapes, mix %d:%d:%d, seed %u, %d CPUs\n", corpus.shapes, corpus.circle_weight,
+           corpus.rect_weight, corpus.line_weight, corpus.seed, svg_cpu_count());
+
+    int status = 0;
+    for (int layout = 0; layout < 4 && status == 0; layout++) {
+        corpus.minified = layout / 2;
+        corpus.long_numbers = layout % 2;
+        status = bench_corpus(argv[0], &corpus, threads);
+    }
+
+    remove(BENCH_FILE);
+    remove(BENCH_BINARY);
+    remove(BENCH_OUTPUT);
+    return status == 0 ? 0 : 1;
+}
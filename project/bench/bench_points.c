@@ -0,0 +1,84 @@
+// Benchmark: one polygon whose points list is longer than the stream window
+// Build: make bench   Run: build/bench_points.exe [points]
+//
+// The file is loaded through every loader: the stream window (which has to
+// grow for the one tag), the mapping, the lazy mapping and the parallel slices.
+// Each must keep all three shapes, the polygon with every point, and a group
+// around an equally long open tag must still move the shape after it; a
+// loader that differs fails the run.
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/svg_parser.h"
+#include "../include/svg_tokenizer.h"
+#include "../include/svg_platform.h"
+
+#define BENCH_FILE "bench_points.svg"
+
+static int write_file(long points) {
+    FILE *file = fopen(BENCH_FILE, "w");
+    if (!file) return -1;
+    fprintf(file, "<svg width=\"1000\" height=\"1000\" xmlns=\"http://www.w3.org/2000/svg\">\n");
+    fprintf(file, "  <rect x=\"1\" y=\"1\" width=\"8\" height=\"8\" fill=\"#336699\"/>\n");
+    fprintf(file, "  <polygon fill=\"#CC3333\" points=\"");
+    for (long i = 0; i < points; i++) fprintf(file, "%s%ld,%ld", i ? " " : "", i % 1000, i * 7 % 1000);
+    fprintf(file, "\"/>\n");
+    // An open tag as long as the points list; the rect after it is still in the outer group
+    fprintf(file, "  <g transform=\"translate(5,5)\"><g class=\"");
+    for (long i = 0; i < points; i++) fprintf(file, "p%ld ", i % 1000);
+    fprintf(file, "\"></g><rect x=\"20\" y=\"20\" width=\"8\" height=\"8\"/></g>\n");
+    fprintf(file, "</svg>\n");
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+static int load_lazy(const char *filename, SvgDocument **doc_out) {
+    if (svg_load_from_file_lazy(filename, doc_out) != 0) return -1;
+    return svg_document_decode(*doc_out);
+}
+
+static int load_parallel(const char *filename, SvgDocument **doc_out) {
+    return svg_load_from_file_parallel(filename, 4, doc_out);
+}
+
+// Load through one path and check the shapes it kept
+static int step(const char *name, int (*load)(const char *, SvgDocument **), long points) {
+    SvgDocument *doc = NULL;
+    double start = svg_wall_seconds();
+    if (load(BENCH_FILE, &doc) != 0) {
+        fprintf(stderr, "%s: load failed\n", name);
+        return -1;
+    }
+    double seconds = svg_wall_seconds() - start;
+
+    size_t shapes = svg_document_shape_count(doc);
+    long kept = -1;
+    double moved = -1.0;
+    SvgShapeIter it;
+    for (const SvgShape *shape = svg_shapes_first(&it, doc); shape; shape = svg_shapes_next(&it)) {
+        if (shape->type == SVG_SHAPE_POLYGON) kept = shape->data.poly.count;
+        if (shape->type == SVG_SHAPE_RECT && shape->data.rect.x == 20.0)
+            moved = shape->transform ? shape->transform->e : 0.0;
+    }
+    int ok = shapes == 3 && kept == points && moved == 5.0;
+    printf("  %-10s %8.2f ms  shapes=%lu points=%ld translate=%.0f%s\n", name, seconds * 1e3,
+           (unsigned long)shapes, kept, moved, ok ? "" : "  UNEXPECTED");
+    svg_free_document(doc);
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    long points = argc > 1 ? atol(argv[1]) : 100000;
+    if (points < 1) points = 1;
+    if (write_file(points) != 0) {
+        fprintf(stderr, "Cannot write %ld points\n", points);
+        return 1;
+    }
+    printf("%ld points (stream window %lu bytes)\n", points, (unsigned long)SVG_TOKENIZER_WINDOW);
+
+    int status = step("file", svg_load_from_file, points);
+    if (status == 0) status = step("mmap", svg_load_from_file_mmap, points);
+    if (status == 0) status = step("lazy", load_lazy, points);
+    if (status == 0) status = step("parallel", load_parallel, points);
+
+    remove(BENCH_FILE);
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+// Benchmark: svg_reload_from_file on a file that changed a little, or not at all
+// Build: make bench   Run: build/bench_reload.exe [shapes]
+//
+// One document is loaded through the reload path and then reloaded four
+// times: from the same file (every shape kept), from a file with one rect
+// moved and one removed (only those decoded or dropped), after the document
+// itself was edited (which must force a full reload that throws the edit
+// away), and once more from the same file. Each step checks what the
+// reload reports, so a wrong path fails the run.
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/svg_parser.h"
+#include "../include/svg_platform.h"
+
+#define BENCH_FILE "bench_reload.svg"
+
+// shapes rects in a row-major grid; moved (if >= 0) is shifted right, removed (if >= 0) left out
+static int write_file(long shapes, long moved, long removed) {
+    FILE *file = fopen(BENCH_FILE, "w");
+    if (!file) return -1;
+    fprintf(file, "<svg width=\"1000\" height=\"1000\" xmlns=\"http://www.w3.org/2000/svg\">\n");
+    for (long i = 0; i < shapes; i++) {
+        if (i == removed) continue;
+        long x = i % 100 * 10 + (i == moved ? 5 : 0), y = i / 100 % 100 * 10;
+        fprintf(file, "  <rect x=\"%ld\" y=\"%ld\" width=\"8\" height=\"8\" fill=\"#%06lX\"/>\n", x, y,
+                (unsigned long)(i * 2654435761u) & 0xFFFFFF);
+    }
+    fprintf(file, "</svg>\n");
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+static double rect_x(SvgDocument *doc, int id) {
+    SvgShape shape;
+    if (svg_document_get_shape(doc, svg_document_find_shape(doc, id), &shape) != 0) return -1.0;
+    return shape.data.rect.x;
+}
+
+// Reload and compare what it reports with what this step expects
+static int step(SvgDocument *doc, const char *name, int full, int changed, int removed) {
+    SvgChanges changes;
+    double start = svg_wall_seconds();
+    if (svg_reload_from_file(doc, BENCH_FILE, &changes) != 0) {
+        fprintf(stderr, "%s: reload failed\n", name);
+        return -1;
+    }
+    double seconds = svg_wall_seconds() - start;
+    int ok = changes.full == full && (full || (changes.changed_count == changed && changes.removed_count == removed));
+    printf("  %-10s %8.2f ms  full=%d changed=%d removed=%d%s\n", name, seconds * 1e3, changes.full,
+           changes.changed_count, changes.removed_count, ok ? "" : "  UNEXPECTED");
+    svg_changes_release(&changes);
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    long shapes = argc > 1 ? atol(argv[1]) : 100000;
+    if (shapes < 2) shapes = 2;
+    long target = shapes / 2; // the rect that moves, then gets edited
+    SvgDocument *doc = create_svg_document(0, 0);
+    if (!doc || write_file(shapes, -1, -1) != 0) {
+        fprintf(stderr, "Cannot write %ld shapes\n", shapes);
+        return 1;
+    }
+    printf("%ld shapes\n", shapes);
+
+    int status = step(doc, "first", 1, 0, 0);
+    if (status == 0) status = step(doc, "kept", 0, 0, 0);
+
+    // The moved rect is decoded anew; it and the removed one are dropped
+    if (status == 0 && write_file(shapes, target, 0) != 0) status = -1;
+    if (status == 0) status = step(doc, "changed", 0, 1, 2);
+
+    // An edit the file does not have: the next reload must not keep it
+    if (status == 0) {
+        SvgShapeHandle handle = svg_document_find_shape(doc, (int)target);
+        SvgShape shape;
+        double from_file = rect_x(doc, (int)target);
+        if (svg_document_get_shape(doc, handle, &shape) != 0) status = -1;
+        shape.data.rect.x = from_file + 70.0;
+        if (status == 0 && svg_document_set_shape(doc, handle, &shape) != 0) status = -1;
+        if (status == 0) status = step(doc, "edited", 1, 0, 0);
+        if (status == 0 && rect_x(doc, (int)target) != from_file) {
+            fprintf(stderr, "edited: the reload kept x=%.2f instead of %.2f\n", rect_x(doc, (int)target),
+                    from_file);
+            status = -1;
+        }
+    }
+    if (status == 0) status = step(doc, "kept again", 0, 0, 0);
+
+    svg_free_document(doc);
+    remove(BENCH_FILE);
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+// Benchmark: snapshots taken and rendered on another thread while the document is edited
+// Build: make bench   Run: build/bench_snapshot.exe [shapes]
+//
+// The document is filled through svg_document_add_shape. After the first
+// snapshot has copied the shapes into chunks, taking one should not depend on
+// the document's size, and an edit should only pay for copying the chunk it
+// lands in (plus the list of chunks, once per snapshot). The render of a
+// snapshot made while the main thread moves every shape is compared with a
+// render of the document made before the edits began.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/svg_parser.h"
+#include "../include/svg_platform.h"
+#include "../include/svg_raster.h"
+
+#define BENCH_SNAPSHOTS 1000
+#define BENCH_EDITS 100000
+
+static SvgDocument *build_document(long shapes) {
+    SvgDocument *doc = create_svg_document(800, 600);
+    if (!doc) return NULL;
+    unsigned seed = 42;
+    for (long i = 0; i < shapes; i++) {
+        SvgShape shape;
+        memset(&shape, 0, sizeof(shape));
+        seed = seed * 1103515245u + 12345u;
+        double a = (seed >> 8) % 800, b = (seed >> 4) % 600;
+        switch (i % 3) {
+            case 0:
+                shape.type = SVG_SHAPE_CIRCLE;
+                shape.data.circle.cx = a;
+                shape.data.circle.cy = b;
+                shape.data.circle.r = 5.0;
+                break;
+            case 1:
+                shape.type = SVG_SHAPE_RECT;
+                shape.data.rect.x = a;
+                shape.data.rect.y = b;
+                shape.data.rect.width = 10.0;
+                shape.data.rect.height = 10.0;
+                break;
+            default:
+                shape.type = SVG_SHAPE_LINE;
+                shape.data.line.x1 = a;
+                shape.data.line.y1 = b;
+                shape.data.line.x2 = b;
+                shape.data.line.y2 = a;
+                break;
+        }
+        if (svg_document_add_shape(doc, &shape) == SVG_NO_SHAPE) {
+            svg_free_document(doc);
+            return NULL;
+        }
+    }
+    return doc;
+}
+
+// Move the shape with this id a little, as a drag in the GUI does
+static void move_shape(SvgDocument *doc, int id) {
+    SvgShapeHandle handle = svg_document_find_shape(doc, id);
+    SvgShape shape;
+    if (svg_document_get_shape(doc, handle, &shape) != 0) return;
+    if (shape.type == SVG_SHAPE_CIRCLE) shape.data.circle.cx += 7.0;
+    else if (shape.type == SVG_SHAPE_RECT) shape.data.rect.x += 7.0;
+    else if (shape.type == SVG_SHAPE_LINE) shape.data.line.x1 += 7.0;
+    svg_document_set_shape(doc, handle, &shape);
+}
+
+typedef struct {
+    const SvgDocument *snapshot;
+    SvgRaster raster;
+    int result;
+    double seconds;
+} RenderJob;
+
+static void render_snapshot(void *arg) {
+    RenderJob *job = (RenderJob *)arg;
+    double start = svg_wall_seconds();
+    job->result = svg_raster_init(&job->raster, (int)job->snapshot->width, (int)job->snapshot->height);
+    if (job->result == 0) svg_raster_draw_document(&job->raster, job->snapshot);
+    job->seconds = svg_wall_seconds() - start;
+}
+
+int main(int argc, char *argv[]) {
+    long shapes = argc > 1 ? atol(argv[1]) : 1000000;
+    SvgDocument *doc = build_document(shapes);
+    if (!doc) {
+        fprintf(stderr, "Out of memory building %ld shapes\n", shapes);
+        return 1;
+    }
+    long edits = shapes < BENCH_EDITS ? shapes : BENCH_EDITS;
+
+    // The first snapshot copies every shape; later ones share the chunks
+    double start = svg_wall_seconds();
+    const SvgDocument *first = svg_document_snapshot(doc);
+    double first_seconds = svg_wall_seconds() - start;
+    start = svg_wall_seconds();
+    for (int i = 0; i < BENCH_SNAPSHOTS; i++) {
+        const SvgDocument *snapshot = svg_document_snapshot(doc);
+        if (!snapshot) return 1;
+        svg_snapshot_release(snapshot);
+    }
+    double snapshot_seconds = (svg_wall_seconds() - start) / BENCH_SNAPSHOTS;
+    svg_snapshot_release(first);
+
+    // Edits with nothing shared, then with a new snapshot held across every edit
+    start = svg_wall_seconds();
+    for (long i = 0; i < edits; i++) move_shape(doc, (int)(i * 7919 % shapes) + 1);
+    double plain = (svg_wall_seconds() - start) / edits;
+    long shared_edits = edits / 100;
+    start = svg_wall_seconds();
+    for (long i = 0; i < shared_edits; i++) {
+        const SvgDocument *snapshot = svg_document_snapshot(doc);
+        move_shape(doc, (int)(i * 7919 % shapes) + 1);
+        svg_snapshot_release(snapshot);
+    }
+    double shared = (svg_wall_seconds() - start) / shared_edits;
+
+    // Render a snapshot on a thread while every shape is moved here
+    SvgRaster before;
+    if (svg_raster_init(&before, (int)doc->width, (int)doc->height) != 0) return 1;
+    svg_raster_draw_document(&before, doc);
+    RenderJob job;
+    memset(&job, 0, sizeof(job));
+    job.snapshot = svg_document_snapshot(doc);
+    SvgThread thread;
+    if (!job.snapshot || svg_thread_start(&thread, render_snapshot, &job) != 0) return 1;
+    start = svg_wall_seconds();
+    for (long id = 1; id <= shapes; id++) move_shape(doc, (int)id);
+    double moved = svg_wall_seconds() - start;
+    svg_thread_join(&thread);
+    svg_snapshot_release(job.snapshot);
+    int same = job.result == 0 &&
+               memcmp(before.pixels, job.raster.pixels, (size_t)before.width * before.height * 3) == 0;
+
+    printf("%ld shapes\n", shapes);
+    printf("  first snapshot %8.2f ms   later snapshots %8.2f us\n", first_seconds * 1e3, snapshot_seconds * 1e6);
+    printf("  move           %8.1f ns   with a snapshot held %8.2f us\n", plain * 1e9, shared * 1e6);
+    printf("  render on a thread %6.1f ms while %ld shapes moved in %.1f ms (%s)\n", job.seconds * 1e3, shapes,
+           moved * 1e3, same ? "same pixels as before the edits" : "PIXELS DIFFER");
+
+    svg_raster_release(&before);
+    svg_raster_release(&job.raster);
+    svg_free_document(doc);
+    return same ? 0 : 1;
+}
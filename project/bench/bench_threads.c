@@ -0,0 +1,59 @@
+// Benchmark: chunked multi-threaded parsing against the single-threaded loader
+// Build: make bench   Run: build/bench_threads.exe [shapes] [max_threads]
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/svg_parser.h"
+#include "../include/svg_platform.h"
+#include "svg_corpus.h"
+
+#define BENCH_FILE "bench_threads.svg"
+
+// Best of three runs; threads == 0 means the plain mapped loader
+static double time_load(int threads, long *shapes) {
+    double best = 1e30;
+    for (int run = 0; run < 3; run++) {
+        SvgDocument *doc = NULL;
+        double start = svg_wall_seconds();
+        int result = threads == 0 ? svg_load_from_file_mmap(BENCH_FILE, &doc)
+                                  : svg_load_from_file_parallel(BENCH_FILE, threads, &doc);
+        double elapsed = svg_wall_seconds() - start;
+        if (result != 0) return -1.0;
+        *shapes = (long)svg_document_shape_count(doc);
+        svg_free_document(doc);
+        if (elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    long shapes = argc > 1 ? atol(argv[1]) : 2000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : svg_cpu_count();
+
+    SvgCorpusConfig corpus;
+    svg_corpus_defaults(&corpus);
+    corpus.seed = 42;
+    corpus.shapes = shapes;
+    if (svg_corpus_write(BENCH_FILE, &corpus) != 0) {
+        fprintf(stderr, "Cannot write %s\n", BENCH_FILE);
+        return 1;
+    }
+
+    long loaded = 0;
+    double base = time_load(0, &loaded);
+    if (base < 0) {
+        remove(BENCH_FILE);
+        return 1;
+    }
+    printf("%ld shapes, %d CPUs\n", loaded, svg_cpu_count());
+    printf("  mmap loader     %8.1f ms\n", base * 1e3);
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        double t = time_load(threads, &loaded);
+        printf("  %2d thread(s)    %8.1f ms  speedup %.2fx  (%ld shapes)\n",
+               threads, t * 1e3, base / t, loaded);
+        if (threads < max_threads && threads * 2 > max_threads) threads = max_threads / 2;
+    }
+
+    remove(BENCH_FILE);
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Benchmark: walking every drawn shape, through the iterator and straight over the tables
+// Build: make bench   Run: build/bench_traverse.exe [shapes]
+//
+// The document is filled through svg_document_add_shape, so no parsing is timed.
+// "iterator" assembles each shape as every consumer sees it; "columns" reads
+// only the coordinate arrays, the loop a culling or bounds pass would run.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/svg_parser.h"
+#include "../include/svg_platform.h"
+
+#define BENCH_RUNS 3
+
+static SvgDocument *build_document(long shapes) {
+    SvgDocument *doc = create_svg_document(800, 600);
+    if (!doc) return NULL;
+    unsigned seed = 42;
+    for (long i = 0; i < shapes; i++) {
+        SvgShape shape;
+        memset(&shape, 0, sizeof(shape));
+        shape.id = (int)i + 1;
+        seed = seed * 1103515245u + 12345u;
+        double a = (seed >> 8) % 800, b = (seed >> 4) % 600;
+        switch (i % 3) {
+            case 0:
+                shape.type = SVG_SHAPE_CIRCLE;
+                shape.data.circle.cx = a;
+                shape.data.circle.cy = b;
+                shape.data.circle.r = 5.0;
+                break;
+            case 1:
+                shape.type = SVG_SHAPE_RECT;
+                shape.data.rect.x = a;
+                shape.data.rect.y = b;
+                shape.data.rect.width = 10.0;
+                shape.data.rect.height = 10.0;
+                break;
+            default:
+                shape.type = SVG_SHAPE_LINE;
+                shape.data.line.x1 = a;
+                shape.data.line.y1 = b;
+                shape.data.line.x2 = b;
+                shape.data.line.y2 = a;
+                break;
+        }
+        if (svg_document_add_shape(doc, &shape) == SVG_NO_SHAPE) {
+            svg_free_document(doc);
+            return NULL;
+        }
+    }
+    return doc;
+}
+
+// Largest x any shape reaches, as one consumer of every shape
+static double walk_iterator(const SvgDocument *doc) {
+    double right = 0.0;
+    SvgShapeIter it;
+    for (const SvgShape *shape = svg_shapes_first(&it, doc); shape; shape = svg_shapes_next(&it)) {
+        double x = 0.0;
+        switch (shape->type) {
+            case SVG_SHAPE_CIRCLE: x = shape->data.circle.cx + shape->data.circle.r; break;
+            case SVG_SHAPE_RECT: x = shape->data.rect.x + shape->data.rect.width; break;
+            case SVG_SHAPE_LINE: x = shape->data.line.x1 > shape->data.line.x2 ? shape->data.line.x1 : shape->data.line.x2; break;
+            default: break;
+        }
+        if (x > right) right = x;
+    }
+    return right;
+}
+
+// Same answer from the tables: branch-free loops over contiguous doubles
+static double walk_columns(const SvgDocument *doc, size_t *bytes) {
+    const SvgShapeStore *store = &doc->shapes;
+    double right = 0.0;
+    for (size_t i = 0; i < store->circles.count; i++) {
+        double x = store->circles.cx[i] + store->circles.r[i];
+        right = x > right ? x : right;
+    }
+    for (size_t i = 0; i < store->rects.count; i++) {
+        double x = store->rects.x[i] + store->rects.width[i];
+        right = x > right ? x : right;
+    }
+    for (size_t i = 0; i < store->lines.count; i++) {
+        double x = store->lines.x1[i] > store->lines.x2[i] ? store->lines.x1[i] : store->lines.x2[i];
+        right = x > right ? x : right;
+    }
+    *bytes = (store->circles.count + store->rects.count + store->lines.count) * 2 * sizeof(double);
+    return right;
+}
+
+int main(int argc, char *argv[]) {
+    long shapes = argc > 1 ? atol(argv[1]) : 10000000;
+    SvgDocument *doc = build_document(shapes);
+    if (!doc) {
+        fprintf(stderr, "Out of memory building %ld shapes\n", shapes);
+        return 1;
+    }
+
+    double best_iterator = 1e30, best_columns = 1e30, check_iterator = 0.0, check_columns = 0.0;
+    size_t bytes = 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        double start = svg_wall_seconds();
+        check_iterator = walk_iterator(doc);
+        double elapsed = svg_wall_seconds() - start;
+        if (elapsed < best_iterator) best_iterator = elapsed;
+
+        start = svg_wall_seconds();
+        check_columns = walk_columns(doc, &bytes);
+        elapsed = svg_wall_seconds() - start;
+        if (elapsed < best_columns) best_columns = elapsed;
+    }
+
+    printf("%ld shapes (max x %.0f / %.0f)\n", shapes, check_iterator, check_columns);
+    printf("  iterator  %8.1f ms  %7.1f Mshapes/s\n", best_iterator * 1e3, shapes / best_iterator / 1e6);
+    printf("  columns   %8.1f ms  %7.1f Mshapes/s  %7.1f GB/s\n", best_columns * 1e3,
+           shapes / best_columns / 1e6, bytes / best_columns / 1e9);
+
+    svg_free_document(doc);
+    return 0;
+}
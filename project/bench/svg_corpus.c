@@ -0,0 +1,91 @@
+#include "svg_corpus.h"
+#include <stdio.h>
+
+void svg_corpus_defaults(SvgCorpusConfig *config) {
+    config->seed = 1;
+    config->shapes = 1000000;
+    config->circle_weight = 1;
+    config->rect_weight = 1;
+    config->line_weight = 1;
+    config->minified = 0;
+    config->long_numbers = 0;
+}
+
+const char *svg_corpus_name(const SvgCorpusConfig *config) {
+    static const char *names[] = {"pretty/short", "pretty/long", "minified/short", "minified/long"};
+    return names[(config->minified ? 2 : 0) + (config->long_numbers ? 1 : 0)];
+}
+
+// xorshift32: same sequence on every platform for a given seed
+static unsigned next_random(unsigned *state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// One coordinate in [0, range)
+static void write_number(FILE *file, const SvgCorpusConfig *config, unsigned *state, unsigned range) {
+    unsigned whole = next_random(state) % range;
+    if (config->long_numbers) {
+        double frac = (double)next_random(state) / 4294967296.0;
+        fprintf(file, "%.17g", whole + frac);
+    } else if (next_random(state) & 1) {
+        fprintf(file, "%u.%u", whole, next_random(state) % 10);
+    } else {
+        fprintf(file, "%u", whole);
+    }
+}
+
+static void write_attr(FILE *file, const SvgCorpusConfig *config, unsigned *state,
+                       const char *name, unsigned range) {
+    fprintf(file, " %s=\"", name);
+    write_number(file, config, state, range);
+    fputc('"', file);
+}
+
+int svg_corpus_write(const char *path, const SvgCorpusConfig *config) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return -1;
+
+    const char *indent = config->minified ? "" : "  ";
+    const char *newline = config->minified ? "" : "\n";
+    int total = config->circle_weight + config->rect_weight + config->line_weight;
+    if (total <= 0) total = 1;
+    unsigned state = config->seed ? config->seed : 1;
+
+    fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>%s", newline);
+    fprintf(file, "<svg width=\"1920\" height=\"1080\" xmlns=\"http://www.w3.org/2000/svg\">%s", newline);
+    for (long i = 0; i < config->shapes; i++) {
+        int pick = (int)(next_random(&state) % (unsigned)total);
+        unsigned color = next_random(&state) & 0xFFFFFF;
+
+        fputs(indent, file);
+        if (pick < config->circle_weight) {
+            fputs("<circle", file);
+            write_attr(file, config, &state, "cx", 1920);
+            write_attr(file, config, &state, "cy", 1080);
+            write_attr(file, config, &state, "r", 50);
+            fprintf(file, " fill=\"#%06X\"/>%s", color, newline);
+        } else if (pick < config->circle_weight + config->rect_weight) {
+            fputs("<rect", file);
+            write_attr(file, config, &state, "x", 1920);
+            write_attr(file, config, &state, "y", 1080);
+            write_attr(file, config, &state, "width", 100);
+            write_attr(file, config, &state, "height", 100);
+            fprintf(file, " fill=\"#%06X\"/>%s", color, newline);
+        } else {
+            fputs("<line", file);
+            write_attr(file, config, &state, "x1", 1920);
+            write_attr(file, config, &state, "y1", 1080);
+            write_attr(file, config, &state, "x2", 1920);
+            write_attr(file, config, &state, "y2", 1080);
+            fprintf(file, " stroke=\"#%06X\"/>%s", color, newline);
+        }
+    }
+    fprintf(file, "</svg>\n");
+
+    return fclose(file);
+}
@@ -0,0 +1,22 @@
+#ifndef SVG_CORPUS_H
+#define SVG_CORPUS_H
+
+//seeded synthetic SVG generator for the parser benchmarks
+typedef struct {
+    unsigned seed;
+    long shapes;
+    int circle_weight, rect_weight, line_weight;//relative mix of element types
+    int minified;//0: one indented element per line, 1: everything on one line
+    int long_numbers;//0: short coordinates like 12.5, 1: 17 significant digits
+} SvgCorpusConfig;
+
+//defaults: 1M shapes, equal mix, pretty-printed, short numbers
+void svg_corpus_defaults(SvgCorpusConfig *config);
+
+//write the corpus to path; return:0 -> success
+int svg_corpus_write(const char *path, const SvgCorpusConfig *config);
+
+//"pretty/short", "minified/long", ...
+const char *svg_corpus_name(const SvgCorpusConfig *config);
+
+#endif
@@ -4,7 +4,7 @@ echo Building SVG Processor with GUI support...
 set CC=gcc
 set CFLAGS=-Wall -Wextra -std=c99 -O2 -Iinclude "-Igui_libs\SDL2-2.30.6\include"
 set LDFLAGS="-Lgui_libs\SDL2-2.30.6\lib\x64" -lSDL2 -lm
-set SOURCES=src/main.c src/svg_parser.c src/svg_render.c src/bmp_writer.c src/jpg_writer.c src/svg_gui.c src/svg_writer.c
+set SOURCES=src/main.c src/svg_parser.c src/svg_mmap.c src/svg_inflate.c src/svg_tokenizer.c src/svg_scan.c src/svg_number.c src/svg_color.c src/svg_style.c src/svg_transform.c src/svg_polygon.c src/svg_store.c src/svg_index.c src/svg_snapshot.c src/svg_arena.c src/svg_platform.c src/svg_raster.c src/svg_binary.c src/svg_render.c src/bmp_writer.c src/jpg_writer.c src/svg_gui.c src/svg_writer.c
 set OUTPUT=build/svg_processor.exe
 
 echo Compiling...
@@ -2,10 +2,14 @@
 #define BMP_WRITER_H
 
 #include "svg_types.h"
+#include "svg_raster.h"
 
 int export_to_bmp(const char *filename, const SvgDocument *doc);
 
 //*filename: the filename of the BMP file to be writtrn into
 //Svgdocument *doc: read the input svg file
 
+//write an already rendered framebuffer as a 24-bit BMP
+int bmp_write_raster(const char *filename, const SvgRaster *raster);
+
 #endif
@@ -2,9 +2,13 @@
 #define JPG_WRITER_H
 
 #include "svg_types.h"
+#include "svg_raster.h"
 
 // Export SVG document to JPG format
 // quality: 1-100, higher is better quality (recommended: 90)
 int export_to_jpg(const char *filename, const SvgDocument *doc, int quality);
 
+// Encode an already rendered framebuffer
+int jpg_write_raster(const char *filename, const SvgRaster *raster, int quality);
+
 #endif // JPG_WRITER_H
@@ -0,0 +1,33 @@
+#ifndef SVG_ARENA_H
+#define SVG_ARENA_H
+
+#include <stddef.h>
+
+//bump allocator: many small allocations, released all at once
+typedef struct SvgArenaBlock {
+    struct SvgArenaBlock *next;//previously filled block
+    size_t size;//usable bytes after the header
+    size_t used;
+} SvgArenaBlock;
+
+typedef struct {
+    SvgArenaBlock *head;//block currently being filled
+    size_t next_size;//size of the next block, doubles up to a cap
+    size_t blocks;//malloc calls made so far
+} SvgArena;
+
+void svg_arena_init(SvgArena *arena);
+
+//16-byte aligned, uninitialised memory; NULL when out of memory
+void *svg_arena_alloc(SvgArena *arena, size_t size);
+
+//NUL-terminated copy of a slice
+char *svg_arena_strndup(SvgArena *arena, const char *s, size_t len);
+
+//move every block of src into dst; src is left empty
+void svg_arena_adopt(SvgArena *dst, SvgArena *src);
+
+//free every block; the arena can be reused afterwards
+void svg_arena_release(SvgArena *arena);
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef SVG_BINARY_H
+#define SVG_BINARY_H
+
+#include <stdint.h>
+#include "svg_types.h"
+#include "svg_mmap.h"
+
+//.svgb: a compiled SvgDocument that can be mapped and used without parsing
+//layout (little-endian): SvgbHeader, shape_count fixed-size SvgbRecord, then
+//matrix_count SvgMatrix, point_list_count SvgbPointList, point_count x,y pairs
+//of doubles and style_count SvgbStyle; records refer to the tables by index
+#define SVGB_MAGIC "SVGB"
+#define SVGB_VERSION 4
+
+typedef struct {
+    char magic[4];//"SVGB"
+    uint32_t version;
+    uint32_t header_size;//sizeof(SvgbHeader), checked on load
+    uint32_t record_size;//sizeof(SvgbRecord), checked on load
+    uint64_t shape_count;
+    uint64_t circle_count, rect_count, line_count;
+    uint64_t polygon_count, polyline_count;
+    uint64_t matrix_count;
+    uint64_t point_list_count, point_count;
+    uint64_t style_count;
+    double width, height;//of the document
+    double min_x, min_y, max_x, max_y;//bounds of all shapes after their transforms (0 when there are none)
+} SvgbHeader;
+
+typedef struct {
+    uint8_t type;//SvgShapeType
+    uint8_t reserved;
+    uint16_t reserved1;
+    uint32_t style;//1-based index into the style table, 0 for the default style
+    uint32_t matrix;//1-based index into the matrix table, 0 for no transform
+    uint32_t points;//polygon/polyline: 1-based index into the point list table, 0 for no points
+    double v[4];//before the transform: circle: cx cy r 0, rect: x y width height, line: x1 y1 x2 y2
+} SvgbRecord;
+
+//the points of one polygon or polyline: a run of the point table
+typedef struct {
+    uint64_t first;//index of the first x,y pair
+    uint64_t count;
+} SvgbPointList;
+
+//one interned style
+typedef struct {
+    uint8_t fill_kind, stroke_kind;//SvgPaintKind
+    uint8_t fill_rule;//SvgFillRule
+    uint8_t reserved;
+    uint32_t fill_rgba, stroke_rgba;
+} SvgbStyle;
+
+//a mapped .svgb file; header and records point straight into the mapping
+typedef struct {
+    SvgMappedFile file;
+    const SvgbHeader *header;
+    const SvgbRecord *records;
+    const SvgMatrix *matrices;
+    const SvgbPointList *point_lists;
+    const double *points;
+    SvgStyle *styles;//the style table decoded on open; [0] is the default style
+} SvgbFile;
+
+//write doc as .svgb (color text that could not be decoded is not stored; each
+//<use> is stored as copies of its definition's shapes)
+int svgb_write(const char *filename, const SvgDocument *doc);
+
+//1 if the file starts with the .svgb magic
+int svgb_is_binary(const char *filename);
+
+//map and validate a .svgb file; no per-shape work is done (only the style table is decoded)
+int svgb_open(const char *filename, SvgbFile *out);
+void svgb_close(SvgbFile *file);
+
+//expand record index into a shape (next is NULL, id is index + 1)
+//the shape's transform and points point into the mapping (so it is read-only)
+//and its style into file->styles
+void svgb_record_to_shape(const SvgbFile *file, uint64_t index, SvgShape *shape);
+
+//build an editable document from a mapped file
+SvgDocument* svgb_to_document(const SvgbFile *file);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SVG_COLOR_H
+#define SVG_COLOR_H
+
+#include <stddef.h>
+#include "svg_types.h"
+
+//pack and unpack 0xRRGGBBAA colors
+#define SVG_RGBA(r, g, b, a) (((uint32_t)(r) << 24) | ((uint32_t)(g) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(a))
+#define SVG_RGBA_R(c) (((c) >> 24) & 0xFF)
+#define SVG_RGBA_G(c) (((c) >> 16) & 0xFF)
+#define SVG_RGBA_B(c) (((c) >> 8) & 0xFF)
+#define SVG_RGBA_A(c) ((c) & 0xFF)
+
+//decode a color from a slice: #RGB, #RGBA, #RRGGBB, #RRGGBBAA, rgb()/rgba()
+//with numbers or percentages, or one of the 147 SVG color keywords (any case)
+//return:0 -> success with *rgba set, -1 -> not a color
+int svg_color_parse(const char *s, size_t len, uint32_t *rgba);
+
+//decode a fill/stroke value from a slice (no NUL needed)
+//unrecognised values keep a copy of their text in arena so they can be saved unchanged
+//(no copy is made when arena is NULL)
+//return:0 -> success, -1 -> out of memory
+int svg_paint_parse(const char *s, size_t len, SvgPaint *out, SvgArena *arena);
+
+//an opaque color paint from 0xRRGGBB
+SvgPaint svg_paint_rgb(uint32_t rgb);
+
+//0xRRGGBB to draw with; fallback_rgb when the paint has no decoded color
+uint32_t svg_paint_to_rgb(const SvgPaint *paint, uint32_t fallback_rgb);
+
+//text form for printing and saving: "#RRGGBB", "none", the kept text or fallback
+const char *svg_paint_format(const SvgPaint *paint, char buf[16], const char *fallback);
+
+#endif
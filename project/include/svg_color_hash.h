@@ -0,0 +1,35 @@
+#ifndef SVG_COLOR_HASH_H
+#define SVG_COLOR_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//shared by the color decoder and tools/gen_color_table.c, which picks the
+//displacements so every keyword gets its own slot
+#define SVG_COLOR_BUCKETS 64
+#define SVG_COLOR_SLOTS 256
+#define SVG_COLOR_MAX_NAME 20//"lightgoldenrodyellow"
+
+typedef struct {
+    const char *name;//lowercase; NULL for an empty slot
+    uint32_t len;
+    uint32_t rgb;//0xRRGGBB
+} SvgNamedColor;
+
+//FNV-1a over the ASCII-lowercased name, then a final mix so the low bits
+//depend on every byte; seed 0 picks the bucket, the bucket's displacement
+//picks the slot
+static inline uint32_t svg_color_hash(const char *name, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)name[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        h = (h ^ c) * 16777619u;
+    }
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+#endif
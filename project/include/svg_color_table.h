@@ -0,0 +1,276 @@
+// Generated by tools/gen_color_table.c (make colors); do not edit
+#ifndef SVG_COLOR_TABLE_H
+#define SVG_COLOR_TABLE_H
+
+#include "svg_color_hash.h"
+
+//147 SVG color keywords
+static const uint32_t svg_color_displacement[SVG_COLOR_BUCKETS] = {
+    3, 1, 4, 1, 1, 11, 2, 2, 5, 0, 2, 2,
+    1, 0, 0, 1, 0, 6, 1, 2, 5, 2, 3, 1,
+    1, 5, 2, 1, 2, 1, 3, 1, 2, 3, 1, 4,
+    1, 5, 1, 3, 2, 2, 2, 2, 1, 2, 1, 1,
+    3, 5, 2, 3, 0, 1, 1, 1, 1, 2, 2, 2,
+    3, 0, 1, 6
+};
+
+static const SvgNamedColor svg_color_slots[SVG_COLOR_SLOTS] = {
+    {"slateblue", 9, 0x6A5ACD},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"wheat", 5, 0xF5DEB3},
+    {"mistyrose", 9, 0xFFE4E1},
+    {NULL, 0, 0},
+    {"mediumblue", 10, 0x0000CD},
+    {NULL, 0, 0},
+    {"darkgrey", 8, 0xA9A9A9},
+    {"lavender", 8, 0xE6E6FA},
+    {NULL, 0, 0},
+    {"lightgoldenrodyellow", 20, 0xFAFAD2},
+    {NULL, 0, 0},
+    {"palevioletred", 13, 0xDB7093},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"deeppink", 8, 0xFF1493},
+    {"lightpink", 9, 0xFFB6C1},
+    {"bisque", 6, 0xFFE4C4},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"black", 5, 0x000000},
+    {"blue", 4, 0x0000FF},
+    {"red", 3, 0xFF0000},
+    {"limegreen", 9, 0x32CD32},
+    {NULL, 0, 0},
+    {"dimgray", 7, 0x696969},
+    {"dodgerblue", 10, 0x1E90FF},
+    {"mintcream", 9, 0xF5FFFA},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"lightgrey", 9, 0xD3D3D3},
+    {"olivedrab", 9, 0x6B8E23},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"lightseagreen", 13, 0x20B2AA},
+    {NULL, 0, 0},
+    {"papayawhip", 10, 0xFFEFD5},
+    {NULL, 0, 0},
+    {"salmon", 6, 0xFA8072},
+    {NULL, 0, 0},
+    {"lavenderblush", 13, 0xFFF0F5},
+    {NULL, 0, 0},
+    {"brown", 5, 0xA52A2A},
+    {"dimgrey", 7, 0x696969},
+    {"lightskyblue", 12, 0x87CEFA},
+    {"linen", 5, 0xFAF0E6},
+    {NULL, 0, 0},
+    {"mediumorchid", 12, 0xBA55D3},
+    {"aqua", 4, 0x00FFFF},
+    {NULL, 0, 0},
+    {"indigo", 6, 0x4B0082},
+    {"thistle", 7, 0xD8BFD8},
+    {"lightslategray", 14, 0x778899},
+    {"whitesmoke", 10, 0xF5F5F5},
+    {"orangered", 9, 0xFF4500},
+    {"seashell", 8, 0xFFF5EE},
+    {"purple", 6, 0x800080},
+    {"honeydew", 8, 0xF0FFF0},
+    {NULL, 0, 0},
+    {"turquoise", 9, 0x40E0D0},
+    {"midnightblue", 12, 0x191970},
+    {NULL, 0, 0},
+    {"tomato", 6, 0xFF6347},
+    {NULL, 0, 0},
+    {"darksalmon", 10, 0xE9967A},
+    {"teal", 4, 0x008080},
+    {NULL, 0, 0},
+    {"chocolate", 9, 0xD2691E},
+    {"magenta", 7, 0xFF00FF},
+    {"darkslateblue", 13, 0x483D8B},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"darkolivegreen", 14, 0x556B2F},
+    {"silver", 6, 0xC0C0C0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"fuchsia", 7, 0xFF00FF},
+    {NULL, 0, 0},
+    {"steelblue", 9, 0x4682B4},
+    {"darkorange", 10, 0xFF8C00},
+    {"yellow", 6, 0xFFFF00},
+    {"maroon", 6, 0x800000},
+    {NULL, 0, 0},
+    {"darkblue", 8, 0x00008B},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"lightgray", 9, 0xD3D3D3},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"darkslategrey", 13, 0x2F4F4F},
+    {"lightcyan", 9, 0xE0FFFF},
+    {"palegoldenrod", 13, 0xEEE8AA},
+    {"sienna", 6, 0xA0522D},
+    {NULL, 0, 0},
+    {"plum", 4, 0xDDA0DD},
+    {"moccasin", 8, 0xFFE4B5},
+    {"lightblue", 9, 0xADD8E6},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"darkgreen", 9, 0x006400},
+    {"darkslategray", 13, 0x2F4F4F},
+    {"darkkhaki", 9, 0xBDB76B},
+    {"darkgoldenrod", 13, 0xB8860B},
+    {NULL, 0, 0},
+    {"lime", 4, 0x00FF00},
+    {"navy", 4, 0x000080},
+    {NULL, 0, 0},
+    {"slategray", 9, 0x708090},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"mediumturquoise", 15, 0x48D1CC},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"green", 5, 0x008000},
+    {"lightgreen", 10, 0x90EE90},
+    {NULL, 0, 0},
+    {"gold", 4, 0xFFD700},
+    {NULL, 0, 0},
+    {"blueviolet", 10, 0x8A2BE2},
+    {"beige", 5, 0xF5F5DC},
+    {NULL, 0, 0},
+    {"skyblue", 7, 0x87CEEB},
+    {"rosybrown", 9, 0xBC8F8F},
+    {"coral", 5, 0xFF7F50},
+    {"gray", 4, 0x808080},
+    {NULL, 0, 0},
+    {"lightcoral", 10, 0xF08080},
+    {"ghostwhite", 10, 0xF8F8FF},
+    {NULL, 0, 0},
+    {"lightsteelblue", 14, 0xB0C4DE},
+    {"orange", 6, 0xFFA500},
+    {"orchid", 6, 0xDA70D6},
+    {"hotpink", 7, 0xFF69B4},
+    {"darkorchid", 10, 0x9932CC},
+    {"darkcyan", 8, 0x008B8B},
+    {"oldlace", 7, 0xFDF5E6},
+    {NULL, 0, 0},
+    {"peachpuff", 9, 0xFFDAB9},
+    {"olive", 5, 0x808000},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"mediumpurple", 12, 0x9370DB},
+    {NULL, 0, 0},
+    {"aliceblue", 9, 0xF0F8FF},
+    {NULL, 0, 0},
+    {"cadetblue", 9, 0x5F9EA0},
+    {"peru", 4, 0xCD853F},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"violet", 6, 0xEE82EE},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"antiquewhite", 12, 0xFAEBD7},
+    {"mediumvioletred", 15, 0xC71585},
+    {"darkturquoise", 13, 0x00CED1},
+    {"chartreuse", 10, 0x7FFF00},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"darkmagenta", 11, 0x8B008B},
+    {"floralwhite", 11, 0xFFFAF0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"mediumspringgreen", 17, 0x00FA9A},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"lightslategrey", 14, 0x778899},
+    {"sandybrown", 10, 0xF4A460},
+    {NULL, 0, 0},
+    {"greenyellow", 11, 0xADFF2F},
+    {"darkseagreen", 12, 0x8FBC8F},
+    {NULL, 0, 0},
+    {"blanchedalmond", 14, 0xFFEBCD},
+    {NULL, 0, 0},
+    {"azure", 5, 0xF0FFFF},
+    {"grey", 4, 0x808080},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"palegreen", 9, 0x98FB98},
+    {NULL, 0, 0},
+    {"white", 5, 0xFFFFFF},
+    {"saddlebrown", 11, 0x8B4513},
+    {"springgreen", 11, 0x00FF7F},
+    {NULL, 0, 0},
+    {"mediumseagreen", 14, 0x3CB371},
+    {"lawngreen", 9, 0x7CFC00},
+    {NULL, 0, 0},
+    {"royalblue", 9, 0x4169E1},
+    {"mediumslateblue", 15, 0x7B68EE},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"goldenrod", 9, 0xDAA520},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"snow", 4, 0xFFFAFA},
+    {"aquamarine", 10, 0x7FFFD4},
+    {"cornsilk", 8, 0xFFF8DC},
+    {NULL, 0, 0},
+    {"yellowgreen", 11, 0x9ACD32},
+    {NULL, 0, 0},
+    {"seagreen", 8, 0x2E8B57},
+    {"lightyellow", 11, 0xFFFFE0},
+    {"deepskyblue", 11, 0x00BFFF},
+    {"powderblue", 10, 0xB0E0E6},
+    {"cyan", 4, 0x00FFFF},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"paleturquoise", 13, 0xAFEEEE},
+    {"slategrey", 9, 0x708090},
+    {"firebrick", 9, 0xB22222},
+    {"ivory", 5, 0xFFFFF0},
+    {"burlywood", 9, 0xDEB887},
+    {"darkviolet", 10, 0x9400D3},
+    {"darkgray", 8, 0xA9A9A9},
+    {"lightsalmon", 11, 0xFFA07A},
+    {NULL, 0, 0},
+    {"navajowhite", 11, 0xFFDEAD},
+    {"indianred", 9, 0xCD5C5C},
+    {"lemonchiffon", 12, 0xFFFACD},
+    {NULL, 0, 0},
+    {"khaki", 5, 0xF0E68C},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+    {"crimson", 7, 0xDC143C},
+    {"mediumaquamarine", 16, 0x66CDAA},
+    {"pink", 4, 0xFFC0CB},
+    {"forestgreen", 11, 0x228B22},
+    {NULL, 0, 0},
+    {"gainsboro", 9, 0xDCDCDC},
+    {"darkred", 7, 0x8B0000},
+    {"tan", 3, 0xD2B48C},
+    {"cornflowerblue", 14, 0x6495ED},
+    {NULL, 0, 0},
+    {NULL, 0, 0},
+};
+
+#endif
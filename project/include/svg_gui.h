@@ -4,6 +4,7 @@
 
 #include <SDL.h>
 #include "svg_types.h"
+#include "svg_platform.h"
 
 // GUI constants
 #define WINDOW_WIDTH 1000
@@ -13,15 +14,27 @@
 #define TOOLBAR_WIDTH 200
 #define TOOLBAR_HEIGHT 600
 
+// A save or export running on its own thread from a snapshot, so editing goes on
+typedef struct {
+    SvgThread thread;//joined before the next job starts
+    const SvgDocument* snapshot;//released by the thread when it is done
+    volatile long holding;//1 until the thread has released the snapshot (atomic)
+    char filename[256];
+    int bmp;//export a BMP instead of saving the SVG
+} GUIJob;
+
 // GUI state
 typedef struct {
     SDL_Window* window;
     SDL_Renderer* renderer;
     SDL_Texture* canvas_texture;
     SvgDocument* document;
-    int selected_shape;
+    SvgShapeHandle selected_shape;//SVG_NO_SHAPE when nothing is selected
+    SvgShapeQuery visible;//shapes on the canvas, found again every frame
     int mouse_x, mouse_y;
     int dragging;
+    int points_copied;//the dragged polygon's points were copied since the job's snapshot
+    GUIJob job;
     int pan_x, pan_y;
     float zoom;
     int show_toolbar;
@@ -32,9 +45,10 @@ int gui_init(GUIState* state);
 void gui_cleanup(GUIState* state);
 void gui_render(GUIState* state);
 void gui_handle_events(GUIState* state, int* running);
-void gui_draw_shape(SDL_Renderer* renderer, SvgShape* shape, int offset_x, int offset_y, float zoom);
+void gui_draw_shape(SDL_Renderer* renderer, const SvgShape* shape, int offset_x, int offset_y, float zoom);
 void gui_draw_toolbar(GUIState* state);
 void gui_add_shape_at_mouse(GUIState* state, SvgShapeType type);
+void gui_start_job(GUIState* state, int bmp);
 void run_gui(SvgDocument* doc);
 
 #endif // SVG_GUI_H
@@ -0,0 +1,44 @@
+#ifndef SVG_INDEX_H
+#define SVG_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "svg_types.h"
+
+//uniform grid over the bounds of a store's shapes (svg_store.h), so a region
+//or a point only visits the shapes near it. each cell lists the draw positions
+//of the shapes whose bounds reach it, so compacting the store means building
+//it again; a shape that would reach more than SVG_INDEX_MAX_CELLS cells, or
+//has NaN bounds, goes on one list every query reads. the grid is sized when
+//it is built; shapes further out are kept in its border cells.
+//bench/bench_index.c compares it with a packed R-tree
+typedef struct SvgShapeIndex SvgShapeIndex;
+
+#define SVG_INDEX_MAX_CELLS 64
+
+//grid over every shape of store that is neither removed nor waiting to be
+//decoded; NULL when out of memory
+SvgShapeIndex *svg_index_build(const SvgShapeStore *store);
+
+void svg_index_free(SvgShapeIndex *index);
+
+//add the shape at position, with the bounds it has now
+//return:0 -> success, -1 -> out of memory, or the store has grown well past
+//what the grid was sized for: free it and build again
+int svg_index_insert(SvgShapeIndex *index, size_t position, const double box[4]);
+
+//take the shape at position out; box must be the bounds it was added with
+void svg_index_remove(SvgShapeIndex *index, size_t position, const double box[4]);
+
+//handles of the shapes whose bounds meet rect (min_x, min_y, max_x, max_y), in
+//draw order, into query (its array is reused). return:0 -> success, -1 -> out of memory
+int svg_index_query(const SvgShapeIndex *index, const SvgShapeStore *store, const double rect[4],
+                    SvgShapeQuery *query);
+
+//topmost shape drawn over (x, y): inside a circle, rect or polygon, within
+//tolerance of a line, or inside the box of a polyline or <use> in their own
+//coordinates. SVG_NO_SHAPE when there is none
+SvgShapeHandle svg_index_shape_at(const SvgShapeIndex *index, const SvgShapeStore *store,
+                                  double x, double y, double tolerance);
+
+#endif
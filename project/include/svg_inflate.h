@@ -0,0 +1,58 @@
+#ifndef SVG_INFLATE_H
+#define SVG_INFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+//first two bytes of every gzip member
+#define SVG_GZIP_ID1 0x1F
+#define SVG_GZIP_ID2 0x8B
+
+//codes up to this many bits are decoded with one table lookup
+#define SVG_INFLATE_FAST_BITS 10
+
+//canonical Huffman code for one deflate alphabet
+typedef struct {
+    short count[16];//number of codes of each length
+    short symbol[288];//symbols ordered by code
+    uint16_t fast[1 << SVG_INFLATE_FAST_BITS];//symbol << 4 | length, 0 when the code is longer
+} SvgHuffman;
+
+//streaming gzip decoder: output is produced in caller-sized pieces and only
+//the last 32 KiB of it (the deflate back-reference range) is kept
+typedef struct {
+    FILE *file;
+    unsigned char *input;//read buffer
+    size_t input_pos, input_len;
+    uint32_t bits;//bit buffer, least significant bit first
+    int bit_count;
+    size_t overrun;//zero bytes fed in after the end of the file
+    unsigned char *history;//ring of recent output
+    uint64_t pos;//bytes produced by the current member
+    int state;
+    int final;//current block is the last one of the member
+    unsigned stored_left;//bytes left in a stored block
+    unsigned copy_len, copy_dist;//match still being copied
+    uint32_t crc, size;//running CRC-32 and length of the member
+    uint32_t crc_table[256];
+    SvgHuffman lengths, distances;
+} SvgInflate;
+
+//1 if the bytes start with the gzip magic
+int svg_inflate_is_gzip(const unsigned char *data, size_t size);
+
+//1 if the file starts with the gzip magic
+int svg_inflate_is_gzip_file(const char *filename);
+
+//start decoding file; prefix holds bytes already read from it (e.g. the magic)
+//return:0 -> success
+int svg_inflate_init(SvgInflate *z, FILE *file, const unsigned char *prefix, size_t prefix_len);
+
+//decompress up to cap bytes into out
+//return the number of bytes produced, 0 at the end of the data, -1 on corrupt or truncated input
+long svg_inflate_read(SvgInflate *z, char *out, size_t cap);
+
+void svg_inflate_release(SvgInflate *z);
+
+#endif
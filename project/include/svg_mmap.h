@@ -0,0 +1,20 @@
+#ifndef SVG_MMAP_H
+#define SVG_MMAP_H
+
+#include <stddef.h>
+
+//a read-only view of a whole file mapped into memory
+typedef struct {
+    const char *data;//first byte of the file (NULL for an empty file)
+    size_t size;//length in bytes
+    void *mapping;//platform handle of the mapping
+    void *file;//platform handle of the opened file
+} SvgMappedFile;
+
+//map the file read-only; return:0 -> success
+int svg_map_file(const char *filename, SvgMappedFile *out);
+
+//release the view and close the file
+void svg_unmap_file(SvgMappedFile *mapped);
+
+#endif
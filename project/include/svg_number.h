@@ -0,0 +1,15 @@
+#ifndef SVG_NUMBER_H
+#define SVG_NUMBER_H
+
+#include <stddef.h>
+
+//parse one SVG number from [s, end) without needing a NUL terminator
+//grammar: [+-]? (digits [. digits?] | . digits) ([eE] [+-]? digits)?
+//the result is correctly rounded and does not depend on the C locale
+//return a pointer just past the number, or s when no number starts there
+const char *svg_parse_number(const char *s, const char *end, double *out);
+
+//attribute helper: skip leading whitespace and parse; 0.0 when there is no number
+double svg_number_from_slice(const char *s, size_t len);
+
+#endif
@@ -1,16 +1,190 @@
 #ifndef SVG_PARSER_H
 #define SVG_PARSER_H
 
+#include <stddef.h>
 #include "svg_types.h"
 
+//input name that reads standard input instead of a file, for shell pipelines
+//every loader accepts it; input is parsed as it arrives through the stream window
+#define SVG_STDIN_NAME "-"
+
 //read the svg file ; load the shapes and docement
+//gzip-compressed files (.svgz) are detected and inflated while parsing
+//a single tag longer than SVG_TOKENIZER_MAX_TAG fails the load
 //return:0 -> success
 int svg_load_from_file(const char *filename, SvgDocument **doc_out);
 
+//same result as svg_load_from_file, but maps the file and scans it in place
+//attribute values are decoded straight from the mapped bytes without copies
+int svg_load_from_file_mmap(const char *filename, SvgDocument **doc_out);
+
+//parse an svg held in memory; data does not need to be NUL-terminated
+int svg_load_from_memory(const char *data, size_t size, SvgDocument **doc_out);
+
+//receives shapes one at a time from svg_stream_file instead of a document
+typedef struct {
+    //size of each <svg> element, reported before the shapes that follow it; may be NULL
+    int (*size)(void *ctx, double width, double height);
+    //the shape is only valid during the call; return non-zero to stop parsing
+    int (*shape)(void *ctx, const SvgShape *shape);
+    void *ctx;
+} SvgShapeSink;
+
+//parse the file and hand each shape to sink as soon as it is decoded
+//nothing is kept, so memory does not grow with the number of shapes
+//colors that cannot be decoded are passed as SVG_PAINT_UNSET without their text
+int svg_stream_file(const char *filename, const SvgShapeSink *sink);
+
+//upper bound on parser threads, and the smallest slice worth a thread
+#define SVG_MAX_PARSE_THREADS 64
+#define SVG_MIN_PARSE_CHUNK (256 * 1024)
+
+//map the file and parse slices of it on several threads (threads < 1: one per CPU)
+//the document is identical to svg_load_from_file, ids included
+int svg_load_from_file_parallel(const char *filename, int threads, SvgDocument **doc_out);
+int svg_load_from_memory_parallel(const char *data, size_t size, int threads, SvgDocument **doc_out);
+
+//map the file and only tokenize it: drawn shapes other than <use> keep a pointer to
+//their tag and are decoded when first read (svg_shapes_first, svg_document_get_shape),
+//so a summary costs one tokenizer pass. the mapping is released with the document
+//(standard input and gzip input are loaded fully instead)
+int svg_load_from_file_lazy(const char *filename, SvgDocument **doc_out);
+
+//decode every shape still pending
+int svg_document_decode(SvgDocument *doc);
+
+//walk the drawn shapes in order. each one is assembled from the document's
+//tables into it->shape, decoding a lazy shape first, and stays valid until the
+//next call. NULL after the last shape, or when a shape could not be decoded
+//(out of memory), which also sets failed. decoding is not safe to run for one
+//document from several threads at once; a snapshot has nothing to decode
+//  SvgShapeIter it;
+//  for (const SvgShape *s = svg_shapes_first(&it, doc); s; s = svg_shapes_next(&it))
+typedef struct {
+    const SvgDocument *doc;
+    size_t position;//in the document's tables
+    SvgShapeHandle handle;//of shape; SVG_NO_SHAPE in a snapshot
+    const double *bounds;//of shape, as kept by the document (svg_shape_bounds)
+    int failed;
+    SvgShape shape;
+} SvgShapeIter;
+const SvgShape* svg_shapes_first(SvgShapeIter *it, const SvgDocument *doc);
+const SvgShape* svg_shapes_next(SvgShapeIter *it);
+
+//point it at the shape a handle names, as the walk above would reach it: shape
+//and bounds from one lookup, for visiting the handles of a query. not for a
+//snapshot. NULL when the shape was removed, or out of memory (failed is set)
+const SvgShape* svg_shapes_at(SvgShapeIter *it, const SvgDocument *doc, SvgShapeHandle handle);
+
+//number of drawn shapes
+size_t svg_document_shape_count(const SvgDocument *doc);
+
+//number of drawn shapes of one type; needs no decoding
+size_t svg_document_type_count(const SvgDocument *doc, SvgShapeType type);
+
+//the shape with this id, in constant time; SVG_NO_SHAPE when there is none.
+//loading numbers shapes 1..n in draw order; svg_document_add_shape numbers new ones
+SvgShapeHandle svg_document_find_shape(const SvgDocument *doc, int id);
+
+//copy of the shape a handle names, decoded if needed
+//return:0 -> success, -1 -> the shape was removed, or out of memory
+int svg_document_get_shape(const SvgDocument *doc, SvgShapeHandle handle, SvgShape *out);
+
+//bounds of the shape a handle names (min_x, min_y, max_x, max_y after its
+//transform), kept since it was loaded or last set; decodes a lazy shape
+//return:0 -> success, -1 -> the shape was removed, or out of memory
+int svg_document_shape_bounds(const SvgDocument *doc, SvgShapeHandle handle, double out[4]);
+
+//bounds of every drawn shape together. return:0 -> success, -1 -> no shapes,
+//or a lazy document with shapes not decoded yet (see svg_document_decode)
+int svg_document_bounds(const SvgDocument *doc, double out[4]);
+
+//the shapes whose bounds meet rect (min_x, min_y, max_x, max_y), as handles in
+//draw order, through a grid over the bounds: only shapes near rect are visited.
+//the first query builds the grid (decoding a lazy document); edits keep it up
+//to date. query starts zeroed and is reused; return:0 -> success, -1 -> out of memory
+int svg_document_query_rect(const SvgDocument *doc, const double rect[4], SvgShapeQuery *query);
+
+//the topmost shape drawn over (x, y), or SVG_NO_SHAPE: inside a circle, rect or
+//polygon, within tolerance of a line, or inside a polyline's or <use>'s own box
+SvgShapeHandle svg_document_shape_at(const SvgDocument *doc, double x, double y, double tolerance);
+
+//free the handles a query kept
+void svg_shape_query_release(SvgShapeQuery *query);
+
+//draw shape last. style NULL means svg_default_style; id 0 gives it the next
+//unused id. return the new shape's handle, or SVG_NO_SHAPE when out of memory
+SvgShapeHandle svg_document_add_shape(SvgDocument *doc, const SvgShape *shape);
+
+//store an edited copy back (the type cannot change)
+//return:0 -> success, -1 -> removed, type differs or out of memory
+int svg_document_set_shape(SvgDocument *doc, SvgShapeHandle handle, const SvgShape *shape);
+
+//remove a shape in constant time (amortized); its handle stops matching
+//return:0 -> success, -1 -> already removed
+int svg_document_remove_shape(SvgDocument *doc, SvgShapeHandle handle);
+
+//read-only copy of the document as it is now, for exporting or saving on
+//another thread while doc goes on being edited, with no lock held. shapes are
+//shared in chunks (svg_snapshot.h): the first snapshot copies them once (and
+//decodes a lazy document), after which a snapshot costs O(1) and an edit
+//copies only the chunk it touches. a snapshot iterates, counts and bounds its
+//shapes and finds definitions like any document, so the exporters and
+//svg_save_to_file take it as it is; its handles, region queries and picking
+//find nothing. doc must not be reloaded, freed or given definitions until its
+//snapshots are released, and a polygon's points must be replaced (see
+//svg_document_new_points), not written in place. NULL when out of memory
+const SvgDocument* svg_document_snapshot(SvgDocument *doc);
+
+//free a snapshot; safe on any thread, while doc is being edited
+void svg_snapshot_release(const SvgDocument *snapshot);
+
+//what svg_reload_from_file did; ids are those of the updated document
+typedef struct {
+    int *changed;//shapes that were decoded anew, ascending
+    int changed_count;
+    int *removed;//ids the dropped shapes had before the reload, ascending
+    int removed_count;
+    int full;//nothing could be kept: every shape is new
+} SvgChanges;
+
+//bring doc up to date with filename. drawn shapes whose tag and enclosing
+//groups hash the same as in the previous load are kept as they are (copied
+//over, possibly renumbered) and only the others are decoded. a document
+//that was not produced by this function, was edited since, or whose
+//definitions, <style> or <svg> size changed, is reloaded in full. to load a
+//file the first time, pass an empty create_svg_document. standard input and
+//gzip input are always loaded in full. handles from before a successful reload
+//no longer match. on failure doc is left unchanged
+int svg_reload_from_file(SvgDocument *doc, const char *filename, SvgChanges *changes);
+void svg_changes_release(SvgChanges *changes);
+
 //dynamically create an empty svg file, return a pointer that points to the new file
 SvgDocument* create_svg_document(float width, float height);
 
-//free all the svgshapes in every data table
+//get a zeroed shape owned by doc for a definition's content; the caller links
+//it into the definition's shapes
+SvgShape* svg_document_new_shape(SvgDocument *doc, SvgShapeType type);
+
+//array for count points (x0 y0 x1 y1 ...) of a polygon or polyline, owned by
+//doc, for an edit that must not write into points a snapshot still reads
+//return NULL when out of memory
+double* svg_document_new_points(SvgDocument *doc, int count);
+
+//add an empty definition with the given id (copied); for a duplicate id lookups
+//keep finding the first one. the loaders check the uses of the definitions they
+//read against SVG_MAX_USE_DEPTH; content linked in by hand is not checked, so it
+//must not use itself. return NULL when out of memory
+SvgDefinition* svg_document_add_definition(SvgDocument *doc, const char *id, size_t id_len);
+
+//definition with the given id, or NULL
+const SvgDefinition* svg_document_find_definition(const SvgDocument *doc, const char *id, size_t id_len);
+
+//shared record equal to style (svg_default_style when nothing is set); a new
+//look is copied into doc with the next index. return NULL when out of memory
+const SvgStyle* svg_document_intern_style(SvgDocument *doc, const SvgStyle *style);
+
+//free the whole document, including all its shapes, in a few block frees
 void svg_free_document(SvgDocument *doc);
 void free_svg_document(SvgDocument *doc); // Alias for compatibility
 
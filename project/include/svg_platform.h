@@ -0,0 +1,36 @@
+#ifndef SVG_PLATFORM_H
+#define SVG_PLATFORM_H
+
+#include <stdio.h>
+
+//thin wrappers over Win32 / POSIX threads, clocks and standard streams
+
+typedef void (*SvgThreadFunc)(void *arg);
+
+typedef struct {
+    void *handle;
+    SvgThreadFunc func;
+    void *arg;
+} SvgThread;
+
+//start fn(arg) on a new thread; thread must stay valid until joined
+//return:0 -> success
+int svg_thread_start(SvgThread *thread, SvgThreadFunc fn, void *arg);
+
+//wait for the thread to finish
+void svg_thread_join(SvgThread *thread);
+
+//add delta to *value as one atomic step and return the result, for reference
+//counts changed from several threads; a delta of 0 reads the current value
+long svg_atomic_add(volatile long *value, long delta);
+
+//number of logical processors (at least 1)
+int svg_cpu_count(void);
+
+//monotonic wall-clock time in seconds, for measuring elapsed time
+double svg_wall_seconds(void);
+
+//stdin switched to binary mode, so Windows neither rewrites CR LF nor stops at ^Z
+FILE *svg_stdin_binary(void);
+
+#endif
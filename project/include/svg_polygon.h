@@ -0,0 +1,27 @@
+#ifndef SVG_POLYGON_H
+#define SVG_POLYGON_H
+
+#include <stddef.h>
+#include "svg_types.h"
+
+//number of complete x,y pairs in a points="..." value (a trailing odd number is dropped)
+int svg_points_count(const char *s, size_t len);
+
+//parse up to count pairs into out (2 * count doubles); return the pairs read
+int svg_points_parse(const char *s, size_t len, double *out, int count);
+
+//called once per run of filled pixels: x0..x1 inclusive on row y
+typedef void (*SvgSpanFunc)(void *ctx, int y, int x0, int x1);
+
+//scanline fill of the outline through count points (closed back to the first),
+//placed by m (NULL for identity). a pixel (x, y) is inside when its position is,
+//by the nonzero rule or, with evenodd, the even-odd rule. only pixels within
+//clip (left, top, right, bottom, inclusive) are reported, each row in one pass
+//over its edges. return:0 -> success, -1 -> out of memory
+int svg_polygon_fill(const double *points, int count, const SvgMatrix *m, int evenodd,
+                     const int clip[4], SvgSpanFunc span, void *ctx);
+
+//1 when (x, y) is inside the outline, by the same rules
+int svg_polygon_contains(const double *points, int count, int evenodd, double x, double y);
+
+#endif
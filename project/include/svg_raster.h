@@ -0,0 +1,37 @@
+#ifndef SVG_RASTER_H
+#define SVG_RASTER_H
+
+#include <stdint.h>
+#include "svg_types.h"
+
+struct SvgSprite;
+
+//RGB framebuffer shared by the BMP and JPG exporters (top row first, 3 bytes per pixel)
+typedef struct {
+    uint8_t *pixels;
+    int width, height;
+    struct SvgSprite *sprites;//per-definition pixel runs, indexed by SvgDefinition.index
+    int sprite_count;
+} SvgRaster;
+
+//allocate a white canvas; return:0 -> success
+int svg_raster_init(SvgRaster *raster, int width, int height);
+
+//paint one shape over what is already there (painter's order); a <use> whose
+//placement is a whole-pixel offset copies runs rendered once per definition
+void svg_raster_draw_shape(SvgRaster *raster, const SvgShape *shape);
+
+//paint every shape of the document in order
+void svg_raster_draw_document(SvgRaster *raster, const SvgDocument *doc);
+
+//paint the shapes that reach the canvas-sized region of the document whose
+//top-left corner is (x, y), so that corner lands on pixel (0, 0). only shapes
+//near the region are visited (svg_document_query_rect), which pays off for a
+//small crop of a large document and for repeated views of one
+//return:0 -> success, -1 -> out of memory
+int svg_raster_draw_region(SvgRaster *raster, const SvgDocument *doc, int x, int y);
+
+//free the canvas and the cached definitions
+void svg_raster_release(SvgRaster *raster);
+
+#endif
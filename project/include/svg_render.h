@@ -3,7 +3,8 @@
 
 #include "svg_types.h"
 
-//print out the information of the svg document(summarize)
+//print out the information of the svg document(summarize): size, shape count and,
+//once every shape is decoded, the bounds of them all
 void svg_print_summary(const SvgDocument *doc);
 
 //print out the information of every shapes in detail(accord with the project requirement)
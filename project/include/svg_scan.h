@@ -0,0 +1,32 @@
+#ifndef SVG_SCAN_H
+#define SVG_SCAN_H
+
+#include <stddef.h>
+
+//element names the parser knows about, classified from their first bytes
+typedef enum {
+    SVG_ELEMENT_OTHER,
+    SVG_ELEMENT_SVG,
+    SVG_ELEMENT_CIRCLE,
+    SVG_ELEMENT_RECT,
+    SVG_ELEMENT_LINE,
+    SVG_ELEMENT_POLYGON,
+    SVG_ELEMENT_POLYLINE,
+    SVG_ELEMENT_GROUP,
+    SVG_ELEMENT_DEFS,
+    SVG_ELEMENT_SYMBOL,
+    SVG_ELEMENT_USE,
+    SVG_ELEMENT_STYLE
+} SvgElementKind;
+
+//first structural byte in [p, end): one of < > / = " ' or whitespace (<= 0x20)
+//return end when there is none; uses AVX2 or SSE2 when the CPU has them
+const char *svg_scan_structural(const char *p, const char *end);
+
+//closing '>' of a tag, skipping over quoted values; return end when unfinished
+const char *svg_scan_tag_end(const char *p, const char *end);
+
+//classify the element name starting at name; *name_end is set past the name
+SvgElementKind svg_classify_element(const char *name, const char *end, const char **name_end);
+
+#endif
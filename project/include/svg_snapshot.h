@@ -0,0 +1,47 @@
+#ifndef SVG_SNAPSHOT_H
+#define SVG_SNAPSHOT_H
+
+#include <stddef.h>
+#include "svg_types.h"
+
+//the shapes of a store (svg_store.h) at one moment, for readers on other
+//threads. positions are cut into chunks of SVG_VERSION_CHUNK shapes that
+//versions share: sharing a version costs O(1), and the first write after that
+//copies the list of chunks and then only the chunk it lands in. reference
+//counts are atomic, so a version can be released on any thread; it is written
+//from the store's thread only, and only while no one else holds it
+typedef struct SvgShapeVersion SvgShapeVersion;
+
+#define SVG_VERSION_CHUNK 256
+
+//every position of store, in order. shapes removed or still waiting to be
+//decoded are kept as gaps. NULL when out of memory
+SvgShapeVersion *svg_version_build(const SvgShapeStore *store);
+
+//another reference to version: from now on writes copy before they change it
+SvgShapeVersion *svg_version_share(SvgShapeVersion *version);
+
+//drop a reference; the last one frees the chunks no other version holds
+void svg_version_release(SvgShapeVersion *version);
+
+//store shape (next is ignored) and its bounds at position, at most one past
+//the last; a shape whose style is NULL is a gap. *version is swapped for a
+//copy of its own when it is shared. return:0 -> success, -1 -> out of memory
+int svg_version_write(SvgShapeVersion **version, size_t position, const SvgShape *shape, const double box[4]);
+
+//make position a gap. return:0 -> success, -1 -> out of memory
+int svg_version_remove(SvgShapeVersion **version, size_t position);
+
+//positions, gaps included
+size_t svg_version_count(const SvgShapeVersion *version);
+
+//positions that are not gaps
+size_t svg_version_live(const SvgShapeVersion *version);
+
+//the shape at position, with its bounds in *bounds; NULL at a gap
+const SvgShape *svg_version_shape(const SvgShapeVersion *version, size_t position, const double **bounds);
+
+//union of the bounds of every shape. return:0 -> out set, -1 -> no bounds
+int svg_version_extent(const SvgShapeVersion *version, double out[4]);
+
+#endif
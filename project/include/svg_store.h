@@ -0,0 +1,88 @@
+#ifndef SVG_STORE_H
+#define SVG_STORE_H
+
+#include <stddef.h>
+#include "svg_types.h"
+
+//tables of a document's drawn shapes: geometry per type, one array per field,
+//and the draw order as (type, row) pairs. positions are 0-based draw order and
+//rows of a type follow it. a removed shape leaves its position behind, marked
+//SVG_STORE_REMOVED, until svg_store_compact closes the gaps; handles and ids
+//find shapes through slots, which compaction keeps up to date. every shape's
+//bounds (svg_shape_bounds) are kept in bounds[position] as it is appended or set.
+//nothing here decodes lazy shapes (see svg_document_get_shape for that)
+
+//SvgDrawItem.type of a removed position
+#define SVG_STORE_REMOVED UINT32_MAX
+
+void svg_store_init(SvgShapeStore *store);
+
+//free every table; the store is empty afterwards
+void svg_store_release(SvgShapeStore *store);
+
+//room for extra more shapes of any type without growing the draw order
+//return:0 -> success, -1 -> out of memory
+int svg_store_reserve(SvgShapeStore *store, size_t extra);
+
+//copy shape to the end of the draw order (next is ignored) under a new handle;
+//an id above 0 is indexed for svg_store_find_id. return:0 -> success, -1 -> out of memory
+int svg_store_append(SvgShapeStore *store, const SvgShape *shape);
+
+//lazy documents: a shape that only knows where its tag is; its geometry is
+//zero and its style NULL until svg_store_set fills it in
+int svg_store_append_pending(SvgShapeStore *store, SvgShapeType type, int id,
+                             const SvgMatrix *transform, const SvgSource *source);
+
+//append every shape of src, in order, under new handles; ids (which may have
+//been renumbered in src->ids) and styles are copied as they are. src must not
+//have removed positions
+int svg_store_append_store(SvgShapeStore *dst, const SvgShapeStore *src);
+
+//shapes that are not removed
+size_t svg_store_live(const SvgShapeStore *store);
+
+//handle of the shape at position
+SvgShapeHandle svg_store_handle(const SvgShapeStore *store, size_t position);
+
+//position of the shape a handle names. return:0 -> found, -1 -> removed or never valid
+int svg_store_position(const SvgShapeStore *store, SvgShapeHandle handle, size_t *position);
+
+//position of the shape with this id (the last one given it). return:0 -> found, -1 -> none
+int svg_store_find_id(const SvgShapeStore *store, int id, size_t *position);
+
+//assemble the shape at position into out (next is NULL)
+void svg_store_get(const SvgShapeStore *store, size_t position, SvgShape *out);
+
+//overwrite the shape at position and its bounds; shape must have the same type.
+//call it again after a <use> gains its definition. return:0 -> success, -1 -> out of memory indexing a new id
+int svg_store_set(SvgShapeStore *store, size_t position, const SvgShape *shape);
+
+//remove the shape at position in constant time, leaving a gap; gaps are
+//compacted once they outnumber the shapes, so removal stays O(1) amortized
+void svg_store_remove(SvgShapeStore *store, size_t position);
+
+//close every gap: later shapes move down to keep the draw order dense
+void svg_store_compact(SvgShapeStore *store);
+
+//union of the bounds of every shape not removed, waiting lazy shapes aside;
+//recomputed here only after an edge shape was edited or removed
+//return:0 -> out set, -1 -> no bounds (out is empty: min above max)
+int svg_store_extent(SvgShapeStore *store, double out[4]);
+
+//the grid over the bounds (svg_index.h), built now if there is none; it then
+//follows every append, set and removal, until compaction drops it. shapes
+//still waiting are not in it
+//NULL when out of memory
+struct SvgShapeIndex *svg_store_index(SvgShapeStore *store);
+
+//a reference to the shapes as they are now (svg_snapshot.h), for a reader to
+//release with svg_version_release. the first call copies every shape into
+//chunks, which then follow every append, set and removal until compaction
+//drops them; later calls cost O(1). NULL when out of memory
+struct SvgShapeVersion *svg_store_snapshot(SvgShapeStore *store);
+
+//store replaces old (a reload): give its handles generations above any old had,
+//so a handle into old matches nothing in store
+void svg_store_succeed(SvgShapeStore *store, const SvgShapeStore *old);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef SVG_STYLE_H
+#define SVG_STYLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "svg_types.h"
+#include "svg_scan.h"
+
+//fill and stroke both unset (renderers use their defaults); index 0 in every document
+extern const SvgStyle svg_default_style;
+
+//one rule of a <style> sheet: [element][.class]... { fill: ...; stroke: ...; fill-rule: ... }
+typedef struct SvgStyleRule {
+    SvgElementKind element;//SVG_ELEMENT_OTHER matches any element ("*" or no name)
+    const char *classes;//".a.b" part of the selector, NUL-terminated; NULL for none
+    int specificity;//1 per element name, 10 per class
+    SvgStyle declarations;//unset paints leave the cascade alone
+    struct SvgStyleRule *next;//ordered by specificity, then by position in the sheet
+} SvgStyleRule;
+
+typedef struct {
+    SvgStyleRule *rules;
+    int count;
+} SvgStyleSheet;
+
+//1 when the paint was given a value (a decoded color, none, or kept text)
+int svg_paint_is_set(const SvgPaint *paint);
+
+//copy the paints (and fill rule) that are set in over onto style
+void svg_style_merge(SvgStyle *style, const SvgStyle *over);
+
+//parse a fill/stroke value for the cascade (kept text goes to arena, dropped when
+//arena is NULL). return:1 -> it overrides the inherited paint, 0 -> empty value,
+//-1 -> out of memory
+int svg_style_parse_paint(const char *s, size_t len, SvgPaint *out, SvgArena *arena);
+
+//"nonzero" or "evenodd"; SVG_FILL_RULE_UNSET for anything else (the inherited rule stays)
+SvgFillRule svg_style_parse_fill_rule(const char *s, size_t len);
+
+//apply "fill: red; stroke: #00f; fill-rule: evenodd" declarations onto style; other
+//properties are ignored
+//kept color text goes to arena (dropped when arena is NULL)
+//return:0 -> success, -1 -> out of memory
+int svg_style_parse_declarations(const char *s, size_t len, SvgStyle *style, SvgArena *arena);
+
+//add the rules of a stylesheet; selectors other than element, .class and
+//element.class (lists of them are fine) are skipped. comments in css are
+//blanked in place. return:0 -> success, -1 -> out of memory
+int svg_stylesheet_parse(SvgStyleSheet *sheet, char *css, size_t len, SvgArena *arena);
+
+//apply every rule matching an element of this kind with this class attribute
+//(classes may be NULL), least specific first
+void svg_stylesheet_apply(const SvgStyleSheet *sheet, SvgElementKind kind,
+                          const char *classes, size_t classes_len, SvgStyle *style);
+
+//value hash and equality used to intern styles (index and next are ignored)
+uint32_t svg_style_hash(const SvgStyle *style);
+int svg_style_equal(const SvgStyle *a, const SvgStyle *b);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef SVG_TOKENIZER_H
+#define SVG_TOKENIZER_H
+
+#include <stddef.h>
+
+//size of the sliding window used when streaming
+#ifndef SVG_TOKENIZER_WINDOW
+#define SVG_TOKENIZER_WINDOW (256 * 1024)
+#endif
+
+//a single tag longer than the window grows it up to this size; a larger tag
+//fails the load (the in-memory loaders have no such limit)
+#ifndef SVG_TOKENIZER_MAX_TAG
+#define SVG_TOKENIZER_MAX_TAG (64 * 1024 * 1024)
+#endif
+
+//called once per tag: tag points just after '<', end points at the closing '>'
+//closing tags are delivered too (tag[0] == '/'); comments, CDATA, <? ?> and <! > are not
+//return SVG_TOKEN_WANT_TEXT to have the character data up to the next tag passed
+//to the text handler, another non-zero value to stop tokenizing
+typedef int (*SvgElementHandler)(void *ctx, const char *tag, const char *end);
+
+//character data (CDATA content included) after a tag that asked for it; may
+//arrive in several pieces when streaming. return non-zero to stop tokenizing
+typedef int (*SvgTextHandler)(void *ctx, const char *text, const char *end);
+
+#define SVG_TOKEN_WANT_TEXT 1
+
+typedef struct {
+    char *window;//buffer holding the unprocessed tail of the input
+    size_t capacity;
+    size_t start;//first byte not consumed yet
+    size_t used;//bytes of valid data in the window
+    int mode;//what the scanner is inside of (markup, comment, CDATA)
+    int run;//consecutive '-' or ']' seen while looking for a comment/CDATA end
+    int error;//first non-zero handler result
+    int want_text;//the last tag asked for the text after it
+    SvgElementHandler handler;
+    SvgTextHandler text;//may be NULL
+    void *ctx;
+} SvgTokenizer;
+
+//most attributes kept per tag; further attributes are ignored
+#define SVG_MAX_ATTRIBUTES 32
+
+//one name="value" pair; both slices point into the tag text, nothing is copied
+typedef struct {
+    const char *name;
+    size_t name_len;
+    const char *value;
+    size_t value_len;
+} SvgAttribute;
+
+typedef struct {
+    SvgAttribute items[SVG_MAX_ATTRIBUTES];
+    int count;
+} SvgAttributeTable;
+
+//walk the attributes of a tag once (p just after the element name, end at '>')
+//return the number of attributes stored in table
+int svg_lex_attributes(const char *p, const char *end, SvgAttributeTable *table);
+
+//exact-name lookup in a lexed table; return NULL when the attribute is absent
+const SvgAttribute *svg_find_attribute(const SvgAttributeTable *table, const char *name);
+
+//tokenize a complete buffer in one call (text may be NULL); return:0 -> success
+int svg_tokenize_buffer(const char *data, size_t size, SvgElementHandler handler, SvgTextHandler text,
+                        void *ctx);
+
+//tokenize one piece of a larger buffer; the piece must start outside any markup
+//*clean is set when it also ends outside comments, CDATA and tags, which means
+//the next piece could be tokenized on its own; last marks the final piece
+int svg_tokenize_piece(const char *data, size_t size, SvgElementHandler handler, SvgTextHandler text,
+                       void *ctx, int last, int *clean);
+
+//streaming use: get space, fill it, advance, repeat; then finish
+int svg_tokenizer_init(SvgTokenizer *tok, SvgElementHandler handler, SvgTextHandler text, void *ctx);
+char *svg_tokenizer_space(SvgTokenizer *tok, size_t *avail);
+int svg_tokenizer_advance(SvgTokenizer *tok, size_t len);
+int svg_tokenizer_finish(SvgTokenizer *tok);
+void svg_tokenizer_release(SvgTokenizer *tok);
+
+#endif
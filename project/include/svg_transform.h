@@ -0,0 +1,42 @@
+#ifndef SVG_TRANSFORM_H
+#define SVG_TRANSFORM_H
+
+#include <stddef.h>
+#include "svg_types.h"
+
+//transforms are composed once at load time; renderers apply one matrix per shape
+
+void svg_matrix_identity(SvgMatrix *m);
+
+//out = outer * inner (inner is applied first); out may alias either input
+void svg_matrix_multiply(const SvgMatrix *outer, const SvgMatrix *inner, SvgMatrix *out);
+
+//return:0 -> success, -1 when m is singular
+int svg_matrix_invert(const SvgMatrix *m, SvgMatrix *out);
+
+//map a point; m may be NULL for identity
+void svg_matrix_apply(const SvgMatrix *m, double x, double y, double *out_x, double *out_y);
+
+//parse a transform list: matrix, translate, scale, rotate, skewX, skewY
+//return:0 -> success, -1 on a syntax error (the attribute is then ignored)
+int svg_transform_parse(const char *s, size_t len, SvgMatrix *out);
+
+//the part of row y covered by a filled circle or rect, as an interval [*x0, *x1]
+//of device x; inverse maps device to the shape's local coordinates (one matrix
+//for the whole shape, so each row costs a few multiplies)
+//return 0 when the row misses the shape
+int svg_shape_row_span(const SvgShape *shape, const SvgMatrix *inverse, double y, double *x0, double *x1);
+
+//matrix placing a <use> instance's definition: transform * translate(x, y)
+void svg_use_matrix(const SvgShape *shape, SvgMatrix *out);
+
+//axis-aligned bounds of the shape in document coordinates: min_x, min_y, max_x, max_y
+//(for a <use>, the bounds of its definition where it is placed: the corners of
+//a settled definition's box, or its shapes one by one for one built by hand)
+void svg_shape_bounds(const SvgShape *shape, double out[4]);
+
+//svg_shape_bounds without the fallback: return 0, out unset, when the shape
+//covers nothing (an empty point list, a use drawing nothing)
+int svg_shape_covered_bounds(const SvgShape *shape, double out[4]);
+
+#endif
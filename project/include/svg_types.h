@@ -1,45 +1,245 @@
 #ifndef SVG_TYPES_H
 #define SVG_TYPES_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include "svg_arena.h"
+#include "svg_mmap.h"
+
 //define a struct SvgShapeType to list the types of different shapes
 typedef enum {
     SVG_SHAPE_CIRCLE,//circle
     SVG_SHAPE_RECT,//rectangle
-    SVG_SHAPE_LINE//line
+    SVG_SHAPE_LINE,//line
+    SVG_SHAPE_USE,//<use>: an instance of a definition
+    SVG_SHAPE_POLYGON,//closed outline, filled
+    SVG_SHAPE_POLYLINE//open outline, stroked
 } SvgShapeType;
 
+//how a fill or stroke attribute was resolved
+typedef enum {
+    SVG_PAINT_UNSET,//no usable value: renderers fall back to their default color
+    SVG_PAINT_NONE,//"none": the shape is not painted
+    SVG_PAINT_COLOR//rgba holds the decoded color
+} SvgPaintKind;
+
+//fill/stroke decoded once at load time, so renderers never parse strings
+typedef struct {
+    uint32_t rgba;//packed 0xRRGGBBAA
+    SvgPaintKind kind;
+    char* text;//original value, kept only when it could not be decoded (for saving)
+} SvgPaint;
+
+//which parts of a self-intersecting polygon are inside
+typedef enum {
+    SVG_FILL_RULE_UNSET,//inherited or not given: nonzero
+    SVG_FILL_RULE_NONZERO,
+    SVG_FILL_RULE_EVENODD
+} SvgFillRule;
+
+//affine transform: x' = a*x + c*y + e, y' = b*x + d*y + f (SVG matrix(a,b,c,d,e,f))
+typedef struct {
+    double a, b, c, d, e, f;
+} SvgMatrix;
+
+//resolved paint of a shape after attributes, <style> rules and style="" are applied
+//documents intern these, so shapes with the same look share one record
+typedef struct SvgStyle {
+    SvgPaint fill;//used by circles, rects and polygons; polylines only when it is set
+    SvgPaint stroke;//used by lines and polylines; polygon outlines only when it is set
+    SvgFillRule fill_rule;//polygons and filled polylines
+    int index;//unique within the document; 0 is svg_default_style
+    struct SvgStyle *next;
+} SvgStyle;
+
 //show the characters of circles
 typedef struct {
     double cx, cy, r;//coordinates and radius
-    char* fill; // colors e.g., "#RRGGBB" 
 } SvgCircle;
 
 typedef struct {
     double x, y, width, height;
-    char* fill; // e.g., "#RRGGBB"
 } SvgRect;
 
 typedef struct {
     double x1, y1, x2, y2;
-    char* stroke; //line doesn't have fill, only stroke e.g., "#RRGGBB"
 } SvgLine;
 
+//<polygon>/<polyline points="x,y ...">; a polygon closes back to its first point
+typedef struct {
+    double *points;//x0 y0 x1 y1 ..., count pairs
+    int count;
+} SvgPoly;
+
+struct SvgDefinition;
+
+//<use href="#id" x= y=>; the definition is stored once and shared by every instance
+typedef struct {
+    double x, y;//offset, applied inside the shape's transform
+    const struct SvgDefinition *definition;//NULL when href names no definition or the use was cut (nothing is drawn)
+    const char *href;//referenced id without '#', kept for saving
+} SvgUse;
+
+//limits on what the uses of a loaded document expand to: the parser cuts any
+//use that would nest deeper than SVG_MAX_USE_DEPTH, reach the definition it is
+//part of (directly or through other uses), or take the shapes drawn through
+//uses in the whole document past SVG_MAX_USE_SHAPES
+#define SVG_MAX_USE_DEPTH 16
+#define SVG_MAX_USE_SHAPES ((size_t)1 << 20)
+
+//shape of a lazy document that has not been decoded yet: its tag in the mapped file
+typedef struct {
+    const char *tag;//just after '<'
+    const char *end;//the closing '>'
+    const struct SvgStyle *inherited;//style of the enclosing groups
+} SvgSource;
+
+//one shape, as svg_shapes_first/svg_document_shape assemble it from the
+//document's tables, or as a node of a definition's content
 typedef struct SvgShape {
     SvgShapeType type;//note the current shape type
+    int id;//number every shape
     union {
         SvgCircle circle;
         //if type==svg_shape_circle, the data is collected in data.circle
         SvgRect rect;
         SvgLine line;
+        SvgUse use;
+        SvgPoly poly;//polygon and polyline
     } data;
-    int id;//number every shape
-    struct SvgShape *next;//self-reference structure, the pointer of the next one
+    const SvgMatrix *transform;//local -> document coordinates, NULL for none; shared by a group's shapes
+    const SvgStyle *style;//shared with every shape that looks the same
+    struct SvgShape *next;//definition content only: the next shape of the definition
 } SvgShape;
 
-//display the 
+typedef enum {
+    SVG_DEFINITION_UNSETTLED,
+    SVG_DEFINITION_SETTLING,//on the path being walked: a use reaching it is a cycle
+    SVG_DEFINITION_SETTLED
+} SvgDefinitionState;
+
+//content of a <symbol>, or of a <g> or shape with an id inside <defs>
+//shapes are in the definition's own coordinates and are never drawn directly
+typedef struct SvgDefinition {
+    const char *id;
+    struct SvgShape *shapes;//drawn in order for every instance
+    int index;//0-based position in the document, for per-definition caches
+    int settled;//SvgDefinitionState: whether the parser has checked its uses yet
+    int height;//once settled: deepest nesting of uses in the content, 0 for none
+    size_t drawn;//once settled: shapes one instance draws, uses expanded
+    double box[4];//once settled: bounds of an instance at the origin, empty (min above max) if it draws nothing
+    struct SvgDefinition *caller;//while settling: the definition whose use led here
+    struct SvgShape *resume;//while settling: the next part to check
+    struct SvgDefinition *next;
+} SvgDefinition;
+
+//a drawn shape: which table holds it and its row there
+typedef struct {
+    uint32_t type;//SvgShapeType
+    uint32_t index;
+} SvgDrawItem;
+
+//per-type geometry, one array per field so a pass over one field reads only that field
+typedef struct {
+    double *cx, *cy, *r;
+    size_t count, capacity;
+} SvgCircleTable;
+
+typedef struct {
+    double *x, *y, *width, *height;
+    size_t count, capacity;
+} SvgRectTable;
+
+typedef struct {
+    double *x1, *y1, *x2, *y2;
+    size_t count, capacity;
+} SvgLineTable;
+
+typedef struct {
+    double **points;//arena-owned, as in SvgPoly
+    int *point_count;
+    size_t count, capacity;
+} SvgPolyTable;
+
+typedef struct {
+    double *x, *y;
+    const SvgDefinition **definition;
+    const char **href;
+    size_t count, capacity;
+} SvgUseTable;
+
+//stable name of a drawn shape: it keeps naming the shape while others are added
+//or removed, and stops matching anything once its shape is removed
+typedef uint64_t SvgShapeHandle;
+#define SVG_NO_SHAPE ((SvgShapeHandle)0)
+
+//handles a region query found, in draw order; the array is kept between queries
 typedef struct {
+    SvgShapeHandle *handles;
+    size_t count, capacity;
+} SvgShapeQuery;
+
+struct SvgShapeIndex;
+struct SvgShapeVersion;
+
+//what a handle names: a draw position while the slot is in use, else the next free slot
+typedef struct {
+    uint32_t position;
+    uint32_t generation;//bumped when the shape is removed, so its handles stop matching
+} SvgShapeSlot;
+
+//the drawn shapes of a document (see svg_store.h): the draw order, what every
+//shape has, indexed by draw position, and the geometry tables the order points into
+typedef struct {
+    SvgDrawItem *items;
+    int *ids;
+    const SvgStyle **styles;//NULL while a lazy shape waits to be decoded
+    const SvgMatrix **transforms;//for a waiting shape, its group's matrix
+    SvgSource *sources;//lazy documents only: where each waiting shape's tag is
+    uint32_t *slot_of;//handle slot of each position
+    double (*bounds)[4];//min_x, min_y, max_x, max_y after the transform; empty (min above max) while waiting
+    size_t count, capacity;//positions, including removed ones not compacted yet
+    size_t removed;
+    size_t pending;//lazy shapes not decoded yet
+    size_t edits;//appends, sets and removals so far; decoding a waiting shape is not one
+    double extent[4];//union of the bounds of live shapes
+    int extent_stale;//an edge may have been edited or removed away: recompute before use
+    struct SvgShapeIndex *index;//grid over bounds (svg_index.h), built by the first region query
+    struct SvgShapeVersion *version;//chunks snapshots share (svg_snapshot.h), made by the first snapshot
+    SvgShapeSlot *slots;
+    size_t slot_count, slot_capacity;
+    uint32_t free_slot;//first free slot + 1, 0 when none is free
+    uint32_t generation;//given to new slots; no slot has had a higher one
+    uint32_t *id_slots;//shape id -> slot + 1, 0 when no shape has that id
+    size_t id_capacity;
+    int max_id;
+    SvgCircleTable circles;
+    SvgRectTable rects;
+    SvgLineTable lines;
+    SvgPolyTable polygons;
+    SvgPolyTable polylines;
+    SvgUseTable uses;
+} SvgShapeStore;
+
+//display the 
+typedef struct SvgDocument {
     double width, height;// of the whole document
-    SvgShape *shapes;//point to the head of shape list
+    SvgShapeStore shapes;//drawn shapes in order (malloc'd tables)
+    SvgArena arena;//owns definitions, matrices, points and kept color text of this document
+    SvgDefinition *definitions;//most recent first
+    int definition_count;
+    SvgDefinition **definition_table;//open-addressing index by id (arena-owned)
+    int definition_slots;//size of definition_table, a power of two
+    SvgStyle *styles;//interned styles, most recent first
+    int style_count;//including svg_default_style, so indexes run 0..style_count-1
+    SvgStyle **style_table;//open-addressing index by value (arena-owned)
+    int style_slots;
+    SvgMappedFile source;//lazy documents: the input that undecoded shapes point into
+    uint64_t *element_hashes;//svg_reload_from_file: one per drawn shape, in order (malloc'd)
+    size_t element_count;
+    uint64_t structure_hash;//the rest of the input that decides how shapes come out
+    size_t element_edits;//shapes.edits when the hashes were taken: any other value means edited since
+    struct SvgShapeVersion *snapshot;//svg_document_snapshot only: the shapes read in place of the store's
 } SvgDocument;
 
 #endif
@@ -6,14 +6,144 @@
 #include "../include/svg_render.h"
 #include "../include/bmp_writer.h"
 #include "../include/jpg_writer.h"
+#include "../include/svg_binary.h"
 #include "../include/svg_gui.h"
 
+// Loader selected by the global options
+static int use_mmap = 0;
+static int parse_threads = 1;
+static int use_stream = 0;
+
+// --crop: exports draw only this region of the document, at its own size
+static int use_crop = 0;
+static int crop[4];//x, y, width, height
+
+// Expand a compiled .svgb file into an editable document
+static int load_binary(const char *filename, SvgDocument **doc_out) {
+    SvgbFile file;
+    if (svgb_open(filename, &file) != 0) return -1;
+    *doc_out = svgb_to_document(&file);
+    svgb_close(&file);
+    return *doc_out ? 0 : -1;
+}
+
+// Compiled input is recognised by its magic; standard input is always SVG text
+static int is_binary_input(const char *filename) {
+    return strcmp(filename, SVG_STDIN_NAME) != 0 && svgb_is_binary(filename);
+}
+
+static int load_document(const char *filename, SvgDocument **doc_out) {
+    if (is_binary_input(filename)) return load_binary(filename, doc_out);
+    if (parse_threads != 1) return svg_load_from_file_parallel(filename, parse_threads, doc_out);
+    if (use_mmap) return svg_load_from_file_mmap(filename, doc_out);
+    return svg_load_from_file(filename, doc_out);
+}
+
+// Shapes are decoded when they are first drawn or printed
+static int load_document_lazy(const char *filename, SvgDocument **doc_out) {
+    if (is_binary_input(filename) || parse_threads != 1) return load_document(filename, doc_out);
+    return svg_load_from_file_lazy(filename, doc_out);
+}
+
+// Streaming export: shapes are rasterized as they are parsed, then dropped
+typedef struct {
+    SvgRaster raster;
+    int ready;//canvas allocated
+} StreamTarget;
+
+static int stream_size(void *ctx, double width, double height) {
+    StreamTarget *target = (StreamTarget *)ctx;
+    if (target->ready) return 0; // nested <svg>: keep the first canvas
+    if (svg_raster_init(&target->raster, (int)width, (int)height) != 0) return -1;
+    target->ready = 1;
+    return 0;
+}
+
+static int stream_shape(void *ctx, const SvgShape *shape) {
+    StreamTarget *target = (StreamTarget *)ctx;
+    if (!target->ready && stream_size(ctx, 800, 600) != 0) return -1;
+    svg_raster_draw_shape(&target->raster, shape);
+    return 0;
+}
+
+static int stream_render(const char *filename, SvgRaster *raster_out) {
+    StreamTarget target;
+    target.ready = 0;
+    SvgShapeSink sink = {stream_size, stream_shape, &target};
+
+    if (svg_stream_file(filename, &sink) != 0 || (!target.ready && stream_size(&target, 800, 600) != 0)) {
+        if (target.ready) svg_raster_release(&target.raster);
+        return -1;
+    }
+    *raster_out = target.raster;
+    return 0;
+}
+
+// Draw the records of a mapped .svgb file; nothing is parsed or allocated per shape
+static int render_binary(const char *filename, SvgRaster *raster_out) {
+    SvgbFile file;
+    if (svgb_open(filename, &file) != 0) return -1;
+
+    if (svg_raster_init(raster_out, (int)file.header->width, (int)file.header->height) != 0) {
+        svgb_close(&file);
+        return -1;
+    }
+    for (uint64_t i = 0; i < file.header->shape_count; i++) {
+        SvgShape shape;
+        svgb_record_to_shape(&file, i, &shape);
+        svg_raster_draw_shape(raster_out, &shape);
+    }
+
+    svgb_close(&file);
+    return 0;
+}
+
+// Exports that never build a document: compiled input or --stream
+static int render_without_document(const char *filename, SvgRaster *raster_out) {
+    if (is_binary_input(filename)) return render_binary(filename, raster_out);
+    return stream_render(filename, raster_out);
+}
+
+// Draw the --crop region: only shapes the document's grid finds there are visited
+static int render_crop(const SvgDocument *doc, SvgRaster *raster_out) {
+    if (svg_raster_init(raster_out, crop[2], crop[3]) != 0) return -1;
+    if (svg_raster_draw_region(raster_out, doc, crop[0], crop[1]) != 0) {
+        svg_raster_release(raster_out);
+        return -1;
+    }
+    return 0;
+}
+
+// Remove recognised global options from argv so commands keep fixed positions
+static int parse_global_options(int argc, char *argv[]) {
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mmap") == 0) {
+            use_mmap = 1;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            use_stream = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            parse_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--crop") == 0 && i + 4 < argc) {
+            for (int k = 0; k < 4; k++) crop[k] = atoi(argv[++i]);
+            use_crop = 1;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argv[kept] = NULL;
+    return kept;
+}
+
 void print_usage(const char *program_name) {
     printf("SVG Processor - ENGR1010J Project\n\n");
     printf("Usage:\n");
     printf("  Parse and display SVG:\n");
     printf("    %s --parse <input.svg>\n", program_name);
     printf("    %s -p <input.svg>\n\n", program_name);
+    printf("  Summarize SVG (size and shape counts by type, one pass without decoding shapes):\n");
+    printf("    %s --summary <input.svg>\n", program_name);
+    printf("    %s -s <input.svg>\n\n", program_name);
     printf("  Export to BMP:\n");
     printf("    %s --export_bmp <input.svg> <output.bmp>\n", program_name);
     printf("    %s -eb <input.svg> <output.bmp>\n\n", program_name);
@@ -21,19 +151,31 @@ void print_usage(const char *program_name) {
     printf("    %s --export_jpg <input.svg> <output.jpg> [quality]\n", program_name);
     printf("    %s -ej <input.svg> <output.jpg> [quality]\n", program_name);
     printf("    (quality: 1-100, default: 90)\n\n");
+    printf("  Compile to binary .svgb (loads instantly; accepted as input everywhere):\n");
+    printf("    %s --compile <input.svg> <output.svgb>\n", program_name);
+    printf("    %s -c <input.svg> <output.svgb>\n\n", program_name);
     printf("  Interactive GUI Editor:\n");
     printf("    %s --gui [input.svg]\n", program_name);
     printf("    %s -g [input.svg]\n\n", program_name);
+    printf("Options (anywhere on the command line):\n");
+    printf("  --mmap         Map the input file and parse it in place\n");
+    printf("  --threads <n>  Parse a mapped file on n threads (0: one per CPU)\n");
+    printf("  --stream       Export by drawing each shape as it is parsed (memory: image only)\n");
+    printf("  --crop <x> <y> <w> <h>  Export only the w x h region at (x, y) (loads the whole document)\n\n");
+    printf("Use - as <input.svg> to read the SVG (or gzip-compressed SVG) from standard input.\n\n");
     printf("GUI Controls:\n");
     printf("  - Click to select and drag shapes\n");
     printf("  - Toolbar buttons to add shapes\n");
     printf("  - DELETE: Remove selected shape\n");
-    printf("  - S: Save to SVG file\n");
+    printf("  - S: Save to SVG file (in the background; editing goes on)\n");
+    printf("  - E: Export to BMP file (in the background)\n");
     printf("  - T: Toggle toolbar\n");
     printf("  - ESC: Exit\n");
 }
 
 int main(int argc, char *argv[]) {
+    argc = parse_global_options(argc, argv);
+
     if (argc < 2) {
         print_usage(argv[0]);
         return 1;
@@ -45,7 +187,7 @@ int main(int argc, char *argv[]) {
         
         // Load SVG file if provided
         if (argc >= 3) {
-            if (svg_load_from_file(argv[2], &doc) != 0) {
+            if (load_document_lazy(argv[2], &doc) != 0) {
                 fprintf(stderr, "Warning: Failed to load SVG file: %s\n", argv[2]);
                 fprintf(stderr, "Starting with empty document...\n");
             }
@@ -56,7 +198,8 @@ int main(int argc, char *argv[]) {
         printf("  - Click shapes to select and drag\n");
         printf("  - Use toolbar buttons to add shapes\n");
         printf("  - DELETE: Remove selected shape\n");
-        printf("  - S: Save to SVG file\n");
+        printf("  - S: Save to SVG file (in the background; editing goes on)\n");
+        printf("  - E: Export to BMP file (in the background)\n");
         printf("  - T: Toggle toolbar\n");
         printf("  - ESC: Exit\n\n");
         
@@ -72,7 +215,7 @@ int main(int argc, char *argv[]) {
     // Parse command
     if (strcmp(argv[1], "--parse") == 0 || strcmp(argv[1], "-p") == 0) {
         SvgDocument *doc = NULL;
-        if (svg_load_from_file(argv[2], &doc) != 0) {
+        if (load_document(argv[2], &doc) != 0) {
             fprintf(stderr, "Failed to load SVG file: %s\n", argv[2]);
             return 1;
         }
@@ -84,6 +227,46 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    // Summary only
+    if (strcmp(argv[1], "--summary") == 0 || strcmp(argv[1], "-s") == 0) {
+        SvgDocument *doc = NULL;
+        if (load_document_lazy(argv[2], &doc) != 0) {
+            fprintf(stderr, "Failed to load SVG file: %s\n", argv[2]);
+            return 1;
+        }
+
+        svg_print_summary(doc);
+
+        svg_free_document(doc);
+        return 0;
+    }
+
+    // Compile to .svgb
+    if (strcmp(argv[1], "--compile") == 0 || strcmp(argv[1], "-c") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Error: Output filename required\n");
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        SvgDocument *doc = NULL;
+        if (load_document(argv[2], &doc) != 0) {
+            fprintf(stderr, "Failed to load SVG file: %s\n", argv[2]);
+            return 1;
+        }
+
+        if (svgb_write(argv[3], doc) != 0) {
+            fprintf(stderr, "Failed to write SVGB file: %s\n", argv[3]);
+            svg_free_document(doc);
+            return 1;
+        }
+
+        printf("Successfully compiled to SVGB: %s\n", argv[3]);
+
+        svg_free_document(doc);
+        return 0;
+    }
+
     // Export to BMP
     if (strcmp(argv[1], "--export_bmp") == 0 || strcmp(argv[1], "-eb") == 0) {
         if (argc < 4) {
@@ -92,13 +275,40 @@ int main(int argc, char *argv[]) {
             return 1;
         }
 
+        if (!use_crop && (use_stream || is_binary_input(argv[2]))) {
+            SvgRaster raster;
+            if (render_without_document(argv[2], &raster) != 0) {
+                fprintf(stderr, "Failed to load SVG file: %s\n", argv[2]);
+                return 1;
+            }
+            int result = bmp_write_raster(argv[3], &raster);
+            svg_raster_release(&raster);
+            if (result != 0) {
+                fprintf(stderr, "Failed to export BMP file: %s\n", argv[3]);
+                return 1;
+            }
+            printf("Successfully exported to BMP: %s\n", argv[3]);
+            return 0;
+        }
+
         SvgDocument *doc = NULL;
-        if (svg_load_from_file(argv[2], &doc) != 0) {
+        if (load_document(argv[2], &doc) != 0) {
             fprintf(stderr, "Failed to load SVG file: %s\n", argv[2]);
             return 1;
         }
 
-        if (export_to_bmp(argv[3], doc) != 0) {
+        int result;
+        if (use_crop) {
+            SvgRaster raster;
+            result = render_crop(doc, &raster);
+            if (result == 0) {
+                result = bmp_write_raster(argv[3], &raster);
+                svg_raster_release(&raster);
+            }
+        } else {
+            result = export_to_bmp(argv[3], doc);
+        }
+        if (result != 0) {
             fprintf(stderr, "Failed to export BMP file: %s\n", argv[3]);
             svg_free_document(doc);
             return 1;
@@ -127,13 +337,40 @@ int main(int argc, char *argv[]) {
             }
         }
 
+        if (!use_crop && (use_stream || is_binary_input(argv[2]))) {
+            SvgRaster raster;
+            if (render_without_document(argv[2], &raster) != 0) {
+                fprintf(stderr, "Failed to load SVG file: %s\n", argv[2]);
+                return 1;
+            }
+            int result = jpg_write_raster(argv[3], &raster, quality);
+            svg_raster_release(&raster);
+            if (result != 0) {
+                fprintf(stderr, "Failed to export JPG file: %s\n", argv[3]);
+                return 1;
+            }
+            printf("Successfully exported to JPG: %s (quality: %d)\n", argv[3], quality);
+            return 0;
+        }
+
         SvgDocument *doc = NULL;
-        if (svg_load_from_file(argv[2], &doc) != 0) {
+        if (load_document(argv[2], &doc) != 0) {
             fprintf(stderr, "Failed to load SVG file: %s\n", argv[2]);
             return 1;
         }
 
-        if (export_to_jpg(argv[3], doc, quality) != 0) {
+        int result;
+        if (use_crop) {
+            SvgRaster raster;
+            result = render_crop(doc, &raster);
+            if (result == 0) {
+                result = jpg_write_raster(argv[3], &raster, quality);
+                svg_raster_release(&raster);
+            }
+        } else {
+            result = export_to_jpg(argv[3], doc, quality);
+        }
+        if (result != 0) {
             fprintf(stderr, "Failed to export JPG file: %s\n", argv[3]);
             svg_free_document(doc);
             return 1;
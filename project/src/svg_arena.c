@@ -0,0 +1,76 @@
+#include "../include/svg_arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16
+#define ARENA_FIRST_BLOCK (64 * 1024)
+#define ARENA_MAX_BLOCK (16 * 1024 * 1024)
+
+// Header padded so block data starts aligned
+#define ARENA_HEADER ((sizeof(SvgArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+void svg_arena_init(SvgArena *arena) {
+    arena->head = NULL;
+    arena->next_size = ARENA_FIRST_BLOCK;
+    arena->blocks = 0;
+}
+
+void *svg_arena_alloc(SvgArena *arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    SvgArenaBlock *block = arena->head;
+    if (!block || block->size - block->used < size) {
+        size_t block_size = arena->next_size;
+        if (block_size < size) block_size = size;
+
+        block = (SvgArenaBlock *)malloc(ARENA_HEADER + block_size);
+        if (!block) return NULL;
+        block->next = arena->head;
+        block->size = block_size;
+        block->used = 0;
+        arena->head = block;
+        arena->blocks++;
+
+        if (arena->next_size < ARENA_MAX_BLOCK) arena->next_size *= 2;
+    }
+
+    void *p = (char *)block + ARENA_HEADER + block->used;
+    block->used += size;
+    return p;
+}
+
+char *svg_arena_strndup(SvgArena *arena, const char *s, size_t len) {
+    char *copy = (char *)svg_arena_alloc(arena, len + 1);
+    if (!copy) return NULL;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+void svg_arena_adopt(SvgArena *dst, SvgArena *src) {
+    if (!src->head) return;
+
+    // Keep dst's current block at the head so it goes on filling
+    SvgArenaBlock *tail = src->head;
+    while (tail->next) tail = tail->next;
+    if (dst->head) {
+        tail->next = dst->head->next;
+        dst->head->next = src->head;
+    } else {
+        dst->head = src->head;
+    }
+    dst->blocks += src->blocks;
+
+    src->head = NULL;
+    src->blocks = 0;
+}
+
+void svg_arena_release(SvgArena *arena) {
+    SvgArenaBlock *block = arena->head;
+    while (block) {
+        SvgArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    svg_arena_init(arena);
+}
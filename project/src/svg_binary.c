@@ -0,0 +1,417 @@
+#include "../include/svg_binary.h"
+#include "../include/svg_parser.h"
+#include "../include/svg_store.h"
+#include "../include/svg_transform.h"
+#include "../include/svg_style.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void grow_bounds(SvgbHeader *header, int *first, const double box[4]) {
+    double x0 = box[0], y0 = box[1], x1 = box[2], y1 = box[3];
+    if (*first) {
+        header->min_x = x0;
+        header->min_y = y0;
+        header->max_x = x1;
+        header->max_y = y1;
+        *first = 0;
+        return;
+    }
+    if (x0 < header->min_x) header->min_x = x0;
+    if (y0 < header->min_y) header->min_y = y0;
+    if (x1 > header->max_x) header->max_x = x1;
+    if (y1 > header->max_y) header->max_y = y1;
+}
+
+// What a pass over the document's records writes
+enum { SVGB_PASS_RECORDS, SVGB_PASS_MATRICES, SVGB_PASS_POINT_LISTS, SVGB_PASS_POINTS };
+
+// State of one pass over the document's records
+typedef struct {
+    SvgbHeader *header;
+    FILE *file;//NULL while counting
+    int table;//SVGB_PASS_*
+    int first;//no bounds gathered yet
+    SvgMatrix previous;//last table entry
+    uint64_t matrices;//table entries so far
+    uint64_t point_lists, points;//point list entries and x,y pairs so far
+    int ok;
+} SvgbPass;
+
+// Shapes of one group share a matrix; runs of the same matrix get one table
+// entry. *added is set when this shape starts a new entry
+static uint32_t matrix_index(SvgbPass *pass, const SvgShape *shape, int *added) {
+    *added = 0;
+    if (!shape->transform) return 0;
+    if (pass->matrices == 0 || memcmp(shape->transform, &pass->previous, sizeof(SvgMatrix)) != 0) {
+        pass->previous = *shape->transform;
+        pass->matrices++;
+        *added = 1;
+    }
+    return (uint32_t)pass->matrices;
+}
+
+static const SvgPoly *shape_points(const SvgShape *shape) {
+    if (shape->type != SVG_SHAPE_POLYGON && shape->type != SVG_SHAPE_POLYLINE) return NULL;
+    return &shape->data.poly;
+}
+
+static void fill_record(const SvgShape *shape, uint32_t matrix, uint32_t points, SvgbRecord *record) {
+    memset(record, 0, sizeof(*record));
+    record->type = (uint8_t)shape->type;
+    record->matrix = matrix;
+    record->points = points;
+    record->style = (uint32_t)shape->style->index;
+
+    switch (shape->type) {
+        case SVG_SHAPE_CIRCLE:
+            record->v[0] = shape->data.circle.cx;
+            record->v[1] = shape->data.circle.cy;
+            record->v[2] = shape->data.circle.r;
+            break;
+        case SVG_SHAPE_RECT:
+            record->v[0] = shape->data.rect.x;
+            record->v[1] = shape->data.rect.y;
+            record->v[2] = shape->data.rect.width;
+            record->v[3] = shape->data.rect.height;
+            break;
+        case SVG_SHAPE_LINE:
+            record->v[0] = shape->data.line.x1;
+            record->v[1] = shape->data.line.y1;
+            record->v[2] = shape->data.line.x2;
+            record->v[3] = shape->data.line.y2;
+            break;
+        case SVG_SHAPE_POLYGON:
+        case SVG_SHAPE_POLYLINE:
+            break; // in the point tables
+        case SVG_SHAPE_USE:
+            break; // expanded before it gets here
+    }
+}
+
+// The document's interned styles by index; records store that index as is
+static int write_styles(FILE *file, const SvgDocument *doc) {
+    if (doc->style_count <= 1) return 1;
+    SvgbStyle *table = (SvgbStyle *)calloc(doc->style_count - 1, sizeof(SvgbStyle));
+    if (!table) return 0;
+    for (const SvgStyle *style = doc->styles; style; style = style->next) {
+        SvgbStyle *entry = &table[style->index - 1];
+        entry->fill_kind = (uint8_t)style->fill.kind;
+        entry->stroke_kind = (uint8_t)style->stroke.kind;
+        entry->fill_rule = (uint8_t)style->fill_rule;
+        entry->fill_rgba = style->fill.rgba;
+        entry->stroke_rgba = style->stroke.rgba;
+    }
+    int ok = fwrite(table, sizeof(SvgbStyle), doc->style_count - 1, file) == (size_t)(doc->style_count - 1);
+    free(table);
+    return ok;
+}
+
+static void visit_record(SvgbPass *pass, const SvgShape *shape) {
+    int added;
+    uint32_t matrix = matrix_index(pass, shape, &added);
+
+    // Every polygon and polyline gets a point list of its own, in record order
+    const SvgPoly *poly = shape_points(shape);
+    SvgbPointList list = {pass->points, poly ? (uint64_t)poly->count : 0};
+    if (poly) {
+        pass->point_lists++;
+        pass->points += list.count;
+    }
+
+    if (!pass->file) {
+        SvgbHeader *header = pass->header;
+        header->shape_count++;
+        switch (shape->type) {
+            case SVG_SHAPE_CIRCLE: header->circle_count++; break;
+            case SVG_SHAPE_RECT: header->rect_count++; break;
+            case SVG_SHAPE_LINE: header->line_count++; break;
+            case SVG_SHAPE_POLYGON: header->polygon_count++; break;
+            case SVG_SHAPE_POLYLINE: header->polyline_count++; break;
+            case SVG_SHAPE_USE: break;
+        }
+        double box[4];
+        svg_shape_bounds(shape, box);
+        grow_bounds(header, &pass->first, box);
+    } else if (!pass->ok) {
+        return;
+    } else if (pass->table == SVGB_PASS_MATRICES) {
+        if (added) pass->ok = fwrite(shape->transform, sizeof(SvgMatrix), 1, pass->file) == 1;
+    } else if (pass->table == SVGB_PASS_POINT_LISTS) {
+        if (poly) pass->ok = fwrite(&list, sizeof(list), 1, pass->file) == 1;
+    } else if (pass->table == SVGB_PASS_POINTS) {
+        if (poly && poly->count)
+            pass->ok = fwrite(poly->points, 2 * sizeof(double), poly->count, pass->file) == (size_t)poly->count;
+    } else {
+        SvgbRecord record;
+        fill_record(shape, matrix, poly ? (uint32_t)pass->point_lists : 0, &record);
+        pass->ok = fwrite(&record, sizeof(record), 1, pass->file) == 1;
+    }
+}
+
+// The format has no instances: each <use> becomes a copy of its definition's
+// shapes with the placement folded into their matrices
+static void visit_shape(SvgbPass *pass, const SvgShape *shape, int depth) {
+    if (shape->type != SVG_SHAPE_USE) {
+        visit_record(pass, shape);
+        return;
+    }
+    const SvgDefinition *definition = shape->data.use.definition;
+    if (!definition || depth >= SVG_MAX_USE_DEPTH) return;
+
+    SvgMatrix m;
+    svg_use_matrix(shape, &m);
+    for (const SvgShape *part = definition->shapes; part; part = part->next) {
+        SvgShape placed = *part;
+        SvgMatrix composed;
+        if (part->transform) svg_matrix_multiply(&m, part->transform, &composed);
+        else composed = m;
+        placed.transform = &composed;
+        visit_shape(pass, &placed, depth + 1);
+    }
+}
+
+static int run_pass(SvgbPass *pass, const SvgDocument *doc) {
+    pass->matrices = 0;
+    pass->point_lists = 0;
+    pass->points = 0;
+    SvgShapeIter it;
+    for (const SvgShape *shape = svg_shapes_first(&it, doc); pass->ok && shape; shape = svg_shapes_next(&it))
+        visit_shape(pass, shape, 0);
+    if (it.failed) pass->ok = 0;
+    return pass->ok;
+}
+
+int svgb_write(const char *filename, const SvgDocument *doc) {
+    if (!doc || !filename) return -1;
+
+    SvgbHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SVGB_MAGIC, 4);
+    header.version = SVGB_VERSION;
+    header.header_size = sizeof(SvgbHeader);
+    header.record_size = sizeof(SvgbRecord);
+    header.width = doc->width;
+    header.height = doc->height;
+    header.style_count = doc->style_count - 1;
+
+    // Counts and bounds go in the header, so gather them first
+    SvgbPass pass;
+    memset(&pass, 0, sizeof(pass));
+    pass.header = &header;
+    pass.first = 1;
+    pass.ok = 1;
+    run_pass(&pass, doc);
+    header.matrix_count = pass.matrices;
+    header.point_list_count = pass.point_lists;
+    header.point_count = pass.points;
+    if (header.matrix_count > UINT32_MAX || header.point_list_count > UINT32_MAX) {
+        fprintf(stderr, "Error: Too many transforms or polygons for %s\n", filename);
+        return -1;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot create file %s\n", filename);
+        return -1;
+    }
+
+    pass.file = file;
+    pass.ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    run_pass(&pass, doc);
+
+    // The tables, in the order the records numbered them
+    pass.table = SVGB_PASS_MATRICES;
+    int ok = run_pass(&pass, doc);
+    pass.table = SVGB_PASS_POINT_LISTS;
+    ok = ok && run_pass(&pass, doc);
+    pass.table = SVGB_PASS_POINTS;
+    ok = ok && run_pass(&pass, doc) && write_styles(file, doc);
+
+    if (fclose(file) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+int svgb_is_binary(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+
+    char magic[4];
+    int is_binary = fread(magic, 1, 4, file) == 4 && memcmp(magic, SVGB_MAGIC, 4) == 0;
+    fclose(file);
+    return is_binary;
+}
+
+// Take a table of count items off the bytes left; 0 when it does not fit
+static int take_table(size_t *rest, uint64_t count, size_t item) {
+    if (count > *rest / item) return 0;
+    *rest -= (size_t)count * item;
+    return 1;
+}
+
+int svgb_open(const char *filename, SvgbFile *out) {
+    if (svg_map_file(filename, &out->file) != 0) return -1;
+
+    const SvgbHeader *header = (const SvgbHeader *)out->file.data;
+    size_t size = out->file.size;
+
+    // Reject foreign files, other versions and other struct layouts; each table
+    // has to fit in what the ones before it leave
+    size_t rest = size >= sizeof(SvgbHeader) ? size - sizeof(SvgbHeader) : 0;
+    if (size < sizeof(SvgbHeader) || memcmp(header->magic, SVGB_MAGIC, 4) != 0 ||
+        header->version != SVGB_VERSION || header->header_size != sizeof(SvgbHeader) ||
+        header->record_size != sizeof(SvgbRecord) ||
+        !take_table(&rest, header->shape_count, sizeof(SvgbRecord)) ||
+        !take_table(&rest, header->matrix_count, sizeof(SvgMatrix)) ||
+        !take_table(&rest, header->point_list_count, sizeof(SvgbPointList)) ||
+        !take_table(&rest, header->point_count, 2 * sizeof(double)) ||
+        !take_table(&rest, header->style_count, sizeof(SvgbStyle))) {
+        fprintf(stderr, "Error: %s is not a valid .svgb file\n", filename);
+        svg_unmap_file(&out->file);
+        return -1;
+    }
+
+    out->header = header;
+    out->records = (const SvgbRecord *)(out->file.data + sizeof(SvgbHeader));
+    out->matrices = (const SvgMatrix *)(out->records + header->shape_count);
+    out->point_lists = (const SvgbPointList *)(out->matrices + header->matrix_count);
+    out->points = (const double *)(out->point_lists + header->point_list_count);
+
+    // Shapes point at whole SvgStyle records, which the file does not hold as such
+    const SvgbStyle *table = (const SvgbStyle *)(out->points + 2 * header->point_count);
+    out->styles = (SvgStyle *)malloc((header->style_count + 1) * sizeof(SvgStyle));
+    if (!out->styles) {
+        svg_unmap_file(&out->file);
+        return -1;
+    }
+    out->styles[0] = svg_default_style;
+    for (uint64_t i = 0; i < header->style_count; i++) {
+        SvgStyle *style = &out->styles[i + 1];
+        *style = svg_default_style;
+        style->fill.kind = (SvgPaintKind)table[i].fill_kind;
+        style->fill.rgba = table[i].fill_rgba;
+        style->stroke.kind = (SvgPaintKind)table[i].stroke_kind;
+        style->stroke.rgba = table[i].stroke_rgba;
+        style->fill_rule = (SvgFillRule)table[i].fill_rule;
+        style->index = (int)(i + 1);
+    }
+    return 0;
+}
+
+void svgb_close(SvgbFile *file) {
+    svg_unmap_file(&file->file);
+    free(file->styles);
+    file->styles = NULL;
+    file->header = NULL;
+    file->records = NULL;
+    file->matrices = NULL;
+    file->point_lists = NULL;
+    file->points = NULL;
+}
+
+void svgb_record_to_shape(const SvgbFile *file, uint64_t index, SvgShape *shape) {
+    const SvgbRecord *record = &file->records[index];
+
+    memset(shape, 0, sizeof(*shape));
+    shape->type = (SvgShapeType)record->type;
+    shape->id = (int)(index + 1);
+    if (record->matrix && record->matrix <= file->header->matrix_count)
+        shape->transform = &file->matrices[record->matrix - 1];
+    shape->style = record->style <= file->header->style_count ? &file->styles[record->style] : file->styles;
+
+    switch (shape->type) {
+        case SVG_SHAPE_CIRCLE:
+            shape->data.circle.cx = record->v[0];
+            shape->data.circle.cy = record->v[1];
+            shape->data.circle.r = record->v[2];
+            break;
+        case SVG_SHAPE_RECT:
+            shape->data.rect.x = record->v[0];
+            shape->data.rect.y = record->v[1];
+            shape->data.rect.width = record->v[2];
+            shape->data.rect.height = record->v[3];
+            break;
+        case SVG_SHAPE_LINE:
+            shape->data.line.x1 = record->v[0];
+            shape->data.line.y1 = record->v[1];
+            shape->data.line.x2 = record->v[2];
+            shape->data.line.y2 = record->v[3];
+            break;
+        case SVG_SHAPE_POLYGON:
+        case SVG_SHAPE_POLYLINE: {
+            const SvgbHeader *header = file->header;
+            if (!record->points || record->points > header->point_list_count) break;
+            const SvgbPointList *list = &file->point_lists[record->points - 1];
+            if (list->first > header->point_count || list->count > header->point_count - list->first ||
+                list->count > INT_MAX)
+                break;
+            shape->data.poly.points = (double *)(file->points + 2 * list->first);
+            shape->data.poly.count = (int)list->count;
+            break;
+        }
+        case SVG_SHAPE_USE:
+            break; // never stored
+    }
+}
+
+SvgDocument* svgb_to_document(const SvgbFile *file) {
+    SvgDocument *doc = create_svg_document((float)file->header->width, (float)file->header->height);
+    if (!doc) return NULL;
+    doc->width = file->header->width;
+    doc->height = file->header->height;
+
+    // The document outlives the mapping, so the matrix table is copied once
+    SvgMatrix *matrices = NULL;
+    size_t matrix_bytes = (size_t)file->header->matrix_count * sizeof(SvgMatrix);
+    if (matrix_bytes) {
+        matrices = (SvgMatrix *)svg_arena_alloc(&doc->arena, matrix_bytes);
+        if (!matrices) {
+            svg_free_document(doc);
+            return NULL;
+        }
+        memcpy(matrices, file->matrices, matrix_bytes);
+    }
+    double *points = NULL;
+    size_t point_bytes = (size_t)file->header->point_count * 2 * sizeof(double);
+    if (point_bytes) {
+        points = (double *)svg_arena_alloc(&doc->arena, point_bytes);
+        if (!points) {
+            svg_free_document(doc);
+            return NULL;
+        }
+        memcpy(points, file->points, point_bytes);
+    }
+
+    // Interning in table order gives the styles the same indexes again
+    const SvgStyle **styles = (const SvgStyle **)malloc((file->header->style_count + 1) * sizeof(*styles));
+    if (!styles) {
+        svg_free_document(doc);
+        return NULL;
+    }
+    for (uint64_t i = 0; i <= file->header->style_count; i++) {
+        styles[i] = svg_document_intern_style(doc, &file->styles[i]);
+        if (!styles[i]) {
+            free(styles);
+            svg_free_document(doc);
+            return NULL;
+        }
+    }
+
+    int result = svg_store_reserve(&doc->shapes, (size_t)file->header->shape_count);
+    for (uint64_t i = 0; result == 0 && i < file->header->shape_count; i++) {
+        SvgShape shape;
+        svgb_record_to_shape(file, i, &shape);
+        if (shape.transform) shape.transform = matrices + (shape.transform - file->matrices);
+        if ((shape.type == SVG_SHAPE_POLYGON || shape.type == SVG_SHAPE_POLYLINE) && shape.data.poly.points)
+            shape.data.poly.points = points + (shape.data.poly.points - file->points);
+        shape.style = styles[shape.style - file->styles];
+        result = svg_store_append(&doc->shapes, &shape);
+    }
+    free(styles);
+    if (result != 0) {
+        svg_free_document(doc);
+        return NULL;
+    }
+    return doc;
+}
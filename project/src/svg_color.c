@@ -0,0 +1,158 @@
+#include "../include/svg_color.h"
+#include "../include/svg_color_table.h"
+#include "../include/svg_number.h"
+#include <stdio.h>
+#include <string.h>
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// "#RGB", "#RGBA", "#RRGGBB" or "#RRGGBBAA" -> 0xRRGGBBAA; return -1 otherwise
+static int parse_hex(const char *s, size_t len, uint32_t *rgba) {
+    if (len < 4 || s[0] != '#') return -1;
+    size_t digits = len - 1;
+    if (digits != 3 && digits != 4 && digits != 6 && digits != 8) return -1;
+
+    uint32_t value = 0;
+    for (size_t i = 1; i < len; i++) {
+        int d = hex_digit(s[i]);
+        if (d < 0) return -1;
+        // Short forms repeat each digit: #f80 is #ff8800
+        value = digits <= 4 ? (value << 8) | (uint32_t)(d * 17) : (value << 4) | (uint32_t)d;
+    }
+    *rgba = (digits == 3 || digits == 6) ? (value << 8) | 0xFF : value;
+    return 0;
+}
+
+// One of the 147 keywords, any case; return -1 otherwise
+static int parse_named(const char *s, size_t len, uint32_t *rgba) {
+    if (len == 0 || len > SVG_COLOR_MAX_NAME) return -1;
+    uint32_t bucket = svg_color_hash(s, len, 0) & (SVG_COLOR_BUCKETS - 1);
+    const SvgNamedColor *entry =
+        &svg_color_slots[svg_color_hash(s, len, svg_color_displacement[bucket]) & (SVG_COLOR_SLOTS - 1)];
+    if (!entry->name || entry->len != len) return -1;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c != (unsigned char)entry->name[i]) return -1;
+    }
+    *rgba = (entry->rgb << 8) | 0xFF;
+    return 0;
+}
+
+static const char *skip_space(const char *p, const char *end) {
+    while (p < end && (unsigned char)*p <= 0x20) p++;
+    return p;
+}
+
+// One rgb() argument: a number, or a percentage of scale; clamped to [0, scale]
+static const char *parse_component(const char *p, const char *end, double scale, double *out) {
+    double v;
+    const char *next = svg_parse_number(p, end, &v);
+    if (next == p) return NULL;
+    if (next < end && *next == '%') {
+        v = v * scale / 100.0;
+        next++;
+    }
+    if (!(v > 0.0)) v = 0.0; // also NaN
+    if (v > scale) v = scale;
+    *out = v;
+    return next;
+}
+
+// "rgb(r, g, b)", "rgba(r, g, b, a)" and the space-separated "rgb(r g b / a)";
+// channels are 0-255 or percentages, alpha is 0-1 or a percentage
+static int parse_rgb_function(const char *s, size_t len, uint32_t *rgba) {
+    const char *p = s, *end = s + len;
+    if (len < 5 || (p[0] | 0x20) != 'r' || (p[1] | 0x20) != 'g' || (p[2] | 0x20) != 'b') return -1;
+    p += 3;
+    if ((*p | 0x20) == 'a') p++;
+    p = skip_space(p, end);
+    if (p == end || *p != '(') return -1;
+
+    double channel[4] = {0.0, 0.0, 0.0, 1.0};
+    int count = 0;
+    p++;
+    for (;;) {
+        p = skip_space(p, end);
+        if (p < end && *p == ')') break;
+        if (count == 4) return -1;
+        if (count > 0) {
+            // Separators: ',' between any two, '/' before alpha, or just space
+            if (p < end && (*p == ',' || (*p == '/' && count == 3))) p = skip_space(p + 1, end);
+        }
+        p = parse_component(p, end, count < 3 ? 255.0 : 1.0, &channel[count]);
+        if (!p) return -1;
+        count++;
+    }
+    if (count < 3 || skip_space(p + 1, end) != end) return -1;
+
+    *rgba = SVG_RGBA((uint32_t)(channel[0] + 0.5), (uint32_t)(channel[1] + 0.5),
+                     (uint32_t)(channel[2] + 0.5), (uint32_t)(channel[3] * 255.0 + 0.5));
+    return 0;
+}
+
+int svg_color_parse(const char *s, size_t len, uint32_t *rgba) {
+    if (len > 0 && s[0] == '#') return parse_hex(s, len, rgba);
+    if (parse_named(s, len, rgba) == 0) return 0;
+    return parse_rgb_function(s, len, rgba);
+}
+
+int svg_paint_parse(const char *s, size_t len, SvgPaint *out, SvgArena *arena) {
+    // Attribute values may carry surrounding whitespace
+    while (len && (unsigned char)s[0] <= 0x20) { s++; len--; }
+    while (len && (unsigned char)s[len - 1] <= 0x20) len--;
+
+    out->rgba = 0;
+    out->kind = SVG_PAINT_UNSET;
+    out->text = NULL;
+
+    if (len == 4 && memcmp(s, "none", 4) == 0) {
+        out->kind = SVG_PAINT_NONE;
+        return 0;
+    }
+
+    uint32_t rgba;
+    if (svg_color_parse(s, len, &rgba) == 0) {
+        out->rgba = rgba;
+        out->kind = SVG_PAINT_COLOR;
+        return 0;
+    }
+
+    // Not decodable: renderers use their default, the writer saves it as-is
+    if (!arena) return 0;
+    out->text = svg_arena_strndup(arena, s, len);
+    return out->text ? 0 : -1;
+}
+
+SvgPaint svg_paint_rgb(uint32_t rgb) {
+    SvgPaint paint;
+    paint.rgba = (rgb << 8) | 0xFF;
+    paint.kind = SVG_PAINT_COLOR;
+    paint.text = NULL;
+    return paint;
+}
+
+uint32_t svg_paint_to_rgb(const SvgPaint *paint, uint32_t fallback_rgb) {
+    if (paint->kind == SVG_PAINT_COLOR) return paint->rgba >> 8;
+    return fallback_rgb;
+}
+
+const char *svg_paint_format(const SvgPaint *paint, char buf[16], const char *fallback) {
+    switch (paint->kind) {
+        case SVG_PAINT_COLOR:
+            snprintf(buf, 16, "#%02X%02X%02X", (unsigned)SVG_RGBA_R(paint->rgba),
+                     (unsigned)SVG_RGBA_G(paint->rgba), (unsigned)SVG_RGBA_B(paint->rgba));
+            // Keep a translucent color's alpha so saving does not drop it
+            if (SVG_RGBA_A(paint->rgba) != 0xFF) snprintf(buf + 7, 9, "%02X", (unsigned)SVG_RGBA_A(paint->rgba));
+            return buf;
+        case SVG_PAINT_NONE:
+            return "none";
+        default:
+            return paint->text ? paint->text : fallback;
+    }
+}
@@ -9,6 +9,11 @@
 #include "../include/svg_parser.h"
 #include "../include/svg_render.h"
 #include "../include/svg_writer.h"
+#include "../include/bmp_writer.h"
+#include "../include/svg_color.h"
+#include "../include/svg_transform.h"
+#include "../include/svg_style.h"
+#include "../include/svg_polygon.h"
 
 int gui_init(GUIState* state) {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -39,7 +44,7 @@ int gui_init(GUIState* state) {
 
     // Initialize state
     state->document = NULL;
-    state->selected_shape = -1;
+    state->selected_shape = SVG_NO_SHAPE;
     state->mouse_x = 0;
     state->mouse_y = 0;
     state->dragging = 0;
@@ -47,15 +52,21 @@ int gui_init(GUIState* state) {
     state->pan_y = 0;
     state->zoom = 1.0f;
     state->show_toolbar = 1;
+    memset(&state->visible, 0, sizeof(state->visible));
+    state->points_copied = 0;
+    memset(&state->job, 0, sizeof(state->job));
 
     return 1;
 }
 
 void gui_cleanup(GUIState* state) {
+    // The job's snapshot has to go before the document
+    svg_thread_join(&state->job.thread);
     if (state->canvas_texture) SDL_DestroyTexture(state->canvas_texture);
     if (state->renderer) SDL_DestroyRenderer(state->renderer);
     if (state->window) SDL_DestroyWindow(state->window);
     if (state->document) free_svg_document(state->document);
+    svg_shape_query_release(&state->visible);
     SDL_Quit();
 }
 
@@ -69,50 +80,38 @@ void gui_render(GUIState* state) {
     SDL_SetRenderDrawColor(state->renderer, 255, 255, 255, 255);
     SDL_RenderFillRect(state->renderer, &canvas_rect);
 
-    // Render SVG shapes
-    if (state->document) {
-        SvgShape* current = state->document->shapes;
-        int index = 0;
-        while (current) {
+    // Render SVG shapes: only those the grid finds on the canvas at this pan and zoom
+    double view[4] = {(-1.0 - state->pan_x) / state->zoom, (-1.0 - state->pan_y) / state->zoom,
+                      (CANVAS_WIDTH - state->pan_x) / state->zoom, (CANVAS_HEIGHT - state->pan_y) / state->zoom};
+    if (state->document && svg_document_query_rect(state->document, view, &state->visible) == 0) {
+        for (size_t i = 0; i < state->visible.count; i++) {
+            SvgShapeHandle handle = state->visible.handles[i];
+            SvgShapeIter it;
+            const SvgShape* current = svg_shapes_at(&it, state->document, handle);
+            if (!current) continue;
+            const double* box = it.bounds;
+            int selected = handle == state->selected_shape;
             gui_draw_shape(state->renderer, current, state->pan_x, state->pan_y, state->zoom);
 
-            // Highlight selected shape
-            if (index == state->selected_shape) {
+            // Highlight selected shape: a box from the bounds the document keeps,
+            // or the line itself when it is not transformed
+            if (selected && (current->type != SVG_SHAPE_LINE || current->transform)) {
+                SDL_Rect sel_box = {
+                    (int)(box[0] * state->zoom + state->pan_x) - 2,
+                    (int)(box[1] * state->zoom + state->pan_y) - 2,
+                    (int)((box[2] - box[0]) * state->zoom) + 4,
+                    (int)((box[3] - box[1]) * state->zoom) + 4
+                };
                 SDL_SetRenderDrawColor(state->renderer, 255, 0, 0, 255);
-                switch (current->type) {
-                    case SVG_SHAPE_CIRCLE:
-                        // Draw selection rectangle around circle
-                        SDL_Rect sel_rect = {
-                            (int)((current->data.circle.cx - current->data.circle.r) * state->zoom + state->pan_x) - 2,
-                            (int)((current->data.circle.cy - current->data.circle.r) * state->zoom + state->pan_y) - 2,
-                            (int)(current->data.circle.r * 2 * state->zoom) + 4,
-                            (int)(current->data.circle.r * 2 * state->zoom) + 4
-                        };
-                        SDL_RenderDrawRect(state->renderer, &sel_rect);
-                        break;
-                    case SVG_SHAPE_RECT:
-                        SDL_Rect sel_rect2 = {
-                            (int)(current->data.rect.x * state->zoom + state->pan_x) - 2,
-                            (int)(current->data.rect.y * state->zoom + state->pan_y) - 2,
-                            (int)(current->data.rect.width * state->zoom) + 4,
-                            (int)(current->data.rect.height * state->zoom) + 4
-                        };
-                        SDL_RenderDrawRect(state->renderer, &sel_rect2);
-                        break;
-                    case SVG_SHAPE_LINE:
-                        // Draw thicker line for selection
-                        SDL_SetRenderDrawColor(state->renderer, 255, 0, 0, 255);
-                        SDL_RenderDrawLine(state->renderer,
-                                        (int)(current->data.line.x1 * state->zoom + state->pan_x),
-                                        (int)(current->data.line.y1 * state->zoom + state->pan_y),
-                                        (int)(current->data.line.x2 * state->zoom + state->pan_x),
-                                        (int)(current->data.line.y2 * state->zoom + state->pan_y));
-                        break;
-                }
+                SDL_RenderDrawRect(state->renderer, &sel_box);
+            } else if (selected) {
+                SDL_SetRenderDrawColor(state->renderer, 255, 0, 0, 255);
+                SDL_RenderDrawLine(state->renderer,
+                                (int)(current->data.line.x1 * state->zoom + state->pan_x),
+                                (int)(current->data.line.y1 * state->zoom + state->pan_y),
+                                (int)(current->data.line.x2 * state->zoom + state->pan_x),
+                                (int)(current->data.line.y2 * state->zoom + state->pan_y));
             }
-
-            current = current->next;
-            index++;
         }
     }
 
@@ -124,21 +123,122 @@ void gui_render(GUIState* state) {
     SDL_RenderPresent(state->renderer);
 }
 
-void gui_draw_shape(SDL_Renderer* renderer, SvgShape* shape, int offset_x, int offset_y, float zoom) {
+static void gui_fill_span(void* ctx, int y, int x0, int x1) {
+    SDL_RenderDrawLine((SDL_Renderer*)ctx, x0, y, x1, y);
+}
+
+// Polygons and polylines, placed on screen by screen: scanline fill, then the
+// outline, with the same rules as the rasterizer
+static void gui_draw_poly(SDL_Renderer* renderer, const SvgShape* shape, const SvgMatrix* screen) {
+    const SvgPoly* poly = &shape->data.poly;
+    const SvgStyle* style = shape->style;
+    int closed = shape->type == SVG_SHAPE_POLYGON;
+
+    if (style->fill.kind != SVG_PAINT_NONE && (closed || svg_paint_is_set(&style->fill))) {
+        uint32_t color = svg_paint_to_rgb(&style->fill, 0xFFFFFF);
+        SDL_SetRenderDrawColor(renderer, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
+        int clip[4] = {0, 0, CANVAS_WIDTH - 1, CANVAS_HEIGHT - 1};
+        svg_polygon_fill(poly->points, poly->count, screen, style->fill_rule == SVG_FILL_RULE_EVENODD,
+                         clip, gui_fill_span, renderer);
+    }
+
+    if (style->stroke.kind == SVG_PAINT_NONE || (closed && !svg_paint_is_set(&style->stroke))) return;
+    if (poly->count < 2) return;
+    uint32_t color = svg_paint_to_rgb(&style->stroke, 0x000000);
+    SDL_SetRenderDrawColor(renderer, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
+    int segments = closed ? poly->count : poly->count - 1;
+    for (int i = 0; i < segments; i++) {
+        int j = (i + 1) % poly->count;
+        double x1, y1, x2, y2;
+        svg_matrix_apply(screen, poly->points[2 * i], poly->points[2 * i + 1], &x1, &y1);
+        svg_matrix_apply(screen, poly->points[2 * j], poly->points[2 * j + 1], &x2, &y2);
+        SDL_RenderDrawLine(renderer, (int)x1, (int)y1, (int)x2, (int)y2);
+    }
+}
+
+// Shapes with a transform: compose it with the view once, then fill row spans
+static void gui_draw_transformed(SDL_Renderer* renderer, const SvgShape* shape, int offset_x, int offset_y, float zoom) {
+    SvgMatrix view = {zoom, 0, 0, zoom, offset_x, offset_y};
+    SvgMatrix screen;
+    svg_matrix_multiply(&view, shape->transform, &screen);
+
+    if (shape->type == SVG_SHAPE_POLYGON || shape->type == SVG_SHAPE_POLYLINE) {
+        gui_draw_poly(renderer, shape, &screen);
+        return;
+    }
+
+    if (shape->type == SVG_SHAPE_LINE) {
+        const SvgLine* line = &shape->data.line;
+        if (shape->style->stroke.kind == SVG_PAINT_NONE) return;
+        uint32_t color = svg_paint_to_rgb(&shape->style->stroke, 0x000000);
+        SDL_SetRenderDrawColor(renderer, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
+        double x1, y1, x2, y2;
+        svg_matrix_apply(&screen, line->x1, line->y1, &x1, &y1);
+        svg_matrix_apply(&screen, line->x2, line->y2, &x2, &y2);
+        SDL_RenderDrawLine(renderer, (int)x1, (int)y1, (int)x2, (int)y2);
+        return;
+    }
+
+    const SvgPaint* fill = &shape->style->fill;
+    SvgMatrix inverse;
+    if (fill->kind == SVG_PAINT_NONE || svg_matrix_invert(&screen, &inverse) != 0) return;
+    uint32_t color = svg_paint_to_rgb(fill, 0xFFFFFF);
+    SDL_SetRenderDrawColor(renderer, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
+
+    SvgShape on_screen = *shape;
+    on_screen.transform = &screen;
+    double bounds[4];
+    svg_shape_bounds(&on_screen, bounds);
+    if (bounds[1] < 0) bounds[1] = 0;
+    if (bounds[3] > CANVAS_HEIGHT - 1) bounds[3] = CANVAS_HEIGHT - 1;
+    if (!(bounds[1] <= bounds[3])) return; // off the canvas
+
+    for (int y = (int)ceil(bounds[1]); y <= (int)floor(bounds[3]); y++) {
+        double x0, x1;
+        if (!svg_shape_row_span(shape, &inverse, y, &x0, &x1)) continue;
+        if (x0 < 0) x0 = 0;
+        if (x1 > CANVAS_WIDTH - 1) x1 = CANVAS_WIDTH - 1;
+        if (x0 <= x1) SDL_RenderDrawLine(renderer, (int)ceil(x0), y, (int)floor(x1), y);
+    }
+}
+
+// Instances: every shape of the definition under the composed matrix
+static void gui_draw_use(SDL_Renderer* renderer, const SvgShape* use, int offset_x, int offset_y, float zoom, int depth) {
+    const SvgDefinition* definition = use->data.use.definition;
+    if (!definition || depth >= SVG_MAX_USE_DEPTH) return;
+
+    SvgMatrix m;
+    svg_use_matrix(use, &m);
+    for (const SvgShape* part = definition->shapes; part; part = part->next) {
+        SvgShape placed = *part;
+        SvgMatrix composed;
+        if (part->transform) svg_matrix_multiply(&m, part->transform, &composed);
+        else composed = m;
+        placed.transform = &composed;
+        if (placed.type == SVG_SHAPE_USE) gui_draw_use(renderer, &placed, offset_x, offset_y, zoom, depth + 1);
+        else gui_draw_transformed(renderer, &placed, offset_x, offset_y, zoom);
+    }
+}
+
+void gui_draw_shape(SDL_Renderer* renderer, const SvgShape* shape, int offset_x, int offset_y, float zoom) {
+    if (shape->type == SVG_SHAPE_USE) {
+        gui_draw_use(renderer, shape, offset_x, offset_y, zoom, 0);
+        return;
+    }
+    if (shape->transform) {
+        gui_draw_transformed(renderer, shape, offset_x, offset_y, zoom);
+        return;
+    }
     switch (shape->type) {
         case SVG_SHAPE_CIRCLE: {
-            SvgCircle* circle = &shape->data.circle;
+            const SvgCircle* circle = &shape->data.circle;
             int cx = (int)(circle->cx * zoom + offset_x);
             int cy = (int)(circle->cy * zoom + offset_y);
             int r = (int)(circle->r * zoom);
 
-            // Parse fill color
-            int r_col = 255, g_col = 255, b_col = 255;
-            if (circle->fill && strlen(circle->fill) > 1) {
-                sscanf(circle->fill + 1, "%2x%2x%2x", &r_col, &g_col, &b_col);
-            }
-
-            SDL_SetRenderDrawColor(renderer, r_col, g_col, b_col, 255);
+            if (shape->style->fill.kind == SVG_PAINT_NONE) break;
+            uint32_t color = svg_paint_to_rgb(&shape->style->fill, 0xFFFFFF);
+            SDL_SetRenderDrawColor(renderer, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
 
             // Draw filled circle using midpoint algorithm
             int x = 0, y = r;
@@ -159,7 +259,7 @@ void gui_draw_shape(SDL_Renderer* renderer, SvgShape* shape, int offset_x, int o
             break;
         }
         case SVG_SHAPE_RECT: {
-            SvgRect* rect = &shape->data.rect;
+            const SvgRect* rect = &shape->data.rect;
             SDL_Rect sdl_rect = {
                 (int)(rect->x * zoom + offset_x),
                 (int)(rect->y * zoom + offset_y),
@@ -167,23 +267,17 @@ void gui_draw_shape(SDL_Renderer* renderer, SvgShape* shape, int offset_x, int o
                 (int)(rect->height * zoom)
             };
 
-            int r_col = 255, g_col = 255, b_col = 255;
-            if (rect->fill && strlen(rect->fill) > 1) {
-                sscanf(rect->fill + 1, "%2x%2x%2x", &r_col, &g_col, &b_col);
-            }
-
-            SDL_SetRenderDrawColor(renderer, r_col, g_col, b_col, 255);
+            if (shape->style->fill.kind == SVG_PAINT_NONE) break;
+            uint32_t color = svg_paint_to_rgb(&shape->style->fill, 0xFFFFFF);
+            SDL_SetRenderDrawColor(renderer, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
             SDL_RenderFillRect(renderer, &sdl_rect);
             break;
         }
         case SVG_SHAPE_LINE: {
-            SvgLine* line = &shape->data.line;
-            int r_col = 0, g_col = 0, b_col = 0;
-            if (line->stroke && strlen(line->stroke) > 1) {
-                sscanf(line->stroke + 1, "%2x%2x%2x", &r_col, &g_col, &b_col);
-            }
-
-            SDL_SetRenderDrawColor(renderer, r_col, g_col, b_col, 255);
+            const SvgLine* line = &shape->data.line;
+            if (shape->style->stroke.kind == SVG_PAINT_NONE) break;
+            uint32_t color = svg_paint_to_rgb(&shape->style->stroke, 0x000000);
+            SDL_SetRenderDrawColor(renderer, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
             SDL_RenderDrawLine(renderer,
                             (int)(line->x1 * zoom + offset_x),
                             (int)(line->y1 * zoom + offset_y),
@@ -191,6 +285,14 @@ void gui_draw_shape(SDL_Renderer* renderer, SvgShape* shape, int offset_x, int o
                             (int)(line->y2 * zoom + offset_y));
             break;
         }
+        case SVG_SHAPE_POLYGON:
+        case SVG_SHAPE_POLYLINE: {
+            SvgMatrix view = {zoom, 0, 0, zoom, offset_x, offset_y};
+            gui_draw_poly(renderer, shape, &view);
+            break;
+        }
+        case SVG_SHAPE_USE:
+            break;
     }
 }
 
@@ -245,53 +347,14 @@ void gui_handle_events(GUIState* state, int* running) {
                             gui_add_shape_at_mouse(state, types[button_y]);
                         }
                     } else {
-                        // Check for shape selection
-                        state->selected_shape = -1;
+                        // Check for shape selection: the topmost shape under the mouse
+                        state->selected_shape = SVG_NO_SHAPE;
                         if (state->document) {
-                            SvgShape* current = state->document->shapes;
-                            int index = 0;
-                            while (current) {
-                                int hit = 0;
-                                float mx = (event.button.x - state->pan_x) / state->zoom;
-                                float my = (event.button.y - state->pan_y) / state->zoom;
-
-                                switch (current->type) {
-                                    case SVG_SHAPE_CIRCLE:
-                                        if ((mx - current->data.circle.cx) * (mx - current->data.circle.cx) +
-                                            (my - current->data.circle.cy) * (my - current->data.circle.cy) <=
-                                            current->data.circle.r * current->data.circle.r) {
-                                            hit = 1;
-                                        }
-                                        break;
-                                    case SVG_SHAPE_RECT:
-                                        if (mx >= current->data.rect.x && mx <= current->data.rect.x + current->data.rect.width &&
-                                            my >= current->data.rect.y && my <= current->data.rect.y + current->data.rect.height) {
-                                            hit = 1;
-                                        }
-                                        break;
-                                    case SVG_SHAPE_LINE:
-                                        // Simple line hit detection (could be improved)
-                                        double dist = fabs((current->data.line.y2 - current->data.line.y1) * mx -
-                                                         (current->data.line.x2 - current->data.line.x1) * my +
-                                                         current->data.line.x2 * current->data.line.y1 -
-                                                         current->data.line.y2 * current->data.line.x1) /
-                                                     sqrt((current->data.line.y2 - current->data.line.y1) *
-                                                           (current->data.line.y2 - current->data.line.y1) +
-                                                           (current->data.line.x2 - current->data.line.x1) *
-                                                           (current->data.line.x2 - current->data.line.x1));
-                                        if (dist < 5.0) hit = 1;
-                                        break;
-                                }
-
-                                if (hit) {
-                                    state->selected_shape = index;
-                                    state->dragging = 1;
-                                    break;
-                                }
-
-                                current = current->next;
-                                index++;
-                            }
+                            double mx = (event.button.x - state->pan_x) / state->zoom;
+                            double my = (event.button.y - state->pan_y) / state->zoom;
+                            state->selected_shape = svg_document_shape_at(state->document, mx, my, 5.0 / state->zoom);
+                            state->dragging = state->selected_shape != SVG_NO_SHAPE;
+                            state->points_copied = 0;
                         }
                     }
                 }
@@ -305,17 +368,22 @@ void gui_handle_events(GUIState* state, int* running) {
                 state->mouse_x = event.motion.x;
                 state->mouse_y = event.motion.y;
 
-                if (state->dragging && state->selected_shape >= 0 && state->document) {
-                    SvgShape* current = state->document->shapes;
-                    int index = 0;
-                    while (current && index < state->selected_shape) {
-                        current = current->next;
-                        index++;
-                    }
-                    if (current) {
+                if (state->dragging && state->document) {
+                    SvgShape shape;
+                    SvgShape* current = &shape;
+                    if (svg_document_get_shape(state->document, state->selected_shape, &shape) == 0) {
                         float dx = (event.motion.xrel) / state->zoom;
                         float dy = (event.motion.yrel) / state->zoom;
 
+                        // Move in the shape's own coordinates so it follows the mouse
+                        SvgMatrix inverse;
+                        if (current->transform && svg_matrix_invert(current->transform, &inverse) == 0) {
+                            float local_dx = (float)(inverse.a * dx + inverse.c * dy);
+                            float local_dy = (float)(inverse.b * dx + inverse.d * dy);
+                            dx = local_dx;
+                            dy = local_dy;
+                        }
+
                         switch (current->type) {
                             case SVG_SHAPE_CIRCLE:
                                 current->data.circle.cx += dx;
@@ -331,60 +399,45 @@ void gui_handle_events(GUIState* state, int* running) {
                                 current->data.line.x2 += dx;
                                 current->data.line.y2 += dy;
                                 break;
+                            case SVG_SHAPE_USE:
+                                current->data.use.x += dx;
+                                current->data.use.y += dy;
+                                break;
+                            case SVG_SHAPE_POLYGON:
+                            case SVG_SHAPE_POLYLINE:
+                                // The job's snapshot may still be reading the points: move a
+                                // copy of them, once per snapshot; with none alive, move them in place
+                                if (!state->points_copied && svg_atomic_add(&state->job.holding, 0) != 0) {
+                                    double* points = svg_document_new_points(state->document, current->data.poly.count);
+                                    if (!points) break;
+                                    memcpy(points, current->data.poly.points,
+                                           (size_t)current->data.poly.count * 2 * sizeof(double));
+                                    current->data.poly.points = points;
+                                    state->points_copied = 1;
+                                }
+                                for (int i = 0; i < current->data.poly.count; i++) {
+                                    current->data.poly.points[2 * i] += dx;
+                                    current->data.poly.points[2 * i + 1] += dy;
+                                }
+                                break;
                         }
+                        svg_document_set_shape(state->document, state->selected_shape, &shape);
                     }
                 }
                 break;
             case SDL_KEYDOWN:
                 switch (event.key.keysym.sym) {
                     case SDLK_DELETE:
-                        if (state->selected_shape >= 0 && state->document) {
-                            // Remove selected shape (simplified implementation)
-                            SvgShape* current = state->document->shapes;
-                            SvgShape* prev = NULL;
-                            int index = 0;
-                            while (current && index < state->selected_shape) {
-                                prev = current;
-                                current = current->next;
-                                index++;
-                            }
-                            if (current) {
-                                if (prev) prev->next = current->next;
-                                else state->document->shapes = current->next;
-                                
-                                // Free allocated strings
-                                switch (current->type) {
-                                    case SVG_SHAPE_CIRCLE:
-                                        if (current->data.circle.fill) free(current->data.circle.fill);
-                                        break;
-                                    case SVG_SHAPE_RECT:
-                                        if (current->data.rect.fill) free(current->data.rect.fill);
-                                        break;
-                                    case SVG_SHAPE_LINE:
-                                        if (current->data.line.stroke) free(current->data.line.stroke);
-                                        break;
-                                }
-                                
-                                free(current);
-                                state->selected_shape = -1;
-                                printf("Shape deleted\n");
-                            }
+                        if (state->document && svg_document_remove_shape(state->document, state->selected_shape) == 0) {
+                            state->selected_shape = SVG_NO_SHAPE;
+                            printf("Shape deleted\n");
                         }
                         break;
                     case SDLK_s:
-                        if (state->document) {
-                            char filename[256];
-                            time_t t = time(NULL);
-                            struct tm *tm_info = localtime(&t);
-                            snprintf(filename, sizeof(filename), "output_%04d%02d%02d_%02d%02d%02d.svg",
-                                   tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday,
-                                   tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec);
-                            if (svg_save_to_file(filename, state->document) == 0) {
-                                printf("Saved to %s\n", filename);
-                            } else {
-                                printf("Failed to save file\n");
-                            }
-                        }
+                        gui_start_job(state, 0);
+                        break;
+                    case SDLK_e:
+                        gui_start_job(state, 1);
                         break;
                     case SDLK_t:
                         state->show_toolbar = !state->show_toolbar;
@@ -398,51 +451,87 @@ void gui_handle_events(GUIState* state, int* running) {
     }
 }
 
+static void run_job(void* arg) {
+    GUIJob* job = (GUIJob*)arg;
+    int result = job->bmp ? export_to_bmp(job->filename, job->snapshot) : svg_save_to_file(job->filename, job->snapshot);
+    if (result == 0) {
+        printf("Saved to %s\n", job->filename);
+    } else {
+        printf("Failed to save file\n");
+    }
+    svg_snapshot_release(job->snapshot);
+    job->snapshot = NULL;
+    svg_atomic_add(&job->holding, -1);
+}
+
+// Save (or export) what the document looks like now; edits made meanwhile are not in the file
+void gui_start_job(GUIState* state, int bmp) {
+    if (!state->document) return;
+    svg_thread_join(&state->job.thread);
+
+    GUIJob* job = &state->job;
+    job->snapshot = svg_document_snapshot(state->document);
+    if (!job->snapshot) {
+        printf("Failed to save file\n");
+        return;
+    }
+    job->holding = 1;
+    state->points_copied = 0;
+    job->bmp = bmp;
+    time_t t = time(NULL);
+    struct tm *tm_info = localtime(&t);
+    snprintf(job->filename, sizeof(job->filename), "output_%04d%02d%02d_%02d%02d%02d.%s",
+           tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday,
+           tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec, bmp ? "bmp" : "svg");
+    if (svg_thread_start(&job->thread, run_job, job) != 0) run_job(job);
+}
+
 void gui_add_shape_at_mouse(GUIState* state, SvgShapeType type) {
     if (!state->document) {
         state->document = create_svg_document(800, 600);
     }
 
-    SvgShape* new_shape = (SvgShape*)malloc(sizeof(SvgShape));
-    if (!new_shape) return;
+    if (!state->document) return;
 
-    new_shape->type = type;
-    new_shape->next = NULL;
+    SvgShape shape;
+    SvgShape* new_shape = &shape;
+    memset(&shape, 0, sizeof(shape));
+    shape.type = type;
 
     float mx = (state->mouse_x - state->pan_x) / state->zoom;
     float my = (state->mouse_y - state->pan_y) / state->zoom;
+    SvgStyle style = svg_default_style;
 
     switch (type) {
         case SVG_SHAPE_CIRCLE:
             new_shape->data.circle.cx = mx;
             new_shape->data.circle.cy = my;
             new_shape->data.circle.r = 30.0f;
-            new_shape->data.circle.fill = strdup("#FF0000");
+            style.fill = svg_paint_rgb(0xFF0000);
             break;
         case SVG_SHAPE_RECT:
             new_shape->data.rect.x = mx - 25;
             new_shape->data.rect.y = my - 25;
             new_shape->data.rect.width = 50.0f;
             new_shape->data.rect.height = 50.0f;
-            new_shape->data.rect.fill = strdup("#00FF00");
+            style.fill = svg_paint_rgb(0x00FF00);
             break;
         case SVG_SHAPE_LINE:
             new_shape->data.line.x1 = mx - 25;
             new_shape->data.line.y1 = my - 25;
             new_shape->data.line.x2 = mx + 25;
             new_shape->data.line.y2 = my + 25;
-            new_shape->data.line.stroke = strdup("#0000FF");
+            style.stroke = svg_paint_rgb(0x0000FF);
+            break;
+        case SVG_SHAPE_USE:
+        case SVG_SHAPE_POLYGON:
+        case SVG_SHAPE_POLYLINE:
             break;
     }
+    new_shape->style = svg_document_intern_style(state->document, &style);
 
-    // Add to end of list
-    if (!state->document->shapes) {
-        state->document->shapes = new_shape;
-    } else {
-        SvgShape* current = state->document->shapes;
-        while (current->next) current = current->next;
-        current->next = new_shape;
-    }
+    // Drawn last, on top of everything
+    svg_document_add_shape(state->document, new_shape);
 }
 
 void run_gui(SvgDocument* doc) {
@@ -0,0 +1,367 @@
+#include "../include/svg_index.h"
+#include "../include/svg_store.h"
+#include "../include/svg_transform.h"
+#include "../include/svg_polygon.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SVG_INDEX_MAX_SIDE 4096 // cells along either axis; fits the uint16_t below
+#define SVG_INDEX_FIRST_ENTRIES 64
+
+// One shape in one cell; x0, y0 is the first cell of the shape, so a query
+// reports it from one cell only
+typedef struct {
+    uint32_t position;
+    uint32_t next;//entry + 1, 0 at the end of the list
+    uint16_t x0, y0;
+} SvgIndexEntry;
+
+struct SvgShapeIndex {
+    double x, y;//document position of cell (0, 0)
+    double cell_width, cell_height;
+    int columns, rows;
+    uint32_t *cells;//first entry + 1 per cell, then the list of shapes too big for cells
+    SvgIndexEntry *entries;
+    size_t entry_count, entry_capacity;
+    uint32_t free_entry;//entry + 1
+    size_t shapes, sized_for;
+};
+
+static int cell_of(double v, double origin, double size, int count) {
+    double cell = (v - origin) / size;
+    if (!(cell > 0.0)) return 0; // NaN too
+    if (cell >= count) return count - 1;
+    return (int)cell;
+}
+
+// Cells a box reaches, clamped to the grid
+static void cell_range(const SvgShapeIndex *index, const double box[4], int range[4]) {
+    range[0] = cell_of(box[0], index->x, index->cell_width, index->columns);
+    range[1] = cell_of(box[1], index->y, index->cell_height, index->rows);
+    range[2] = cell_of(box[2], index->x, index->cell_width, index->columns);
+    range[3] = cell_of(box[3], index->y, index->cell_height, index->rows);
+}
+
+// Whether the shape goes on the shared list rather than into cells
+static int is_big(const SvgShapeIndex *index, const double box[4], int range[4]) {
+    if (isnan(box[0]) || isnan(box[1]) || isnan(box[2]) || isnan(box[3])) return 1;
+    cell_range(index, box, range);
+    return (size_t)(range[2] - range[0] + 1) * (size_t)(range[3] - range[1] + 1) > SVG_INDEX_MAX_CELLS;
+}
+
+// A waiting lazy shape has empty bounds and is not in the grid
+static int is_empty(const double box[4]) {
+    return box[0] > box[2] || box[1] > box[3];
+}
+
+static int push_entry(SvgShapeIndex *index, uint32_t *list, uint32_t position, int x0, int y0) {
+    uint32_t entry;
+    if (index->free_entry) {
+        entry = index->free_entry - 1;
+        index->free_entry = index->entries[entry].next;
+    } else {
+        if (index->entry_count == index->entry_capacity) {
+            if (index->entry_count >= UINT32_MAX - 1) return -1;
+            size_t capacity = index->entry_capacity ? index->entry_capacity * 2 : SVG_INDEX_FIRST_ENTRIES;
+            SvgIndexEntry *entries = (SvgIndexEntry *)realloc(index->entries, capacity * sizeof(SvgIndexEntry));
+            if (!entries) return -1;
+            index->entries = entries;
+            index->entry_capacity = capacity;
+        }
+        entry = (uint32_t)index->entry_count++;
+    }
+    SvgIndexEntry *e = &index->entries[entry];
+    e->position = position;
+    e->x0 = (uint16_t)x0;
+    e->y0 = (uint16_t)y0;
+    e->next = *list;
+    *list = entry + 1;
+    return 0;
+}
+
+static void drop_entry(SvgShapeIndex *index, uint32_t *list, uint32_t position) {
+    for (uint32_t *link = list; *link; link = &index->entries[*link - 1].next) {
+        SvgIndexEntry *e = &index->entries[*link - 1];
+        if (e->position != position) continue;
+        uint32_t entry = *link - 1;
+        *link = e->next;
+        e->next = index->free_entry;
+        index->free_entry = entry + 1;
+        return;
+    }
+}
+
+static uint32_t *big_list(const SvgShapeIndex *index) {
+    return &index->cells[(size_t)index->columns * index->rows];
+}
+
+static int add_shape(SvgShapeIndex *index, uint32_t position, const double box[4]) {
+    int range[4];
+    if (is_empty(box)) return 0;
+    if (is_big(index, box, range)) return push_entry(index, big_list(index), position, 0, 0);
+    for (int y = range[1]; y <= range[3]; y++) {
+        for (int x = range[0]; x <= range[2]; x++) {
+            if (push_entry(index, &index->cells[(size_t)y * index->columns + x], position, range[0], range[1]) != 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+// Copy every list into one stretch of entries, cell by cell, so a query reads
+// neighbouring cells from neighbouring memory
+static int relayout(SvgShapeIndex *index) {
+    SvgIndexEntry *entries = (SvgIndexEntry *)malloc((index->entry_count ? index->entry_count : 1) *
+                                                     sizeof(SvgIndexEntry));
+    if (!entries) return -1;
+    size_t cell_count = (size_t)index->columns * index->rows + 1, used = 0;
+    for (size_t c = 0; c < cell_count; c++) {
+        uint32_t *link = &index->cells[c];
+        for (uint32_t e = *link; e; e = index->entries[e - 1].next) {
+            entries[used] = index->entries[e - 1];
+            *link = (uint32_t)++used;
+            link = &entries[used - 1].next;
+        }
+        *link = 0;
+    }
+    free(index->entries);
+    index->entries = entries;
+    index->entry_count = index->entry_capacity = used;
+    index->free_entry = 0;
+    return 0;
+}
+
+SvgShapeIndex *svg_index_build(const SvgShapeStore *store) {
+    SvgShapeIndex *index = (SvgShapeIndex *)calloc(1, sizeof(SvgShapeIndex));
+    if (!index) return NULL;
+
+    // Cells come from the spread of the shapes and their average size, so a
+    // typical shape reaches a few cells and a cell holds about one shape
+    double extent[4] = {HUGE_VAL, HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+    double widths = 0.0, heights = 0.0;
+    size_t shapes = 0, sized = 0;
+    for (size_t i = 0; i < store->count; i++) {
+        const double *box = store->bounds[i];
+        if (store->items[i].type == SVG_STORE_REMOVED || is_empty(box)) continue;
+        shapes++;
+        if (!isfinite(box[0]) || !isfinite(box[1]) || !isfinite(box[2]) || !isfinite(box[3])) continue;
+        if (box[0] < extent[0]) extent[0] = box[0];
+        if (box[1] < extent[1]) extent[1] = box[1];
+        if (box[2] > extent[2]) extent[2] = box[2];
+        if (box[3] > extent[3]) extent[3] = box[3];
+        widths += box[2] - box[0];
+        heights += box[3] - box[1];
+        sized++;
+    }
+    double width = sized ? extent[2] - extent[0] : 0.0, height = sized ? extent[3] - extent[1] : 0.0;
+    double side = sized ? sqrt(width * height / (double)sized) : 0.0;
+    if (sized && width * height == 0.0) side = (width > height ? width : height) / (double)sized;
+    if (sized && side < widths / sized) side = widths / sized;
+    if (sized && side < heights / sized) side = heights / sized;
+    if (!(side > 0.0) || !isfinite(side)) side = 1.0;
+
+    double columns = floor(width / side) + 1.0, rows = floor(height / side) + 1.0;
+    index->columns = columns < SVG_INDEX_MAX_SIDE ? (int)columns : SVG_INDEX_MAX_SIDE;
+    index->rows = rows < SVG_INDEX_MAX_SIDE ? (int)rows : SVG_INDEX_MAX_SIDE;
+    index->x = sized ? extent[0] : 0.0;
+    index->y = sized ? extent[1] : 0.0;
+    index->cell_width = width / index->columns > side ? width / index->columns : side;
+    index->cell_height = height / index->rows > side ? height / index->rows : side;
+    index->sized_for = shapes > SVG_INDEX_FIRST_ENTRIES ? shapes : SVG_INDEX_FIRST_ENTRIES;
+
+    index->cells = (uint32_t *)calloc((size_t)index->columns * index->rows + 1, sizeof(uint32_t));
+    if (!index->cells) {
+        svg_index_free(index);
+        return NULL;
+    }
+    for (size_t i = 0; i < store->count; i++) {
+        if (store->items[i].type == SVG_STORE_REMOVED) continue;
+        if (add_shape(index, (uint32_t)i, store->bounds[i]) != 0) {
+            svg_index_free(index);
+            return NULL;
+        }
+        if (!is_empty(store->bounds[i])) index->shapes++;
+    }
+    if (relayout(index) != 0) {
+        svg_index_free(index);
+        return NULL;
+    }
+    return index;
+}
+
+void svg_index_free(SvgShapeIndex *index) {
+    if (!index) return;
+    free(index->cells);
+    free(index->entries);
+    free(index);
+}
+
+int svg_index_insert(SvgShapeIndex *index, size_t position, const double box[4]) {
+    if (is_empty(box)) return 0;
+    if (position >= UINT32_MAX || ++index->shapes > index->sized_for * 2) return -1;
+    return add_shape(index, (uint32_t)position, box);
+}
+
+void svg_index_remove(SvgShapeIndex *index, size_t position, const double box[4]) {
+    int range[4];
+    if (is_empty(box)) return;
+    index->shapes--;
+    if (is_big(index, box, range)) {
+        drop_entry(index, big_list(index), (uint32_t)position);
+        return;
+    }
+    for (int y = range[1]; y <= range[3]; y++) {
+        for (int x = range[0]; x <= range[2]; x++)
+            drop_entry(index, &index->cells[(size_t)y * index->columns + x], (uint32_t)position);
+    }
+}
+
+// Called once per shape near rect; inside is set when its bounds are known to meet rect
+typedef void (*SvgIndexVisit)(void *ctx, uint32_t position, int inside);
+
+// Every shape in the cells rect reaches, and every big one, once each
+static void visit_rect(const SvgShapeIndex *index, const double rect[4], SvgIndexVisit visit, void *ctx) {
+    for (uint32_t e = *big_list(index); e; e = index->entries[e - 1].next)
+        visit(ctx, index->entries[e - 1].position, 0);
+
+    int range[4];
+    cell_range(index, rect, range);
+    for (int y = range[1]; y <= range[3]; y++) {
+        const uint32_t *row = &index->cells[(size_t)y * index->columns];
+        for (int x = range[0]; x <= range[2]; x++) {
+            // A shape that reaches a cell wholly inside rect meets it; only the
+            // border cells need its bounds checked
+            int inside = x > range[0] && x < range[2] && y > range[1] && y < range[3];
+            for (uint32_t e = row[x]; e; e = index->entries[e - 1].next) {
+                const SvgIndexEntry *entry = &index->entries[e - 1];
+                // Reported where the shape's cells and the query's first meet
+                if ((entry->x0 == x || x == range[0]) && (entry->y0 == y || y == range[1]))
+                    visit(ctx, entry->position, inside);
+            }
+        }
+    }
+}
+
+// Bounds that do not miss rect; NaN bounds meet everything, as the renderers draw them
+static int meets(const double box[4], const double rect[4]) {
+    return !(box[2] < rect[0] || box[0] > rect[2] || box[3] < rect[1] || box[1] > rect[3]);
+}
+
+typedef struct {
+    const SvgShapeStore *store;
+    const double *rect;
+    SvgShapeQuery *query;
+    int failed;
+} SvgRectSearch;
+
+// Positions are gathered in the handle array, then sorted and made handles
+static void collect(void *ctx, uint32_t position, int inside) {
+    SvgRectSearch *search = (SvgRectSearch *)ctx;
+    SvgShapeQuery *query = search->query;
+    if (search->failed || (!inside && !meets(search->store->bounds[position], search->rect))) return;
+    if (query->count == query->capacity) {
+        size_t capacity = query->capacity ? query->capacity * 2 : SVG_INDEX_FIRST_ENTRIES;
+        SvgShapeHandle *handles = (SvgShapeHandle *)realloc(query->handles, capacity * sizeof(SvgShapeHandle));
+        if (!handles) {
+            search->failed = 1;
+            return;
+        }
+        query->handles = handles;
+        query->capacity = capacity;
+    }
+    query->handles[query->count++] = position;
+}
+
+static int compare_positions(const void *a, const void *b) {
+    SvgShapeHandle x = *(const SvgShapeHandle *)a, y = *(const SvgShapeHandle *)b;
+    return x < y ? -1 : x > y;
+}
+
+int svg_index_query(const SvgShapeIndex *index, const SvgShapeStore *store, const double rect[4],
+                    SvgShapeQuery *query) {
+    SvgRectSearch search = {store, rect, query, 0};
+    query->count = 0;
+    visit_rect(index, rect, collect, &search);
+    if (search.failed) {
+        query->count = 0;
+        return -1;
+    }
+    if (query->count) qsort(query->handles, query->count, sizeof(SvgShapeHandle), compare_positions);
+    for (size_t i = 0; i < query->count; i++) query->handles[i] = svg_store_handle(store, (size_t)query->handles[i]);
+    return 0;
+}
+
+// The GUI's picking rules, in document coordinates
+static int shape_hit(const SvgShape *shape, double x, double y, double tolerance) {
+    if (shape->type == SVG_SHAPE_LINE) {
+        // Distance to the segment where it is drawn
+        double x1, y1, x2, y2;
+        svg_matrix_apply(shape->transform, shape->data.line.x1, shape->data.line.y1, &x1, &y1);
+        svg_matrix_apply(shape->transform, shape->data.line.x2, shape->data.line.y2, &x2, &y2);
+        double dx = x2 - x1, dy = y2 - y1, length = dx * dx + dy * dy;
+        double t = length > 0.0 ? ((x - x1) * dx + (y - y1) * dy) / length : 0.0;
+        if (t < 0.0) t = 0.0;
+        if (t > 1.0) t = 1.0;
+        double ex = x1 + t * dx - x, ey = y1 + t * dy - y;
+        return ex * ex + ey * ey <= tolerance * tolerance;
+    }
+
+    // Everything else is tested in the shape's own coordinates
+    if (shape->transform) {
+        SvgMatrix inverse;
+        if (svg_matrix_invert(shape->transform, &inverse) != 0) return 0;
+        svg_matrix_apply(&inverse, x, y, &x, &y);
+    }
+    switch (shape->type) {
+        case SVG_SHAPE_CIRCLE: {
+            const SvgCircle *c = &shape->data.circle;
+            return (x - c->cx) * (x - c->cx) + (y - c->cy) * (y - c->cy) <= c->r * c->r;
+        }
+        case SVG_SHAPE_RECT: {
+            const SvgRect *r = &shape->data.rect;
+            return x >= r->x && x <= r->x + r->width && y >= r->y && y <= r->y + r->height;
+        }
+        case SVG_SHAPE_POLYGON:
+            return svg_polygon_contains(shape->data.poly.points, shape->data.poly.count,
+                                        shape->style->fill_rule == SVG_FILL_RULE_EVENODD, x, y);
+        case SVG_SHAPE_POLYLINE:
+        case SVG_SHAPE_USE: {
+            SvgShape local = *shape;
+            local.transform = NULL;
+            double box[4];
+            svg_shape_bounds(&local, box);
+            return x >= box[0] && x <= box[2] && y >= box[1] && y <= box[3];
+        }
+        case SVG_SHAPE_LINE:
+            break;
+    }
+    return 0;
+}
+
+typedef struct {
+    const SvgShapeStore *store;
+    double x, y, tolerance;
+    size_t best;//position + 1 of the topmost hit so far
+} SvgPointSearch;
+
+static void pick(void *ctx, uint32_t position, int inside) {
+    SvgPointSearch *search = (SvgPointSearch *)ctx;
+    const double *box = search->store->bounds[position];
+    (void)inside;
+    if (position + 1 <= search->best) return;
+    if (!(search->x >= box[0] - search->tolerance && search->x <= box[2] + search->tolerance &&
+          search->y >= box[1] - search->tolerance && search->y <= box[3] + search->tolerance))
+        return;
+    SvgShape shape;
+    svg_store_get(search->store, position, &shape);
+    if (shape_hit(&shape, search->x, search->y, search->tolerance)) search->best = position + 1;
+}
+
+SvgShapeHandle svg_index_shape_at(const SvgShapeIndex *index, const SvgShapeStore *store,
+                                  double x, double y, double tolerance) {
+    SvgPointSearch search = {store, x, y, tolerance, 0};
+    double rect[4] = {x - tolerance, y - tolerance, x + tolerance, y + tolerance};
+    visit_rect(index, rect, pick, &search);
+    return search.best ? svg_store_handle(store, search.best - 1) : SVG_NO_SHAPE;
+}
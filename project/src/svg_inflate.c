@@ -0,0 +1,395 @@
+#include "../include/svg_inflate.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUT_SIZE (64 * 1024)
+#define HISTORY_SIZE (32 * 1024) // farthest a deflate match can reach back
+#define HISTORY_MASK (HISTORY_SIZE - 1)
+#define FAST_MASK ((1u << SVG_INFLATE_FAST_BITS) - 1)
+
+enum {
+    STATE_HEADER,//gzip member header
+    STATE_BLOCK,//next deflate block header
+    STATE_STORED,//copying an uncompressed block
+    STATE_CODES,//decoding a Huffman-coded block
+    STATE_TRAILER,//CRC-32 and length of the member
+    STATE_DONE
+};
+
+static const uint16_t length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                         35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                         3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t dist_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                       257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                       8193, 12289, 16385, 24577};
+static const uint8_t dist_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                       7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+int svg_inflate_is_gzip(const unsigned char *data, size_t size) {
+    return size >= 2 && data[0] == SVG_GZIP_ID1 && data[1] == SVG_GZIP_ID2;
+}
+
+int svg_inflate_is_gzip_file(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    unsigned char magic[2];
+    size_t n = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+    return svg_inflate_is_gzip(magic, n);
+}
+
+// ---- bit input ----
+
+static int next_byte(SvgInflate *z) {
+    if (z->input_pos == z->input_len) {
+        z->input_pos = 0;
+        z->input_len = fread(z->input, 1, INPUT_SIZE, z->file);
+        if (z->input_len == 0) return -1;
+    }
+    return z->input[z->input_pos++];
+}
+
+// Make at least need (<= 24) bits available; past the end of the file zero
+// bytes are fed in and counted, so running out is detected by truncated()
+static void need_bits(SvgInflate *z, int need) {
+    while (z->bit_count < need) {
+        int byte = next_byte(z);
+        if (byte < 0) {
+            z->overrun++;
+            byte = 0;
+        }
+        z->bits |= (uint32_t)byte << z->bit_count;
+        z->bit_count += 8;
+    }
+}
+
+static unsigned get_bits(SvgInflate *z, int n) {
+    need_bits(z, n);
+    unsigned value = z->bits & ((1u << n) - 1);
+    z->bits >>= n;
+    z->bit_count -= n;
+    return value;
+}
+
+// Some of the zero padding has been consumed: the input ended too early
+static int truncated(const SvgInflate *z) {
+    return z->overrun && (size_t)z->bit_count < z->overrun * 8;
+}
+
+// Real input remains (bits in the buffer or bytes in the file)
+static int more_input(SvgInflate *z) {
+    if ((size_t)z->bit_count > z->overrun * 8) return 1;
+    if (z->overrun) return 0;
+    int byte = next_byte(z);
+    if (byte < 0) return 0;
+    z->input_pos--;
+    return 1;
+}
+
+static void align_to_byte(SvgInflate *z) {
+    get_bits(z, z->bit_count & 7);
+}
+
+// ---- Huffman codes ----
+
+static unsigned reverse_bits(unsigned code, int len) {
+    unsigned r = 0;
+    for (int i = 0; i < len; i++) {
+        r = (r << 1) | (code & 1);
+        code >>= 1;
+    }
+    return r;
+}
+
+// Build the code for n symbols from their code lengths (0 = unused)
+static int build_huffman(SvgHuffman *h, const uint8_t *lengths, int n) {
+    memset(h->count, 0, sizeof(h->count));
+    for (int i = 0; i < n; i++) h->count[lengths[i]]++;
+    h->count[0] = 0;
+
+    // Over-subscribed lengths cannot form a prefix code
+    int left = 1;
+    for (int len = 1; len < 16; len++) {
+        left = (left << 1) - h->count[len];
+        if (left < 0) return -1;
+    }
+
+    short offsets[16];
+    offsets[1] = 0;
+    for (int len = 1; len < 15; len++) offsets[len + 1] = offsets[len] + h->count[len];
+    for (int i = 0; i < n; i++) {
+        if (lengths[i]) h->symbol[offsets[lengths[i]]++] = (short)i;
+    }
+
+    // Canonical codes are assigned in symbol order within each length; deflate
+    // sends them most significant bit first, so the table is indexed reversed
+    memset(h->fast, 0, sizeof(h->fast));
+    unsigned code = 0;
+    int index = 0;
+    for (int len = 1; len <= SVG_INFLATE_FAST_BITS; len++) {
+        for (int k = 0; k < h->count[len]; k++, code++) {
+            uint16_t entry = (uint16_t)(h->symbol[index++] << 4 | len);
+            for (unsigned fill = reverse_bits(code, len); fill <= FAST_MASK; fill += 1u << len)
+                h->fast[fill] = entry;
+        }
+        code <<= 1;
+    }
+    return 0;
+}
+
+// Next symbol, or -1 for a code that is not in the table
+static int decode(SvgInflate *z, const SvgHuffman *h) {
+    need_bits(z, 15);
+    unsigned entry = h->fast[z->bits & FAST_MASK];
+    if (entry) {
+        z->bits >>= entry & 15;
+        z->bit_count -= entry & 15;
+        return (int)(entry >> 4);
+    }
+
+    // Long code: walk the canonical code one bit at a time
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len < 16; len++) {
+        code |= (z->bits >> (len - 1)) & 1;
+        int count = h->count[len];
+        if (code - first < count) {
+            z->bits >>= len;
+            z->bit_count -= len;
+            return h->symbol[index + code - first];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static void build_fixed(SvgInflate *z) {
+    uint8_t lengths[288];
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+    build_huffman(&z->lengths, lengths, 288);
+    memset(lengths, 5, 30);
+    build_huffman(&z->distances, lengths, 30);
+}
+
+static int read_dynamic(SvgInflate *z) {
+    static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    uint8_t lengths[286 + 30];
+
+    int nlen = (int)get_bits(z, 5) + 257;
+    int ndist = (int)get_bits(z, 5) + 1;
+    int ncode = (int)get_bits(z, 4) + 4;
+    if (nlen > 286 || ndist > 30) return -1;
+
+    memset(lengths, 0, 19);
+    for (int i = 0; i < ncode; i++) lengths[order[i]] = (uint8_t)get_bits(z, 3);
+    if (truncated(z) || build_huffman(&z->lengths, lengths, 19) != 0) return -1;
+
+    // Literal/length and distance code lengths, run-length coded
+    int index = 0;
+    while (index < nlen + ndist) {
+        int sym = decode(z, &z->lengths);
+        if (sym < 0 || truncated(z)) return -1;
+        if (sym < 16) {
+            lengths[index++] = (uint8_t)sym;
+            continue;
+        }
+        uint8_t len = 0;
+        int repeat;
+        if (sym == 16) {
+            if (index == 0) return -1;
+            len = lengths[index - 1];
+            repeat = 3 + (int)get_bits(z, 2);
+        } else if (sym == 17) {
+            repeat = 3 + (int)get_bits(z, 3);
+        } else {
+            repeat = 11 + (int)get_bits(z, 7);
+        }
+        if (index + repeat > nlen + ndist) return -1;
+        while (repeat--) lengths[index++] = len;
+    }
+
+    if (lengths[256] == 0) return -1; // no end-of-block code
+    if (build_huffman(&z->lengths, lengths, nlen) != 0) return -1;
+    return build_huffman(&z->distances, lengths + nlen, ndist);
+}
+
+// ---- gzip framing ----
+
+static int read_header(SvgInflate *z) {
+    if (get_bits(z, 8) != SVG_GZIP_ID1 || get_bits(z, 8) != SVG_GZIP_ID2) return -1;
+    if (get_bits(z, 8) != 8) return -1; // only deflate is defined
+    unsigned flags = get_bits(z, 8);
+    if (flags & 0xE0) return -1;
+    for (int i = 0; i < 6; i++) get_bits(z, 8); // mtime, extra flags, OS
+
+    if (flags & 4) { // FEXTRA
+        unsigned len = get_bits(z, 16);
+        while (len-- && !truncated(z)) get_bits(z, 8);
+    }
+    if (flags & 8) { // FNAME
+        while (get_bits(z, 8) != 0 && !truncated(z)) {}
+    }
+    if (flags & 16) { // FCOMMENT
+        while (get_bits(z, 8) != 0 && !truncated(z)) {}
+    }
+    if (flags & 2) get_bits(z, 16); // FHCRC
+    return truncated(z) ? -1 : 0;
+}
+
+static uint32_t update_crc(const SvgInflate *z, uint32_t crc, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        crc = z->crc_table[(crc ^ (unsigned char)data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+int svg_inflate_init(SvgInflate *z, FILE *file, const unsigned char *prefix, size_t prefix_len) {
+    memset(z, 0, sizeof(*z));
+    z->input = (unsigned char *)malloc(INPUT_SIZE + HISTORY_SIZE);
+    if (!z->input) return -1;
+    z->history = z->input + INPUT_SIZE;
+    z->file = file;
+    if (prefix_len > INPUT_SIZE) prefix_len = INPUT_SIZE;
+    memcpy(z->input, prefix, prefix_len);
+    z->input_len = prefix_len;
+    z->state = STATE_HEADER;
+
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        z->crc_table[n] = c;
+    }
+    return 0;
+}
+
+void svg_inflate_release(SvgInflate *z) {
+    free(z->input);
+    z->input = NULL;
+    z->history = NULL;
+}
+
+// Literals and matches of a Huffman block into out[n, cap); returns the new n or -1
+static long inflate_codes(SvgInflate *z, char *out, size_t n, size_t cap) {
+    unsigned char *history = z->history;
+    while (n < cap) {
+        if (z->copy_len) {
+            // Finish a match, possibly one cut short by the previous call
+            while (z->copy_len && n < cap) {
+                unsigned char byte = history[(z->pos - z->copy_dist) & HISTORY_MASK];
+                history[z->pos++ & HISTORY_MASK] = byte;
+                out[n++] = (char)byte;
+                z->copy_len--;
+            }
+            continue;
+        }
+
+        int sym = decode(z, &z->lengths);
+        if (sym < 0) return -1;
+        if (sym < 256) {
+            history[z->pos++ & HISTORY_MASK] = (unsigned char)sym;
+            out[n++] = (char)sym;
+        } else if (sym == 256) {
+            z->state = STATE_BLOCK;
+            break;
+        } else {
+            sym -= 257;
+            if (sym >= 29) return -1;
+            unsigned len = length_base[sym] + get_bits(z, length_extra[sym]);
+            int dsym = decode(z, &z->distances);
+            if (dsym < 0 || dsym >= 30) return -1;
+            unsigned dist = dist_base[dsym] + get_bits(z, dist_extra[dsym]);
+            if (dist > z->pos) return -1; // reaches before the start of the member
+            z->copy_len = len;
+            z->copy_dist = dist;
+        }
+        if (truncated(z)) return -1;
+    }
+    return (long)n;
+}
+
+long svg_inflate_read(SvgInflate *z, char *out, size_t cap) {
+    size_t n = 0;
+    size_t mark = 0; // out[mark, n) is not in the CRC yet
+
+    while (n < cap && z->state != STATE_DONE) {
+        switch (z->state) {
+            case STATE_HEADER:
+                if (read_header(z) != 0) return -1;
+                z->crc = 0xFFFFFFFFu;
+                z->size = 0;
+                z->pos = 0;
+                z->final = 0;
+                z->state = STATE_BLOCK;
+                break;
+
+            case STATE_BLOCK: {
+                if (z->final) {
+                    z->state = STATE_TRAILER;
+                    break;
+                }
+                z->final = (int)get_bits(z, 1);
+                unsigned type = get_bits(z, 2);
+                if (type == 0) {
+                    align_to_byte(z);
+                    unsigned len = get_bits(z, 16);
+                    if (len != (~get_bits(z, 16) & 0xFFFF)) return -1;
+                    z->stored_left = len;
+                    z->state = STATE_STORED;
+                } else if (type == 1) {
+                    build_fixed(z);
+                    z->state = STATE_CODES;
+                } else if (type == 2) {
+                    if (read_dynamic(z) != 0) return -1;
+                    z->state = STATE_CODES;
+                } else {
+                    return -1;
+                }
+                if (truncated(z)) return -1;
+                break;
+            }
+
+            case STATE_STORED:
+                while (z->stored_left && n < cap) {
+                    unsigned char byte = (unsigned char)get_bits(z, 8);
+                    z->history[z->pos++ & HISTORY_MASK] = byte;
+                    out[n++] = (char)byte;
+                    z->stored_left--;
+                }
+                if (truncated(z)) return -1;
+                if (!z->stored_left) z->state = STATE_BLOCK;
+                break;
+
+            case STATE_CODES: {
+                long result = inflate_codes(z, out, n, cap);
+                if (result < 0) return -1;
+                n = (size_t)result;
+                break;
+            }
+
+            case STATE_TRAILER: {
+                z->crc = update_crc(z, z->crc, out + mark, n - mark);
+                z->size += (uint32_t)(n - mark);
+                mark = n;
+
+                align_to_byte(z);
+                uint32_t crc = get_bits(z, 16);
+                crc |= (uint32_t)get_bits(z, 16) << 16;
+                uint32_t size = get_bits(z, 16);
+                size |= (uint32_t)get_bits(z, 16) << 16;
+                if (truncated(z) || crc != ~z->crc || size != z->size) return -1;
+
+                // Concatenated members decode as one stream
+                z->state = more_input(z) ? STATE_HEADER : STATE_DONE;
+                break;
+            }
+        }
+    }
+
+    z->crc = update_crc(z, z->crc, out + mark, n - mark);
+    z->size += (uint32_t)(n - mark);
+    return (long)n;
+}
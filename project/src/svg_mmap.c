@@ -0,0 +1,120 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "../include/svg_mmap.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+int svg_map_file(const char *filename, SvgMappedFile *out) {
+    out->data = NULL;
+    out->size = 0;
+    out->mapping = NULL;
+    out->file = NULL;
+
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "Error: Cannot open file %s\n", filename);
+        return -1;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return -1;
+    }
+    out->file = file;
+
+    // CreateFileMapping refuses zero-length files, an empty view is fine
+    if (size.QuadPart == 0) return 0;
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        out->file = NULL;
+        return -1;
+    }
+
+    const char *view = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        out->file = NULL;
+        return -1;
+    }
+
+    out->data = view;
+    out->size = (size_t)size.QuadPart;
+    out->mapping = mapping;
+    return 0;
+}
+
+void svg_unmap_file(SvgMappedFile *mapped) {
+    if (!mapped) return;
+    if (mapped->data) UnmapViewOfFile((LPCVOID)mapped->data);
+    if (mapped->mapping) CloseHandle((HANDLE)mapped->mapping);
+    if (mapped->file) CloseHandle((HANDLE)mapped->file);
+    mapped->data = NULL;
+    mapped->size = 0;
+    mapped->mapping = NULL;
+    mapped->file = NULL;
+}
+
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+int svg_map_file(const char *filename, SvgMappedFile *out) {
+    out->data = NULL;
+    out->size = 0;
+    out->mapping = NULL;
+    out->file = NULL;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open file %s\n", filename);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // mmap refuses zero-length files, an empty view is fine
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps its own reference to the file
+    if (view == MAP_FAILED) {
+        fprintf(stderr, "Error: Cannot map file %s\n", filename);
+        return -1;
+    }
+
+    // The parser reads front to back exactly once
+    posix_madvise(view, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    out->data = (const char *)view;
+    out->size = (size_t)st.st_size;
+    out->mapping = view;
+    return 0;
+}
+
+void svg_unmap_file(SvgMappedFile *mapped) {
+    if (!mapped) return;
+    if (mapped->mapping) munmap(mapped->mapping, mapped->size);
+    mapped->data = NULL;
+    mapped->size = 0;
+    mapped->mapping = NULL;
+    mapped->file = NULL;
+}
+#endif
@@ -0,0 +1,122 @@
+#include "../include/svg_number.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+
+// Every power of ten up to 1e22 is exactly representable as a double
+static const double exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_EXACT_MANTISSA ((uint64_t)1 << 53)
+#define MAX_MANTISSA_DIGITS 19
+
+// Slow path for inputs the exact fast path cannot handle: hand the number to
+// strtod, swapping '.' for the locale's radix character so the result stays
+// locale-independent. strtod is correctly rounded on the supported libcs.
+static double parse_slow(const char *s, size_t len) {
+    char stack[128];
+    char *copy = len < sizeof(stack) ? stack : (char *)malloc(len + 1);
+    if (!copy) return 0.0;
+
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+
+    const char *radix = localeconv()->decimal_point;
+    if (radix && radix[0] && radix[0] != '.' && radix[1] == '\0') {
+        char *dot = memchr(copy, '.', len);
+        if (dot) *dot = radix[0];
+    }
+
+    double value = strtod(copy, NULL);
+    if (copy != stack) free(copy);
+    return value;
+}
+
+const char *svg_parse_number(const char *s, const char *end, double *out) {
+    const char *p = s;
+    int negative = 0;
+    uint64_t mantissa = 0;
+    int digits = 0;//significant digits kept in mantissa
+    int dropped = 0;//non-zero significant digits that did not fit
+    int exponent = 0;
+    int any_digit = 0;
+
+    if (p < end && (*p == '+' || *p == '-')) negative = (*p++ == '-');
+
+    // Integer part; leading zeros are not significant
+    for (; p < end && (unsigned)(*p - '0') < 10; p++) {
+        any_digit = 1;
+        if (digits < MAX_MANTISSA_DIGITS) {
+            mantissa = mantissa * 10 + (unsigned)(*p - '0');
+            if (mantissa) digits++;
+        } else {
+            exponent++;
+            if (*p != '0') dropped = 1;
+        }
+    }
+
+    // Fraction part
+    if (p < end && *p == '.') {
+        const char *frac = p + 1;
+        for (p = frac; p < end && (unsigned)(*p - '0') < 10; p++) {
+            if (digits < MAX_MANTISSA_DIGITS) {
+                mantissa = mantissa * 10 + (unsigned)(*p - '0');
+                if (mantissa) digits++;
+                exponent--;
+            } else if (*p != '0') {
+                dropped = 1;
+            }
+        }
+        if (p > frac) any_digit = 1;
+    }
+
+    if (!any_digit) return s;
+
+    // Exponent, only consumed when at least one digit follows
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *e = p + 1;
+        int exp_negative = 0;
+        if (e < end && (*e == '+' || *e == '-')) exp_negative = (*e++ == '-');
+        if (e < end && (unsigned)(*e - '0') < 10) {
+            int exp_value = 0;
+            for (; e < end && (unsigned)(*e - '0') < 10; e++) {
+                if (exp_value < 100000) exp_value = exp_value * 10 + (*e - '0');
+            }
+            exponent += exp_negative ? -exp_value : exp_value;
+            p = e;
+        }
+    }
+
+    double value;
+    if (mantissa == 0) {
+        value = 0.0;
+    } else if (!dropped && mantissa <= MAX_EXACT_MANTISSA && exponent >= -22 && exponent <= 22) {
+        // Both operands are exact, so one IEEE operation rounds correctly
+        value = (double)mantissa;
+        if (exponent < 0) value /= exact_pow10[-exponent];
+        else value *= exact_pow10[exponent];
+    } else if (!dropped && exponent > 22 && exponent <= 22 + 15 &&
+               mantissa <= MAX_EXACT_MANTISSA / (uint64_t)exact_pow10[exponent - 22]) {
+        // Shift surplus powers into the mantissa while it stays exact
+        value = (double)(mantissa * (uint64_t)exact_pow10[exponent - 22]) * exact_pow10[22];
+    } else {
+        value = parse_slow(s, (size_t)(p - s));
+        *out = value;
+        return p;
+    }
+
+    *out = negative ? -value : value;
+    return p;
+}
+
+double svg_number_from_slice(const char *s, size_t len) {
+    const char *end = s + len;
+    while (s < end && (unsigned char)*s <= 0x20) s++;
+
+    double value = 0.0;
+    svg_parse_number(s, end, &value);
+    return value;
+}
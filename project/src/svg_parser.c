@@ -1,182 +1,1564 @@
 #include "../include/svg_parser.h"
+#include "../include/svg_mmap.h"
+#include "../include/svg_tokenizer.h"
+#include "../include/svg_inflate.h"
+#include "../include/svg_scan.h"
+#include "../include/svg_number.h"
+#include "../include/svg_color.h"
+#include "../include/svg_transform.h"
+#include "../include/svg_style.h"
+#include "../include/svg_polygon.h"
+#include "../include/svg_store.h"
+#include "../include/svg_index.h"
+#include "../include/svg_snapshot.h"
+#include "../include/svg_platform.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-
-
-
-// Helper function to extract attribute value
-static int get_attribute(const char *line, const char *attr, char *value, int max_len) {
-    char search[64];
-    snprintf(search, sizeof(search), "%s=\"", attr);
-    
-    const char *start = strstr(line, search);
-    if (!start) return 0;
-    
-    start += strlen(search);
-    const char *end = strchr(start, '"');
-    if (!end) return 0;
-    
-    int len = end - start;
-    if (len >= max_len) len = max_len - 1;
-    
-    strncpy(value, start, len);
-    value[len] = '\0';
-    return 1;
+
+
+
+// One open <g>, <defs> or <symbol>; closed frames are recycled, the matrices
+// shapes point at are not
+typedef struct SvgGroupFrame {
+    const SvgMatrix *matrix;//everything above and including this group, NULL for identity
+    SvgMatrix storage;//streaming: the composed matrix lives here while the group is open
+    int hidden;//<defs> or <symbol>: content is not drawn where it appears
+    SvgDefinition *definition;//definition this element opened, collecting its content
+    SvgShape *definition_tail;
+    const SvgStyle *style;//fill and stroke inherited by the content, NULL for the default
+    struct SvgGroupFrame *outer_target;//target to restore when this frame closes
+    struct SvgGroupFrame *parent;
+} SvgGroupFrame;
+
+// State shared by the element handlers while a buffer is being parsed
+typedef struct {
+    SvgDocument *doc;
+    int shape_id;
+    int saw_svg;//an <svg> element set the document size
+    int needs_context;//saw markup whose effect depends on earlier tags (groups, defs, use, style)
+    int unresolved;//a <use> named an id not defined yet
+    SvgDefinition *settled;//newest definition already settled; newer ones are not
+    size_t use_shapes;//shapes the drawn uses so far expand to
+    const SvgShapeSink *sink;//streaming: shapes go here instead of into doc
+    SvgGroupFrame *group;//innermost open group
+    SvgGroupFrame *free_groups;
+    SvgGroupFrame *target;//innermost frame collecting a definition, NULL for the drawing
+    int hidden_depth;//open <defs>/<symbol> elements
+    int lazy;//drawn shapes other than uses only record where their tag is
+    const SvgShapeStore *old_shapes;//reload: the shapes before it
+    const long *reuse;//reload: for each drawn position, the old position kept there or -1
+    SvgStyleSheet sheet;//rules from every <style> so far
+    int in_style;//collecting the text of a <style> element
+    char *css;//that text (arena; a bigger copy is made when it grows)
+    size_t css_len, css_cap;
+    double *points;//streaming: points of the polygon being handed to the sink (malloc'd)
+    int points_cap;
+} SvgParseState;
+
+static void init_parse_state(SvgParseState *state, SvgDocument *doc) {
+    memset(state, 0, sizeof(*state));
+    state->doc = doc;
+}
+
+static double number_attribute(const SvgAttributeTable *attrs, const char *name) {
+    const SvgAttribute *attr = svg_find_attribute(attrs, name);
+    if (!attr) return 0.0;
+    return svg_number_from_slice(attr->value, attr->value_len);
+}
+
+// Compose parent with the element's own transform attribute. Kept results go
+// to the arena, so one group's shapes share one matrix; when scratch is given
+// (streamed drawing) the result only has to outlive the sink call
+static int resolve_transform(SvgParseState *state, const SvgMatrix *parent, const SvgAttributeTable *attrs,
+                             SvgMatrix *scratch, const SvgMatrix **out) {
+    const SvgAttribute *attr = svg_find_attribute(attrs, "transform");
+    SvgMatrix local;
+    if (!attr || svg_transform_parse(attr->value, attr->value_len, &local) != 0) {
+        *out = parent;
+        return 0;
+    }
+    if (parent) svg_matrix_multiply(parent, &local, &local);
+
+    if (!scratch) {
+        scratch = (SvgMatrix *)svg_arena_alloc(&state->doc->arena, sizeof(SvgMatrix));
+        if (!scratch) return -1;
+    }
+    *scratch = local;
+    *out = scratch;
+    return 0;
+}
+
+// Definitions outlive the parse even when streaming
+static int keeps_content(const SvgParseState *state) {
+    return !state->sink || state->hidden_depth > 0;
+}
+
+// Cascade for one element: inherited paints, then fill/stroke attributes, then
+// matching <style> rules, then style="". Elements that set nothing share their
+// parent's record; everything else is interned, so equal looks share one too
+static int resolve_style(SvgParseState *state, const SvgStyle *parent, SvgElementKind kind,
+                         const SvgAttributeTable *attrs, const SvgStyle **out) {
+    const SvgAttribute *fill = svg_find_attribute(attrs, "fill");
+    const SvgAttribute *stroke = svg_find_attribute(attrs, "stroke");
+    const SvgAttribute *fill_rule = svg_find_attribute(attrs, "fill-rule");
+    const SvgAttribute *inline_style = svg_find_attribute(attrs, "style");
+    if (!parent) parent = &svg_default_style;
+    if (!fill && !stroke && !fill_rule && !inline_style && state->sheet.count == 0) {
+        *out = parent;
+        return 0;
+    }
+
+    // Streamed shapes are discarded right away, so there is nowhere to keep text
+    SvgArena *arena = keeps_content(state) ? &state->doc->arena : NULL;
+    SvgStyle style = *parent;
+    SvgPaint paint;
+    int given;
+    if (fill) {
+        if ((given = svg_style_parse_paint(fill->value, fill->value_len, &paint, arena)) < 0) return -1;
+        if (given) style.fill = paint;
+    }
+    if (stroke) {
+        if ((given = svg_style_parse_paint(stroke->value, stroke->value_len, &paint, arena)) < 0) return -1;
+        if (given) style.stroke = paint;
+    }
+    if (fill_rule) {
+        SvgFillRule rule = svg_style_parse_fill_rule(fill_rule->value, fill_rule->value_len);
+        if (rule != SVG_FILL_RULE_UNSET) style.fill_rule = rule;
+    }
+    if (state->sheet.count > 0) {
+        const SvgAttribute *classes = svg_find_attribute(attrs, "class");
+        svg_stylesheet_apply(&state->sheet, kind, classes ? classes->value : NULL,
+                             classes ? classes->value_len : 0, &style);
+    }
+    if (inline_style &&
+        svg_style_parse_declarations(inline_style->value, inline_style->value_len, &style, arena) != 0)
+        return -1;
+
+    *out = svg_document_intern_style(state->doc, &style);
+    return *out ? 0 : -1;
+}
+
+// Character data of a <style>, possibly in several pieces
+static int parse_text(void *ctx, const char *text, const char *end) {
+    SvgParseState *state = (SvgParseState *)ctx;
+    if (!state->in_style) return 0;
+
+    size_t len = end - text;
+    if (state->css_len + len + 1 > state->css_cap) {
+        size_t cap = state->css_cap ? state->css_cap * 2 : 1024;
+        while (cap < state->css_len + len + 1) cap *= 2;
+        char *css = (char *)svg_arena_alloc(&state->doc->arena, cap);
+        if (!css) return -1;
+        if (state->css_len) memcpy(css, state->css, state->css_len);
+        state->css = css;
+        state->css_cap = cap;
+    }
+    memcpy(state->css + state->css_len, text, len);
+    state->css_len += len;
+    return 0;
+}
+
+static int close_style(SvgParseState *state) {
+    if (!state->in_style) return 0;
+    state->in_style = 0;
+    if (state->css_len == 0) return 0;
+    int result = svg_stylesheet_parse(&state->sheet, state->css, state->css_len, &state->doc->arena);
+    state->css_len = 0;
+    return result;
+}
+
+static const SvgAttribute *id_attribute(const SvgAttributeTable *attrs) {
+    const SvgAttribute *id = svg_find_attribute(attrs, "id");
+    return id && id->value_len > 0 ? id : NULL;
+}
+
+// Grow the definition's box by what part covers; a use part's definition is settled
+static void add_part_box(SvgDefinition *definition, const SvgShape *part) {
+    double box[4];
+    if (!svg_shape_covered_bounds(part, box)) return;
+    if (box[0] < definition->box[0]) definition->box[0] = box[0];
+    if (box[1] < definition->box[1]) definition->box[1] = box[1];
+    if (box[2] > definition->box[2]) definition->box[2] = box[2];
+    if (box[3] > definition->box[3]) definition->box[3] = box[3];
+}
+
+// Cut a use of child from definition if it would nest too deep or draw too much
+static void add_part_use(SvgDefinition *definition, SvgShape *use, const SvgDefinition *child) {
+    if (child->height + 1 >= SVG_MAX_USE_DEPTH || child->drawn > SVG_MAX_USE_SHAPES - definition->drawn) {
+        use->data.use.definition = NULL;
+        return;
+    }
+    definition->drawn += child->drawn;
+    if (child->height + 1 > definition->height) definition->height = child->height + 1;
+    add_part_box(definition, use);
+}
+
+static void start_settling(SvgDefinition *definition, SvgDefinition *caller) {
+    definition->settled = SVG_DEFINITION_SETTLING;
+    definition->height = 0;
+    definition->drawn = 0;
+    definition->box[0] = definition->box[1] = HUGE_VAL;
+    definition->box[2] = definition->box[3] = -HUGE_VAL;
+    definition->caller = caller;
+    definition->resume = definition->shapes;
+}
+
+// Depth-first over the uses reachable from root, cutting those that reach a
+// definition still on the path (a cycle) and those add_part_use refuses, and
+// caching each definition's box from its parts' once they are settled. The
+// path is kept in the definitions themselves, so a long chain of them cannot
+// overflow the stack
+static void settle_definition(SvgDefinition *root) {
+    if (root->settled != SVG_DEFINITION_UNSETTLED) return;
+    start_settling(root, NULL);
+    SvgDefinition *at = root;
+    while (at) {
+        SvgShape *part = at->resume;
+        if (!part) {
+            at->settled = SVG_DEFINITION_SETTLED;
+            SvgDefinition *caller = at->caller;
+            if (caller) {
+                add_part_use(caller, caller->resume, at);
+                caller->resume = caller->resume->next;
+            }
+            at = caller;
+            continue;
+        }
+        SvgDefinition *child = part->type == SVG_SHAPE_USE ? (SvgDefinition *)part->data.use.definition : NULL;
+        if (child && child->settled == SVG_DEFINITION_UNSETTLED) {
+            start_settling(child, at); // at->resume stays on the use until child is done
+            at = child;
+            continue;
+        }
+        if (part->type != SVG_SHAPE_USE) {
+            if (at->drawn < SVG_MAX_USE_SHAPES) at->drawn++;
+            add_part_box(at, part);
+        } else if (child && child->settled == SVG_DEFINITION_SETTLING) {
+            part->data.use.definition = NULL;
+        } else if (child) {
+            add_part_use(at, part, child);
+        }
+        at->resume = part->next;
+    }
+}
+
+// Settle the definitions added since the last call; only called while none is open
+static void settle_new_definitions(SvgParseState *state) {
+    SvgDefinition *newest = state->doc->definitions;
+    for (SvgDefinition *definition = newest; definition != state->settled; definition = definition->next)
+        settle_definition(definition);
+    state->settled = newest;
+}
+
+// A drawn use pays for the shapes its instance draws, and draws nothing once
+// the document is out of SVG_MAX_USE_SHAPES
+static void charge_use(SvgParseState *state, const SvgDefinition **definition) {
+    if (!*definition) return;
+    if ((*definition)->drawn > SVG_MAX_USE_SHAPES - state->use_shapes) *definition = NULL;
+    else state->use_shapes += (*definition)->drawn;
+}
+
+static int open_group(SvgParseState *state, const SvgAttributeTable *attrs, SvgElementKind kind) {
+    SvgGroupFrame *frame = state->free_groups;
+    if (frame) {
+        state->free_groups = frame->parent;
+    } else {
+        frame = (SvgGroupFrame *)svg_arena_alloc(&state->doc->arena, sizeof(SvgGroupFrame));
+        if (!frame) return -1;
+    }
+    frame->hidden = kind != SVG_ELEMENT_GROUP;
+    frame->definition = NULL;
+    frame->definition_tail = NULL;
+    frame->outer_target = state->target;
+    if (frame->hidden) state->hidden_depth++;
+
+    // <defs> and <symbol> start from their own origin; a <use> places them
+    const SvgMatrix *parent = state->group && !frame->hidden ? state->group->matrix : NULL;
+    SvgMatrix *scratch = keeps_content(state) ? NULL : &frame->storage;
+    int result = kind == SVG_ELEMENT_DEFS ? (frame->matrix = NULL, 0)
+                                          : resolve_transform(state, parent, attrs, scratch, &frame->matrix);
+    const SvgStyle *parent_style = state->group && !frame->hidden ? state->group->style : NULL;
+    frame->style = NULL;
+    if (result == 0 && kind != SVG_ELEMENT_DEFS)
+        result = resolve_style(state, parent_style, kind, attrs, &frame->style);
+
+    // A <symbol> with an id, or a <g> with an id directly in <defs>, is a definition
+    const SvgAttribute *id = id_attribute(attrs);
+    if (result == 0 && id && !state->reuse && (kind == SVG_ELEMENT_SYMBOL ||
+                              (kind == SVG_ELEMENT_GROUP && state->hidden_depth > 0 && !state->target))) {
+        frame->definition = svg_document_add_definition(state->doc, id->value, id->value_len);
+        if (!frame->definition) result = -1;
+        state->target = frame;
+    }
+
+    frame->parent = state->group;
+    state->group = frame;
+    return result;
+}
+
+static void close_group(SvgParseState *state) {
+    SvgGroupFrame *frame = state->group;
+    if (!frame) return; // unbalanced closing tag
+    if (frame->hidden) state->hidden_depth--;
+    state->target = frame->outer_target;
+    if (frame->definition && !state->target) settle_new_definitions(state);
+    state->group = frame->parent;
+    frame->parent = state->free_groups;
+    state->free_groups = frame;
+}
+
+static void read_use(SvgParseState *state, const SvgAttributeTable *attrs, SvgUse *use) {
+    use->x = number_attribute(attrs, "x");
+    use->y = number_attribute(attrs, "y");
+
+    const SvgAttribute *href = svg_find_attribute(attrs, "href");
+    if (!href) href = svg_find_attribute(attrs, "xlink:href");
+    if (!href || href->value_len < 2 || href->value[0] != '#') return;
+
+    const char *id = href->value + 1;
+    size_t id_len = href->value_len - 1;
+    use->definition = svg_document_find_definition(state->doc, id, id_len);
+    if (keeps_content(state)) {
+        use->href = svg_arena_strndup(&state->doc->arena, id, id_len);
+        // Forward reference: resolved once the whole document is read
+        if (!use->definition) state->unresolved = 1;
+    }
+}
+
+// points="..." into the arena, or into the state's buffer for a streamed shape
+static int read_points(SvgParseState *state, const SvgAttributeTable *attrs, SvgPoly *poly) {
+    poly->points = NULL;
+    poly->count = 0;
+    const SvgAttribute *attr = svg_find_attribute(attrs, "points");
+    int count = attr ? svg_points_count(attr->value, attr->value_len) : 0;
+    if (count == 0) return 0;
+
+    double *points;
+    if (keeps_content(state)) {
+        points = (double *)svg_arena_alloc(&state->doc->arena, (size_t)count * 2 * sizeof(double));
+        if (!points) return -1;
+    } else {
+        if (count > state->points_cap) {
+            double *grown = (double *)realloc(state->points, (size_t)count * 2 * sizeof(double));
+            if (!grown) return -1;
+            state->points = grown;
+            state->points_cap = count;
+        }
+        points = state->points;
+    }
+    poly->points = points;
+    poly->count = svg_points_parse(attr->value, attr->value_len, points, count);
+    return 0;
+}
+
+// Everything a shape's own attributes decide; parent and inherited come from
+// the enclosing groups. scratch is as for resolve_transform
+static int decode_shape(SvgParseState *state, SvgShape *shape, SvgElementKind kind, const SvgAttributeTable *attrs,
+                        const SvgMatrix *parent, const SvgStyle *inherited, SvgMatrix *scratch) {
+    if (resolve_transform(state, parent, attrs, scratch, &shape->transform) != 0) return -1;
+    if (resolve_style(state, inherited, kind, attrs, &shape->style) != 0) return -1;
+
+    switch (shape->type) {
+        case SVG_SHAPE_CIRCLE:
+            shape->data.circle.cx = number_attribute(attrs, "cx");
+            shape->data.circle.cy = number_attribute(attrs, "cy");
+            shape->data.circle.r = number_attribute(attrs, "r");
+            break;
+        case SVG_SHAPE_RECT:
+            shape->data.rect.x = number_attribute(attrs, "x");
+            shape->data.rect.y = number_attribute(attrs, "y");
+            shape->data.rect.width = number_attribute(attrs, "width");
+            shape->data.rect.height = number_attribute(attrs, "height");
+            break;
+        case SVG_SHAPE_LINE:
+            shape->data.line.x1 = number_attribute(attrs, "x1");
+            shape->data.line.y1 = number_attribute(attrs, "y1");
+            shape->data.line.x2 = number_attribute(attrs, "x2");
+            shape->data.line.y2 = number_attribute(attrs, "y2");
+            break;
+        case SVG_SHAPE_USE:
+            read_use(state, attrs, &shape->data.use);
+            break;
+        case SVG_SHAPE_POLYGON:
+        case SVG_SHAPE_POLYLINE:
+            return read_points(state, attrs, &shape->data.poly);
+    }
+    return 0;
+}
+
+// Lazy documents: the shape is numbered and placed, its attributes wait in the mapping
+static int add_lazy_shape(SvgParseState *state, SvgShapeType type, const char *tag, const char *end) {
+    SvgSource source;
+    source.tag = tag;
+    source.end = end;
+    source.inherited = state->group ? state->group->style : NULL;
+    return svg_store_append_pending(&state->doc->shapes, type, ++state->shape_id,
+                                    state->group ? state->group->matrix : NULL, &source);
+}
+
+// Elements that become a shape of their own where they appear
+static int is_drawn(SvgElementKind kind) {
+    return kind == SVG_ELEMENT_CIRCLE || kind == SVG_ELEMENT_RECT || kind == SVG_ELEMENT_LINE ||
+           kind == SVG_ELEMENT_POLYGON || kind == SVG_ELEMENT_POLYLINE || kind == SVG_ELEMENT_USE;
+}
+
+// Tokenizer callback; tag points just after '<', end at the closing '>'
+static int parse_element(void *ctx, const char *tag, const char *end) {
+    SvgParseState *state = (SvgParseState *)ctx;
+    const char *name_end;
+
+    // Closing tags carry no attributes; only containers change the state
+    if (tag[0] == '/') {
+        SvgElementKind closing = svg_classify_element(tag + 1, end, &name_end);
+        if (closing == SVG_ELEMENT_GROUP || closing == SVG_ELEMENT_DEFS || closing == SVG_ELEMENT_SYMBOL) {
+            state->needs_context = 1;
+            close_group(state);
+        } else if (closing == SVG_ELEMENT_STYLE) {
+            return close_style(state);
+        }
+        return 0;
+    }
+
+    SvgElementKind kind = svg_classify_element(tag, end, &name_end);
+    if (kind == SVG_ELEMENT_OTHER) return 0;
+
+    // A reload keeps the definitions, and drawn shapes that did not change
+    if (state->reuse && is_drawn(kind)) {
+        if (state->hidden_depth > 0) return 0;
+        long from = state->reuse[state->shape_id];
+        if (from >= 0) {
+            SvgShape kept;
+            svg_store_get(state->old_shapes, (size_t)from, &kept);
+            kept.id = ++state->shape_id;
+            if (kept.type == SVG_SHAPE_USE) charge_use(state, &kept.data.use.definition);
+            return svg_store_append(&state->doc->shapes, &kept);
+        }
+    }
+
+    // <style> rules only apply to what follows them, so once there is a sheet
+    // shapes are decoded on the spot; so are definitions and uses
+    if (state->lazy && state->hidden_depth == 0 && state->sheet.count == 0) {
+        if (kind == SVG_ELEMENT_CIRCLE) return add_lazy_shape(state, SVG_SHAPE_CIRCLE, tag, end);
+        if (kind == SVG_ELEMENT_RECT) return add_lazy_shape(state, SVG_SHAPE_RECT, tag, end);
+        if (kind == SVG_ELEMENT_LINE) return add_lazy_shape(state, SVG_SHAPE_LINE, tag, end);
+        if (kind == SVG_ELEMENT_POLYGON) return add_lazy_shape(state, SVG_SHAPE_POLYGON, tag, end);
+        if (kind == SVG_ELEMENT_POLYLINE) return add_lazy_shape(state, SVG_SHAPE_POLYLINE, tag, end);
+    }
+
+    // One pass over the tag collects every attribute for the lookups below
+    SvgAttributeTable attrs;
+    svg_lex_attributes(name_end, end, &attrs);
+
+    if (kind == SVG_ELEMENT_GROUP || kind == SVG_ELEMENT_DEFS || kind == SVG_ELEMENT_SYMBOL) {
+        state->needs_context = 1;
+        if (end[-1] == '/') return 0; // empty element has no content
+        return open_group(state, &attrs, kind);
+    }
+
+    if (kind == SVG_ELEMENT_STYLE) {
+        // Rules apply to the elements after them
+        state->needs_context = 1;
+        if (end[-1] == '/') return 0;
+        state->in_style = 1;
+        state->css_len = 0;
+        return SVG_TOKEN_WANT_TEXT;
+    }
+
+    if (kind == SVG_ELEMENT_SVG) {
+        const SvgAttribute *attr;
+        state->saw_svg = 1;
+        if ((attr = svg_find_attribute(&attrs, "width")) != NULL)
+            state->doc->width = svg_number_from_slice(attr->value, attr->value_len);
+        if ((attr = svg_find_attribute(&attrs, "height")) != NULL)
+            state->doc->height = svg_number_from_slice(attr->value, attr->value_len);
+        if (state->sink && state->sink->size)
+            return state->sink->size(state->sink->ctx, state->doc->width, state->doc->height);
+        return 0;
+    }
+
+    SvgShapeType type;
+    switch (kind) {
+        case SVG_ELEMENT_CIRCLE: type = SVG_SHAPE_CIRCLE; break;
+        case SVG_ELEMENT_RECT: type = SVG_SHAPE_RECT; break;
+        case SVG_ELEMENT_LINE: type = SVG_SHAPE_LINE; break;
+        case SVG_ELEMENT_POLYGON: type = SVG_SHAPE_POLYGON; break;
+        case SVG_ELEMENT_POLYLINE: type = SVG_SHAPE_POLYLINE; break;
+        case SVG_ELEMENT_USE: type = SVG_SHAPE_USE; state->needs_context = 1; break;
+        default: return 0;
+    }
+
+    // Inside <defs> but outside any definition, only elements with an id can
+    // ever be referenced; each becomes a definition of its own
+    const SvgAttribute *own_id = NULL;
+    if (state->hidden_depth > 0 && !state->target) {
+        own_id = id_attribute(&attrs);
+        if (!own_id) return 0;
+    }
+
+    // Decoded in place; streamed shapes only live for the duration of the sink call
+    SvgShape shape;
+    memset(&shape, 0, sizeof(shape));
+    shape.type = type;
+    if (state->hidden_depth == 0) shape.id = ++state->shape_id; // definition content is not numbered
+
+    SvgMatrix shape_matrix;
+    if (decode_shape(state, &shape, kind, &attrs, state->group ? state->group->matrix : NULL,
+                     state->group ? state->group->style : NULL, keeps_content(state) ? NULL : &shape_matrix) != 0)
+        return -1;
+
+    // Definition content stays a list of nodes in the arena
+    if (state->target || own_id) {
+        SvgShape *node = svg_document_new_shape(state->doc, type);
+        if (!node) return -1;
+        *node = shape;
+        if (own_id) {
+            SvgDefinition *definition = svg_document_add_definition(state->doc, own_id->value, own_id->value_len);
+            if (!definition) return -1;
+            definition->shapes = node;
+            settle_new_definitions(state);
+            return 0;
+        }
+        SvgGroupFrame *target = state->target;
+        if (target->definition_tail) target->definition_tail->next = node;
+        else target->definition->shapes = node;
+        target->definition_tail = node;
+        return 0;
+    }
+
+    if (type == SVG_SHAPE_USE) charge_use(state, &shape.data.use.definition);
+    if (state->sink) return state->sink->shape(state->sink->ctx, &shape);
+
+    return svg_store_append(&state->doc->shapes, &shape);
+}
+
+static const SvgDefinition *find_href(const SvgDocument *doc, const char *href) {
+    return svg_document_find_definition(doc, href, strlen(href));
+}
+
+// After the last tag: connect uses that came before their definitions, then
+// settle the definitions and charge the drawn uses again on the whole graph
+static void finish_parse(SvgParseState *state) {
+    if (!state->unresolved) return;
+    SvgShapeStore *store = &state->doc->shapes;
+    SvgUseTable *uses = &store->uses;
+    for (size_t row = 0; row < uses->count; row++) {
+        if (!uses->definition[row] && uses->href[row])
+            uses->definition[row] = find_href(state->doc, uses->href[row]);
+    }
+    for (SvgDefinition *definition = state->doc->definitions; definition; definition = definition->next) {
+        definition->settled = SVG_DEFINITION_UNSETTLED;
+        for (SvgShape *shape = definition->shapes; shape; shape = shape->next) {
+            if (shape->type == SVG_SHAPE_USE && !shape->data.use.definition && shape->data.use.href)
+                shape->data.use.definition = find_href(state->doc, shape->data.use.href);
+        }
+    }
+    state->settled = NULL;
+    settle_new_definitions(state);
+    state->use_shapes = 0;
+    for (size_t i = 0; i < store->count; i++) {
+        if (store->items[i].type == SVG_SHAPE_USE && store->styles[i])
+            charge_use(state, &uses->definition[store->items[i].index]);
+    }
+
+    // Any use may now reach shapes it did not when it was stored: set it again for its bounds
+    for (size_t i = 0; i < store->count; i++) {
+        if (store->items[i].type != SVG_SHAPE_USE || !store->styles[i]) continue;
+        SvgShape use;
+        svg_store_get(store, i, &use);
+        svg_store_set(store, i, &use);
+    }
+}
+
+int svg_load_from_memory(const char *data, size_t size, SvgDocument **doc_out) {
+    SvgDocument *doc = create_svg_document(800, 600);
+    if (!doc) return -1;
+
+    SvgParseState state;
+    init_parse_state(&state, doc);
+    if (svg_tokenize_buffer(data, size, parse_element, parse_text, &state) != 0) {
+        svg_free_document(doc);
+        return -1;
+    }
+    finish_parse(&state);
+
+    *doc_out = doc;
+    return 0;
+}
+
+// Read a file through the tokenizer window; memory stays at one window unless
+// a single tag is longer
+// gzip input is recognised by its magic and inflated straight into the window
+static int parse_stream(FILE *file, const char *filename, SvgParseState *state) {
+    SvgTokenizer tok;
+    if (svg_tokenizer_init(&tok, parse_element, parse_text, state) != 0) return -1;
+
+    size_t avail;
+    char *space = svg_tokenizer_space(&tok, &avail);
+    size_t n = fread(space, 1, 2, file);
+
+    SvgInflate inflate;
+    int gzip = svg_inflate_is_gzip((const unsigned char *)space, n);
+    if (gzip) {
+        if (svg_inflate_init(&inflate, file, (const unsigned char *)space, n) != 0) {
+            svg_tokenizer_release(&tok);
+            return -1;
+        }
+        n = 0;
+    }
+
+    int result = 0;
+    for (;;) {
+        if (n > 0 && svg_tokenizer_advance(&tok, n) != 0) {
+            result = -1;
+            break;
+        }
+        space = svg_tokenizer_space(&tok, &avail);
+        if (gzip) {
+            long got = svg_inflate_read(&inflate, space, avail);
+            if (got < 0) {
+                if (!ferror(file)) fprintf(stderr, "Error: Corrupt gzip data in %s\n", filename);
+                result = -1;
+                break;
+            }
+            n = (size_t)got;
+        } else {
+            n = fread(space, 1, avail, file);
+        }
+        if (n == 0) break;
+    }
+    if (result == 0 && svg_tokenizer_finish(&tok) != 0) result = -1;
+    if (ferror(file)) {
+        fprintf(stderr, "Error: Failed reading file %s\n", filename);
+        result = -1;
+    }
+
+    if (gzip) svg_inflate_release(&inflate);
+    svg_tokenizer_release(&tok);
+    return result;
+}
+
+static int is_stdin(const char *filename) {
+    return strcmp(filename, SVG_STDIN_NAME) == 0;
+}
+
+static FILE *open_input(const char *filename) {
+    if (is_stdin(filename)) return svg_stdin_binary();
+    FILE *file = fopen(filename, "rb");
+    if (!file) fprintf(stderr, "Error: Cannot open file %s\n", filename);
+    return file;
+}
+
+static void close_input(FILE *file) {
+    if (file != stdin) fclose(file);
 }
 
 int svg_load_from_file(const char *filename, SvgDocument **doc_out) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        fprintf(stderr, "Error: Cannot open file %s\n", filename);
+    FILE *file = open_input(filename);
+    if (!file) return -1;
+
+    SvgDocument *doc = create_svg_document(800, 600);
+    if (!doc) {
+        close_input(file);
         return -1;
     }
-    
-    SvgDocument *doc = (SvgDocument *)malloc(sizeof(SvgDocument));
+
+    SvgParseState state;
+    init_parse_state(&state, doc);
+    int result = parse_stream(file, filename, &state);
+    close_input(file);
+
+    if (result != 0) {
+        svg_free_document(doc);
+        return -1;
+    }
+    finish_parse(&state);
+    *doc_out = doc;
+    return 0;
+}
+
+int svg_stream_file(const char *filename, const SvgShapeSink *sink) {
+    FILE *file = open_input(filename);
+    if (!file) return -1;
+
+    // Only the size lives in this document; it never holds shapes
+    SvgDocument *doc = create_svg_document(800, 600);
     if (!doc) {
-        fclose(file);
+        close_input(file);
         return -1;
     }
-    
-    doc->width = 800.0;
-    doc->height = 600.0;
-    doc->shapes = NULL;
-    
-    SvgShape *last_shape = NULL;
-    int shape_id = 0;
-    char line[1024];
-    
-    while (fgets(line, sizeof(line), file)) {
-        char value[256];
-        
-        // Parse SVG dimensions
-        if (strstr(line, "<svg")) {
-            if (get_attribute(line, "width", value, sizeof(value))) {
-                doc->width = atof(value);
-            }
-            if (get_attribute(line, "height", value, sizeof(value))) {
-                doc->height = atof(value);
-            }
+
+    SvgParseState state;
+    init_parse_state(&state, doc);
+    state.sink = sink;
+    int result = parse_stream(file, filename, &state);
+
+    free(state.points);
+    svg_free_document(doc);
+    close_input(file);
+    return result;
+}
+
+// One slice of the input, parsed on its own thread into its own document
+typedef struct {
+    const char *data;
+    size_t size;
+    int last;//final slice of the input
+    SvgParseState state;
+    int clean;//slice ended outside any tag or comment
+    int result;
+    SvgThread thread;
+} SvgParseChunk;
+
+static void parse_chunk(void *arg) {
+    SvgParseChunk *chunk = (SvgParseChunk *)arg;
+    chunk->result = svg_tokenize_piece(chunk->data, chunk->size, parse_element, parse_text, &chunk->state,
+                                       chunk->last, &chunk->clean);
+}
+
+// Split point at or after target: the first '<' after the next '>'
+static size_t find_split(const char *data, size_t size, size_t target) {
+    const char *end = data + size;
+    const char *gt = memchr(data + target, '>', size - target);
+    if (!gt) return size;
+    const char *lt = memchr(gt + 1, '<', end - (gt + 1));
+    return lt ? (size_t)(lt - data) : size;
+}
+
+static void free_chunks(SvgParseChunk *chunks, int count) {
+    for (int i = 0; i < count; i++) svg_free_document(chunks[i].state.doc);
+    free(chunks);
+}
+
+int svg_load_from_memory_parallel(const char *data, size_t size, int threads, SvgDocument **doc_out) {
+    if (threads < 1) threads = svg_cpu_count();
+    if (threads > SVG_MAX_PARSE_THREADS) threads = SVG_MAX_PARSE_THREADS;
+
+    // Not worth starting threads for small inputs
+    if (threads == 1 || size / (size_t)threads < SVG_MIN_PARSE_CHUNK)
+        return svg_load_from_memory(data, size, doc_out);
+
+    SvgParseChunk *chunks = (SvgParseChunk *)calloc(threads, sizeof(SvgParseChunk));
+    if (!chunks) return -1;
+
+    // Cut the input between tags, roughly into equal slices
+    int count = 0;
+    size_t start = 0;
+    for (int i = 0; i < threads && start < size; i++) {
+        size_t target = size / threads * (i + 1);
+        if (target < start) target = start;
+        size_t stop = (i == threads - 1) ? size : find_split(data, size, target);
+
+        SvgParseChunk *chunk = &chunks[count++];
+        chunk->data = data + start;
+        chunk->size = stop - start;
+        SvgDocument *chunk_doc = create_svg_document(800, 600);
+        if (!chunk_doc) {
+            free_chunks(chunks, count - 1);
+            return -1;
         }
-        
-        // Parse circle
-        if (strstr(line, "<circle")) {
-            SvgShape *shape = (SvgShape *)malloc(sizeof(SvgShape));
-            shape->type = SVG_SHAPE_CIRCLE;
-            shape->id = ++shape_id;
-            shape->next = NULL;
-            
-            if (get_attribute(line, "cx", value, sizeof(value)))
-                shape->data.circle.cx = atof(value);
-            if (get_attribute(line, "cy", value, sizeof(value)))
-                shape->data.circle.cy = atof(value);
-            if (get_attribute(line, "r", value, sizeof(value)))
-                shape->data.circle.r = atof(value);
-            if (get_attribute(line, "fill", value, sizeof(value)))
-                shape->data.circle.fill = strdup(value);
-            
-            if (!doc->shapes) {
-                doc->shapes = shape;
-            } else {
-                last_shape->next = shape;
-            }
-            last_shape = shape;
-        }
-        
-        // Parse rectangle
-        if (strstr(line, "<rect")) {
-            SvgShape *shape = (SvgShape *)malloc(sizeof(SvgShape));
-            shape->type = SVG_SHAPE_RECT;
-            shape->id = ++shape_id;
-            shape->next = NULL;
-            
-            if (get_attribute(line, "x", value, sizeof(value)))
-                shape->data.rect.x = atof(value);
-            if (get_attribute(line, "y", value, sizeof(value)))
-                shape->data.rect.y = atof(value);
-            if (get_attribute(line, "width", value, sizeof(value)))
-                shape->data.rect.width = atof(value);
-            if (get_attribute(line, "height", value, sizeof(value)))
-                shape->data.rect.height = atof(value);
-            if (get_attribute(line, "fill", value, sizeof(value)))
-                shape->data.rect.fill = strdup(value);
-            
-            if (!doc->shapes) {
-                doc->shapes = shape;
-            } else {
-                last_shape->next = shape;
+        init_parse_state(&chunk->state, chunk_doc);
+        start = stop;
+    }
+    chunks[count - 1].last = 1;
+
+    // The calling thread takes the first slice itself
+    for (int i = 1; i < count; i++) {
+        if (svg_thread_start(&chunks[i].thread, parse_chunk, &chunks[i]) != 0)
+            parse_chunk(&chunks[i]);
+    }
+    parse_chunk(&chunks[0]);
+    for (int i = 1; i < count; i++) svg_thread_join(&chunks[i].thread);
+
+    // A slice that ended inside a comment or tag means its successor started
+    // in the wrong state, and groups and uses need the tags before them: redo the
+    // whole input sequentially
+    for (int i = 0; i < count; i++) {
+        if (chunks[i].result != 0 || (!chunks[i].last && !chunks[i].clean) ||
+            chunks[i].state.needs_context) {
+            int failed = chunks[i].result != 0;
+            free_chunks(chunks, count);
+            return failed ? -1 : svg_load_from_memory(data, size, doc_out);
+        }
+    }
+
+    // Stitch the slices together in document order and renumber the ids; each
+    // slice interned its own styles, so those move into the first document's
+    // table in the order a sequential parse would have met them
+    SvgDocument *doc = chunks[0].state.doc;
+    int shape_id = chunks[0].state.shape_id;
+    int result = 0;
+    for (int i = 1; i < count; i++) {
+        SvgParseState *state = &chunks[i].state;
+        if (state->saw_svg) {
+            doc->width = state->doc->width;
+            doc->height = state->doc->height;
+        }
+        const SvgStyle **styles = NULL;
+        if (state->doc->style_count > 1) {
+            styles = (const SvgStyle **)calloc(state->doc->style_count, sizeof(*styles));
+            if (!styles) result = -1;
+        }
+        SvgShapeStore *shapes = &state->doc->shapes;
+        for (size_t position = 0; position < shapes->count; position++) {
+            shapes->ids[position] += shape_id;
+            int index = shapes->styles[position]->index;
+            if (index == 0 || !styles) continue;
+            if (!styles[index]) styles[index] = svg_document_intern_style(doc, shapes->styles[position]);
+            if (!styles[index]) result = -1;
+            else shapes->styles[position] = styles[index];
+        }
+        free(styles);
+        shape_id += state->shape_id;
+
+        if (result == 0) result = svg_store_append_store(&doc->shapes, shapes);
+        svg_arena_adopt(&doc->arena, &state->doc->arena);
+        svg_free_document(state->doc);
+    }
+    free(chunks);
+
+    if (result != 0) {
+        svg_free_document(doc);
+        return -1;
+    }
+    *doc_out = doc;
+    return 0;
+}
+
+int svg_load_from_file_parallel(const char *filename, int threads, SvgDocument **doc_out) {
+    // A pipe cannot be mapped; it is read through the stream window instead
+    if (is_stdin(filename)) return svg_load_from_file(filename, doc_out);
+
+    SvgMappedFile mapped;
+    if (svg_map_file(filename, &mapped) != 0) return -1;
+
+    // Compressed input has to be inflated in order; use the streaming loader
+    if (svg_inflate_is_gzip((const unsigned char *)mapped.data, mapped.size)) {
+        svg_unmap_file(&mapped);
+        return svg_load_from_file(filename, doc_out);
+    }
+
+    int result = svg_load_from_memory_parallel(mapped.data, mapped.size, threads, doc_out);
+
+    svg_unmap_file(&mapped);
+    return result;
+}
+
+int svg_load_from_file_lazy(const char *filename, SvgDocument **doc_out) {
+    // Pipes and compressed input leave nothing to point into: load them fully
+    if (is_stdin(filename)) return svg_load_from_file(filename, doc_out);
+
+    SvgMappedFile mapped;
+    if (svg_map_file(filename, &mapped) != 0) return -1;
+    if (svg_inflate_is_gzip((const unsigned char *)mapped.data, mapped.size)) {
+        svg_unmap_file(&mapped);
+        return svg_load_from_file(filename, doc_out);
+    }
+
+    SvgDocument *doc = create_svg_document(800, 600);
+    if (!doc) {
+        svg_unmap_file(&mapped);
+        return -1;
+    }
+    doc->source = mapped;
+
+    SvgParseState state;
+    init_parse_state(&state, doc);
+    state.lazy = 1;
+    if (svg_tokenize_buffer(mapped.data, mapped.size, parse_element, parse_text, &state) != 0) {
+        svg_free_document(doc);
+        return -1;
+    }
+    finish_parse(&state);
+
+    *doc_out = doc;
+    return 0;
+}
+
+// Fill in a lazy shape from its tag; on failure it is left to be decoded later
+static int decode_pending(SvgDocument *doc, size_t position) {
+    SvgShapeStore *store = &doc->shapes;
+    const SvgSource *source = &store->sources[position];
+    SvgShape shape;
+    memset(&shape, 0, sizeof(shape));
+    shape.type = (SvgShapeType)store->items[position].type;
+    shape.id = store->ids[position];
+
+    SvgParseState state;
+    init_parse_state(&state, doc);
+    const char *name_end;
+    SvgElementKind kind = svg_classify_element(source->tag, source->end, &name_end);
+    SvgAttributeTable attrs;
+    svg_lex_attributes(name_end, source->end, &attrs);
+    if (decode_shape(&state, &shape, kind, &attrs, store->transforms[position], source->inherited, NULL) != 0)
+        return -1;
+    svg_store_set(store, position, &shape);
+    return 0;
+}
+
+static int is_removed(const SvgShapeStore *store, size_t position) {
+    return store->items[position].type == SVG_STORE_REMOVED;
+}
+
+int svg_document_decode(SvgDocument *doc) {
+    for (size_t i = 0; i < doc->shapes.count; i++) {
+        if (!doc->shapes.styles[i] && !is_removed(&doc->shapes, i) && decode_pending(doc, i) != 0) return -1;
+    }
+    return 0;
+}
+
+size_t svg_document_shape_count(const SvgDocument *doc) {
+    if (doc->snapshot) return svg_version_live(doc->snapshot);
+    return svg_store_live(&doc->shapes);
+}
+
+size_t svg_document_type_count(const SvgDocument *doc, SvgShapeType type) {
+    size_t count = 0;
+    if (doc->snapshot) {
+        for (size_t i = 0; i < svg_version_count(doc->snapshot); i++) {
+            const double *bounds;
+            const SvgShape *shape = svg_version_shape(doc->snapshot, i, &bounds);
+            if (shape && shape->type == type) count++;
+        }
+        return count;
+    }
+    // The draw order knows every type, waiting lazy shapes included
+    for (size_t i = 0; i < doc->shapes.count; i++) {
+        if (doc->shapes.items[i].type == (uint32_t)type) count++;
+    }
+    return count;
+}
+
+// The shape at a position that is in use, decoded if needed
+static int shape_at(const SvgDocument *doc, size_t position, SvgShape *out) {
+    // Filling in a lazy shape is not a visible change, so it is done through const
+    if (!doc->shapes.styles[position] && decode_pending((SvgDocument *)doc, position) != 0) return -1;
+    svg_store_get(&doc->shapes, position, out);
+    return 0;
+}
+
+// Same for a snapshot, whose shapes are all decoded
+static const SvgShape *snapshot_from(SvgShapeIter *it) {
+    const SvgShapeVersion *version = it->doc->snapshot;
+    for (size_t count = svg_version_count(version); it->position < count; it->position++) {
+        const SvgShape *shape = svg_version_shape(version, it->position, &it->bounds);
+        if (shape) {
+            it->shape = *shape;
+            return &it->shape;
+        }
+    }
+    return NULL;
+}
+
+// Next shape at or after it->position, skipping removed positions
+static const SvgShape *iter_from(SvgShapeIter *it) {
+    if (it->doc->snapshot) return snapshot_from(it);
+    const SvgShapeStore *store = &it->doc->shapes;
+    while (it->position < store->count && is_removed(store, it->position)) it->position++;
+    if (it->position >= store->count) return NULL;
+    if (shape_at(it->doc, it->position, &it->shape) != 0) {
+        it->failed = 1;
+        return NULL;
+    }
+    it->handle = svg_store_handle(store, it->position);
+    it->bounds = store->bounds[it->position];
+    return &it->shape;
+}
+
+const SvgShape* svg_shapes_first(SvgShapeIter *it, const SvgDocument *doc) {
+    it->doc = doc;
+    it->position = 0;
+    it->handle = SVG_NO_SHAPE;
+    it->bounds = NULL;
+    it->failed = 0;
+    return iter_from(it);
+}
+
+const SvgShape* svg_shapes_next(SvgShapeIter *it) {
+    if (it->failed) return NULL;
+    it->position++;
+    return iter_from(it);
+}
+
+const SvgShape* svg_shapes_at(SvgShapeIter *it, const SvgDocument *doc, SvgShapeHandle handle) {
+    it->doc = doc;
+    it->handle = handle;
+    it->bounds = NULL;
+    it->failed = 0;
+    if (svg_store_position(&doc->shapes, handle, &it->position) != 0) return NULL;
+    if (shape_at(doc, it->position, &it->shape) != 0) {
+        it->failed = 1;
+        return NULL;
+    }
+    it->bounds = doc->shapes.bounds[it->position];
+    return &it->shape;
+}
+
+SvgShapeHandle svg_document_find_shape(const SvgDocument *doc, int id) {
+    size_t position;
+    if (svg_store_find_id(&doc->shapes, id, &position) != 0) return SVG_NO_SHAPE;
+    return svg_store_handle(&doc->shapes, position);
+}
+
+int svg_document_get_shape(const SvgDocument *doc, SvgShapeHandle handle, SvgShape *out) {
+    size_t position;
+    if (svg_store_position(&doc->shapes, handle, &position) != 0) return -1;
+    return shape_at(doc, position, out);
+}
+
+int svg_document_shape_bounds(const SvgDocument *doc, SvgShapeHandle handle, double out[4]) {
+    size_t position;
+    SvgShape shape;
+    if (svg_store_position(&doc->shapes, handle, &position) != 0 || shape_at(doc, position, &shape) != 0)
+        return -1;
+    memcpy(out, doc->shapes.bounds[position], sizeof(doc->shapes.bounds[position]));
+    return 0;
+}
+
+int svg_document_bounds(const SvgDocument *doc, double out[4]) {
+    // A snapshot keeps the extent it was taken with, unless that was out of date
+    if (doc->snapshot && doc->shapes.extent_stale) return svg_version_extent(doc->snapshot, out);
+    if (doc->shapes.pending) return -1;
+    // Like decoding, bringing the cached extent up to date is not a visible change
+    return svg_store_extent((SvgShapeStore *)&doc->shapes, out);
+}
+
+// The document's grid, built on first use over every shape (decoding lazy ones);
+// like decoding, that is not a visible change
+static const SvgShapeIndex *document_index(const SvgDocument *doc) {
+    if (doc->shapes.pending && svg_document_decode((SvgDocument *)doc) != 0) return NULL;
+    return svg_store_index((SvgShapeStore *)&doc->shapes);
+}
+
+int svg_document_query_rect(const SvgDocument *doc, const double rect[4], SvgShapeQuery *query) {
+    const SvgShapeIndex *index = document_index(doc);
+    if (!index) {
+        query->count = 0;
+        return -1;
+    }
+    return svg_index_query(index, &doc->shapes, rect, query);
+}
+
+SvgShapeHandle svg_document_shape_at(const SvgDocument *doc, double x, double y, double tolerance) {
+    const SvgShapeIndex *index = document_index(doc);
+    return index ? svg_index_shape_at(index, &doc->shapes, x, y, tolerance) : SVG_NO_SHAPE;
+}
+
+void svg_shape_query_release(SvgShapeQuery *query) {
+    free(query->handles);
+    memset(query, 0, sizeof(*query));
+}
+
+SvgShapeHandle svg_document_add_shape(SvgDocument *doc, const SvgShape *shape) {
+    SvgShape copy = *shape;
+    if (!copy.style) copy.style = &svg_default_style;
+    if (copy.id <= 0) copy.id = doc->shapes.max_id + 1;
+    if (svg_store_append(&doc->shapes, &copy) != 0) return SVG_NO_SHAPE;
+    return svg_store_handle(&doc->shapes, doc->shapes.count - 1);
+}
+
+int svg_document_set_shape(SvgDocument *doc, SvgShapeHandle handle, const SvgShape *shape) {
+    size_t position;
+    if (svg_store_position(&doc->shapes, handle, &position) != 0 ||
+        (uint32_t)shape->type != doc->shapes.items[position].type)
+        return -1;
+    SvgShape copy = *shape;
+    if (!copy.style) copy.style = &svg_default_style;
+    return svg_store_set(&doc->shapes, position, &copy);
+}
+
+int svg_document_remove_shape(SvgDocument *doc, SvgShapeHandle handle) {
+    size_t position;
+    if (svg_store_position(&doc->shapes, handle, &position) != 0) return -1;
+    svg_store_remove(&doc->shapes, position);
+    return 0;
+}
+
+const SvgDocument* svg_document_snapshot(SvgDocument *doc) {
+    SvgShapeVersion *version;
+    if (doc->snapshot) {
+        version = svg_version_share(doc->snapshot);
+    } else {
+        // Chunks hold whole shapes: nothing in them points into the mapping
+        if (doc->shapes.pending && svg_document_decode(doc) != 0) return NULL;
+        version = svg_store_snapshot(&doc->shapes);
+        if (!version) return NULL;
+    }
+    SvgDocument *snapshot = (SvgDocument *)malloc(sizeof(SvgDocument));
+    if (!snapshot) {
+        svg_version_release(version);
+        return NULL;
+    }
+
+    // Definitions and styles are never changed once made, so they are shared
+    // as they are; the store stays empty and only lends its extent
+    *snapshot = *doc;
+    svg_store_init(&snapshot->shapes);
+    memcpy(snapshot->shapes.extent, doc->shapes.extent, sizeof(doc->shapes.extent));
+    snapshot->shapes.extent_stale = doc->shapes.extent_stale;
+    svg_arena_init(&snapshot->arena);
+    memset(&snapshot->source, 0, sizeof(snapshot->source));
+    snapshot->element_hashes = NULL;
+    snapshot->element_count = 0;
+    snapshot->snapshot = version;
+    return snapshot;
+}
+
+void svg_snapshot_release(const SvgDocument *snapshot) {
+    svg_free_document((SvgDocument *)snapshot);
+}
+
+// ---- incremental reload ----
+
+// Old and new shape lists are lined up in order; after a mismatch this many
+// elements ahead are searched for the point where they agree again
+#define SVG_RELOAD_LOOKAHEAD 64
+
+// One open <g>, <defs> or <symbol> while hashing
+typedef struct {
+    uint64_t context;//hash of the group tags around the content
+    int hidden;
+} SvgHashFrame;
+
+// State of the hashing pass: the same nesting rules as parse_element, no decoding
+typedef struct {
+    uint64_t *hashes;//per drawn shape
+    size_t count, capacity;
+    uint64_t structure;
+    SvgHashFrame *frames;
+    int depth, frame_capacity;
+    int hidden_depth;
+    int styles;//<style> elements so far; their rules apply to what follows
+    int in_style;
+} SvgHashState;
+
+// FNV-1a, 64-bit
+static uint64_t hash_bytes(uint64_t hash, const char *p, const char *end) {
+    for (; p < end; p++) hash = (hash ^ (unsigned char)*p) * 1099511628211ull;
+    return hash;
+}
+
+static uint64_t hash_number(uint64_t hash, uint64_t value) {
+    for (int i = 0; i < 8; i++, value >>= 8) hash = (hash ^ (value & 0xFF)) * 1099511628211ull;
+    return hash;
+}
+
+#define SVG_HASH_SEED 14695981039346656037ull
+
+static int hash_element(void *ctx, const char *tag, const char *end) {
+    SvgHashState *state = (SvgHashState *)ctx;
+    const char *name_end;
+
+    if (tag[0] == '/') {
+        SvgElementKind closing = svg_classify_element(tag + 1, end, &name_end);
+        if (closing == SVG_ELEMENT_GROUP || closing == SVG_ELEMENT_DEFS || closing == SVG_ELEMENT_SYMBOL) {
+            if (state->depth == 0) return 0;
+            if (state->frames[--state->depth].hidden) state->hidden_depth--;
+        } else if (closing == SVG_ELEMENT_STYLE && state->in_style) {
+            state->in_style = 0;
+            state->styles++;
+        }
+        return 0;
+    }
+
+    SvgElementKind kind = svg_classify_element(tag, end, &name_end);
+    if (kind == SVG_ELEMENT_OTHER) return 0;
+    uint64_t context = state->depth ? state->frames[state->depth - 1].context : SVG_HASH_SEED;
+
+    if (state->hidden_depth == 0 && is_drawn(kind)) {
+        if (state->count == state->capacity) {
+            size_t capacity = state->capacity ? state->capacity * 2 : 1024;
+            uint64_t *hashes = (uint64_t *)realloc(state->hashes, capacity * sizeof(uint64_t));
+            if (!hashes) return -1;
+            state->hashes = hashes;
+            state->capacity = capacity;
+        }
+        state->hashes[state->count++] = hash_bytes(hash_number(context, state->styles), tag, end);
+        return 0;
+    }
+
+    // Definitions, <style> and <svg> affect shapes anywhere: one hash for all of them
+    if (state->hidden_depth > 0 || kind != SVG_ELEMENT_GROUP)
+        state->structure = hash_bytes(state->structure, tag, end);
+
+    if (kind == SVG_ELEMENT_STYLE) {
+        if (end[-1] == '/') return 0;
+        state->in_style = 1;
+        return SVG_TOKEN_WANT_TEXT;
+    }
+    if (kind != SVG_ELEMENT_GROUP && kind != SVG_ELEMENT_DEFS && kind != SVG_ELEMENT_SYMBOL) return 0;
+    if (end[-1] == '/') return 0;
+
+    if (state->depth == state->frame_capacity) {
+        int capacity = state->frame_capacity ? state->frame_capacity * 2 : 16;
+        SvgHashFrame *frames = (SvgHashFrame *)realloc(state->frames, capacity * sizeof(SvgHashFrame));
+        if (!frames) return -1;
+        state->frames = frames;
+        state->frame_capacity = capacity;
+    }
+    SvgHashFrame *frame = &state->frames[state->depth++];
+    frame->hidden = kind != SVG_ELEMENT_GROUP;
+    frame->context = hash_bytes(context, tag, end);
+    if (frame->hidden) state->hidden_depth++;
+    return 0;
+}
+
+static int hash_text(void *ctx, const char *text, const char *end) {
+    SvgHashState *state = (SvgHashState *)ctx;
+    if (state->in_style) state->structure = hash_bytes(state->structure, text, end);
+    return 0;
+}
+
+// Give each new shape the old shape it repeats (or -1): common runs are
+// followed in order, and after a difference the nearest point where the two
+// lists agree again is taken as an insertion or deletion
+static void match_elements(const uint64_t *old, size_t old_count, const uint64_t *now, size_t now_count,
+                           long *from) {
+    size_t i = 0, j = 0;
+    while (j < now_count) {
+        if (i < old_count && old[i] == now[j]) {
+            from[j++] = (long)i++;
+            continue;
+        }
+        size_t skip_old = 0, skip_new = 0;
+        for (size_t k = 1; k <= SVG_RELOAD_LOOKAHEAD; k++) {
+            if (i + k < old_count && old[i + k] == now[j]) {
+                skip_old = k;
+                break;
             }
-            last_shape = shape;
-        }
-        
-        // Parse line
-        if (strstr(line, "<line")) {
-            SvgShape *shape = (SvgShape *)malloc(sizeof(SvgShape));
-            shape->type = SVG_SHAPE_LINE;
-            shape->id = ++shape_id;
-            shape->next = NULL;
-            
-            if (get_attribute(line, "x1", value, sizeof(value)))
-                shape->data.line.x1 = atof(value);
-            if (get_attribute(line, "y1", value, sizeof(value)))
-                shape->data.line.y1 = atof(value);
-            if (get_attribute(line, "x2", value, sizeof(value)))
-                shape->data.line.x2 = atof(value);
-            if (get_attribute(line, "y2", value, sizeof(value)))
-                shape->data.line.y2 = atof(value);
-            if (get_attribute(line, "stroke", value, sizeof(value)))
-                shape->data.line.stroke = strdup(value);
-            
-            if (!doc->shapes) {
-                doc->shapes = shape;
-            } else {
-                last_shape->next = shape;
+            if (i < old_count && j + k < now_count && old[i] == now[j + k]) {
+                skip_new = k;
+                break;
             }
-            last_shape = shape;
+        }
+        if (skip_old) {
+            i += skip_old; // deleted
+        } else if (skip_new) {
+            while (skip_new--) from[j++] = -1; // inserted
+        } else {
+            from[j++] = -1; // replaced
+            if (i < old_count) i++;
         }
     }
-    
-    fclose(file);
-    *doc_out = doc;
+}
+
+// Replace doc's contents with a fresh load of filename, keeping the doc pointer
+static int reload_full(SvgDocument *doc, const char *filename, const char *data, size_t size,
+                       SvgHashState *hashed, SvgChanges *changes) {
+    SvgDocument *fresh = NULL;
+    int result = data ? svg_load_from_memory(data, size, &fresh) : svg_load_from_file(filename, &fresh);
+    if (result != 0) return -1;
+
+    size_t count = fresh->shapes.count;
+    if (count > 0) {
+        changes->changed = (int *)malloc(count * sizeof(int));
+        if (!changes->changed) {
+            svg_free_document(fresh);
+            return -1;
+        }
+        memcpy(changes->changed, fresh->shapes.ids, count * sizeof(int));
+        changes->changed_count = (int)count;
+    }
+    changes->full = 1;
+
+    SvgDocument old = *doc;
+    *doc = *fresh;
+    *fresh = old;
+    svg_store_succeed(&doc->shapes, &fresh->shapes);
+    svg_free_document(fresh);
+    if (hashed) {
+        doc->element_hashes = hashed->hashes;
+        doc->element_count = hashed->count;
+        doc->structure_hash = hashed->structure;
+        doc->element_edits = doc->shapes.edits;
+        hashed->hashes = NULL;
+    }
     return 0;
 }
 
+int svg_reload_from_file(SvgDocument *doc, const char *filename, SvgChanges *changes) {
+    memset(changes, 0, sizeof(*changes));
+
+    // Hashes need the whole input twice, so pipes and gzip are read once in full
+    if (is_stdin(filename)) return reload_full(doc, filename, NULL, 0, NULL, changes);
+    SvgMappedFile mapped;
+    if (svg_map_file(filename, &mapped) != 0) return -1;
+    if (svg_inflate_is_gzip((const unsigned char *)mapped.data, mapped.size)) {
+        svg_unmap_file(&mapped);
+        return reload_full(doc, filename, NULL, 0, NULL, changes);
+    }
+
+    // First pass: only hash the tags
+    SvgHashState hashed;
+    memset(&hashed, 0, sizeof(hashed));
+    hashed.structure = SVG_HASH_SEED;
+    int result = svg_tokenize_buffer(mapped.data, mapped.size, hash_element, hash_text, &hashed);
+    free(hashed.frames);
+
+    // The shapes have to be the ones the hashes describe, without gaps
+    svg_store_compact(&doc->shapes);
+    size_t old_count = doc->shapes.count;
+    int comparable = result == 0 && doc->element_hashes && doc->element_count == old_count &&
+                     doc->element_edits == doc->shapes.edits && doc->structure_hash == hashed.structure;
+    if (result != 0 || !comparable) {
+        if (result == 0) result = reload_full(doc, filename, mapped.data, mapped.size, &hashed, changes);
+        free(hashed.hashes);
+        svg_unmap_file(&mapped);
+        return result;
+    }
+
+    long *from = (long *)malloc((hashed.count ? hashed.count : 1) * sizeof(long));
+    char *kept = (char *)calloc(old_count ? old_count : 1, 1);
+    result = from && kept ? 0 : -1;
+    // Kept lazy shapes would point into the mapping that is about to go
+    if (result == 0 && doc->source.data) result = svg_document_decode(doc);
+
+    if (result == 0) {
+        match_elements(doc->element_hashes, old_count, hashed.hashes, hashed.count, from);
+        int changed = 0;
+        for (size_t j = 0; j < hashed.count; j++) {
+            if (from[j] < 0) changed++;
+            else kept[from[j]] = 1;
+        }
+        changes->changed = (int *)malloc((changed ? changed : 1) * sizeof(int));
+        changes->removed = (int *)malloc((old_count - hashed.count + changed + 1) * sizeof(int));
+        if (!changes->changed || !changes->removed) result = -1;
+    }
+
+    // Second pass: decode only where nothing was kept, into new tables
+    SvgShapeStore old = doc->shapes;
+    SvgParseState state;
+    if (result == 0) {
+        svg_store_init(&doc->shapes);
+        init_parse_state(&state, doc);
+        state.old_shapes = &old;
+        state.reuse = from;
+        result = svg_tokenize_buffer(mapped.data, mapped.size, parse_element, parse_text, &state);
+        if (result == 0) {
+            finish_parse(&state);
+            svg_store_succeed(&doc->shapes, &old);
+            svg_store_release(&old);
+        } else {
+            svg_store_release(&doc->shapes);
+            doc->shapes = old;
+        }
+    }
+
+    if (result == 0) {
+        for (size_t j = 0; j < hashed.count; j++) {
+            if (from[j] < 0) changes->changed[changes->changed_count++] = (int)j + 1;
+        }
+        for (size_t i = 0; i < old_count; i++) {
+            if (!kept[i]) changes->removed[changes->removed_count++] = (int)i + 1;
+        }
+        free(doc->element_hashes);
+        doc->element_hashes = hashed.hashes;
+        doc->element_count = hashed.count;
+        doc->element_edits = doc->shapes.edits;
+        hashed.hashes = NULL;
+        if (doc->source.data) svg_unmap_file(&doc->source);
+    } else {
+        svg_changes_release(changes);
+    }
+
+    free(from);
+    free(kept);
+    free(hashed.hashes);
+    svg_unmap_file(&mapped);
+    return result;
+}
+
+void svg_changes_release(SvgChanges *changes) {
+    free(changes->changed);
+    free(changes->removed);
+    memset(changes, 0, sizeof(*changes));
+}
+
+int svg_load_from_file_mmap(const char *filename, SvgDocument **doc_out) {
+    // A pipe cannot be mapped; it is read through the stream window instead
+    if (is_stdin(filename)) return svg_load_from_file(filename, doc_out);
+
+    SvgMappedFile mapped;
+    if (svg_map_file(filename, &mapped) != 0) return -1;
+
+    // Compressed input has to be inflated in order; use the streaming loader
+    if (svg_inflate_is_gzip((const unsigned char *)mapped.data, mapped.size)) {
+        svg_unmap_file(&mapped);
+        return svg_load_from_file(filename, doc_out);
+    }
+
+    int result = svg_load_from_memory(mapped.data, mapped.size, doc_out);
+
+    svg_unmap_file(&mapped);
+    return result;
+}
+
 SvgDocument* create_svg_document(float width, float height) {
     SvgDocument *doc = (SvgDocument *)malloc(sizeof(SvgDocument));
     if (!doc) return NULL;
 
     doc->width = width;
     doc->height = height;
-    doc->shapes = NULL;
+    svg_store_init(&doc->shapes);
+    svg_arena_init(&doc->arena);
+    doc->definitions = NULL;
+    doc->definition_count = 0;
+    doc->definition_table = NULL;
+    doc->definition_slots = 0;
+    doc->styles = NULL;
+    doc->style_count = 1;
+    doc->style_table = NULL;
+    doc->style_slots = 0;
+    memset(&doc->source, 0, sizeof(doc->source));
+    doc->element_hashes = NULL;
+    doc->element_count = 0;
+    doc->structure_hash = 0;
+    doc->element_edits = 0;
+    doc->snapshot = NULL;
 
     return doc;
 }
 
-void svg_free_document(SvgDocument *doc) {
-    if (!doc) return;
+SvgShape* svg_document_new_shape(SvgDocument *doc, SvgShapeType type) {
+    SvgShape *shape = (SvgShape *)svg_arena_alloc(&doc->arena, sizeof(SvgShape));
+    if (!shape) return NULL;
 
-    SvgShape *current = doc->shapes;
-    while (current) {
-        SvgShape *next = current->next;
-        
-        // Free allocated strings
-        switch (current->type) {
-            case SVG_SHAPE_CIRCLE:
-                if (current->data.circle.fill) free(current->data.circle.fill);
-                break;
-            case SVG_SHAPE_RECT:
-                if (current->data.rect.fill) free(current->data.rect.fill);
-                break;
-            case SVG_SHAPE_LINE:
-                if (current->data.line.stroke) free(current->data.line.stroke);
-                break;
+    memset(shape, 0, sizeof(SvgShape));
+    shape->type = type;
+    shape->style = &svg_default_style;
+    return shape;
+}
+
+double* svg_document_new_points(SvgDocument *doc, int count) {
+    if (count <= 0) return NULL;
+    return (double *)svg_arena_alloc(&doc->arena, (size_t)count * 2 * sizeof(double));
+}
+
+// FNV-1a over the id bytes
+static unsigned hash_id(const char *id, size_t len) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) hash = (hash ^ (unsigned char)id[i]) * 16777619u;
+    return hash;
+}
+
+// Open addressing, kept at most half full; the table lives in the arena so a
+// grown table simply leaves the old one behind
+static int insert_definition(SvgDocument *doc, SvgDefinition *definition) {
+    if ((definition->index + 1) * 2 > doc->definition_slots) {
+        int slots = doc->definition_slots ? doc->definition_slots * 2 : 64;
+        SvgDefinition **table = (SvgDefinition **)svg_arena_alloc(&doc->arena, slots * sizeof(*table));
+        if (!table) return -1;
+        memset(table, 0, slots * sizeof(*table));
+        for (int i = 0; i < doc->definition_slots; i++) {
+            SvgDefinition *old = doc->definition_table[i];
+            if (!old) continue;
+            unsigned at = hash_id(old->id, strlen(old->id)) & (slots - 1);
+            while (table[at]) at = (at + 1) & (slots - 1);
+            table[at] = old;
         }
-        
-        free(current);
-        current = next;
+        doc->definition_table = table;
+        doc->definition_slots = slots;
     }
 
+    size_t len = strlen(definition->id);
+    unsigned mask = doc->definition_slots - 1;
+    unsigned at = hash_id(definition->id, len) & mask;
+    while (doc->definition_table[at]) {
+        // The first definition of an id stays the one lookups find
+        if (strcmp(doc->definition_table[at]->id, definition->id) == 0) return 0;
+        at = (at + 1) & mask;
+    }
+    doc->definition_table[at] = definition;
+    return 0;
+}
+
+SvgDefinition* svg_document_add_definition(SvgDocument *doc, const char *id, size_t len) {
+    SvgDefinition *definition = (SvgDefinition *)svg_arena_alloc(&doc->arena, sizeof(SvgDefinition));
+    if (!definition) return NULL;
+    definition->id = svg_arena_strndup(&doc->arena, id, len);
+    if (!definition->id) return NULL;
+    definition->shapes = NULL;
+    definition->index = doc->definition_count;
+    definition->settled = SVG_DEFINITION_UNSETTLED;
+    definition->height = 0;
+    definition->drawn = 0;
+    definition->box[0] = definition->box[1] = HUGE_VAL;
+    definition->box[2] = definition->box[3] = -HUGE_VAL;
+    if (insert_definition(doc, definition) != 0) return NULL;
+
+    doc->definition_count++;
+    definition->next = doc->definitions;
+    doc->definitions = definition;
+    return definition;
+}
+
+const SvgDefinition* svg_document_find_definition(const SvgDocument *doc, const char *id, size_t len) {
+    if (!doc->definition_slots) return NULL;
+    unsigned mask = doc->definition_slots - 1;
+    unsigned at = hash_id(id, len) & mask;
+    for (SvgDefinition *definition; (definition = doc->definition_table[at]) != NULL; at = (at + 1) & mask) {
+        if (strncmp(definition->id, id, len) == 0 && definition->id[len] == '\0') return definition;
+    }
+    return NULL;
+}
+
+// Same scheme as the definition table, keyed by the style's value
+static int insert_style(SvgDocument *doc, SvgStyle *style) {
+    if (style->index * 2 > doc->style_slots) {
+        int slots = doc->style_slots ? doc->style_slots * 2 : 64;
+        SvgStyle **table = (SvgStyle **)svg_arena_alloc(&doc->arena, slots * sizeof(*table));
+        if (!table) return -1;
+        memset(table, 0, slots * sizeof(*table));
+        for (int i = 0; i < doc->style_slots; i++) {
+            SvgStyle *old = doc->style_table[i];
+            if (!old) continue;
+            unsigned at = svg_style_hash(old) & (slots - 1);
+            while (table[at]) at = (at + 1) & (slots - 1);
+            table[at] = old;
+        }
+        doc->style_table = table;
+        doc->style_slots = slots;
+    }
+
+    unsigned mask = doc->style_slots - 1;
+    unsigned at = svg_style_hash(style) & mask;
+    while (doc->style_table[at]) at = (at + 1) & mask;
+    doc->style_table[at] = style;
+    return 0;
+}
+
+const SvgStyle* svg_document_intern_style(SvgDocument *doc, const SvgStyle *style) {
+    if (svg_style_equal(style, &svg_default_style)) return &svg_default_style;
+    if (doc->style_slots) {
+        unsigned mask = doc->style_slots - 1;
+        unsigned at = svg_style_hash(style) & mask;
+        for (SvgStyle *found; (found = doc->style_table[at]) != NULL; at = (at + 1) & mask) {
+            if (svg_style_equal(found, style)) return found;
+        }
+    }
+
+    SvgStyle *copy = (SvgStyle *)svg_arena_alloc(&doc->arena, sizeof(SvgStyle));
+    if (!copy) return NULL;
+    *copy = *style;
+    copy->index = doc->style_count;
+    if (insert_style(doc, copy) != 0) return NULL;
+
+    doc->style_count++;
+    copy->next = doc->styles;
+    doc->styles = copy;
+    return copy;
+}
+
+void svg_free_document(SvgDocument *doc) {
+    if (!doc) return;
+
+    // Everything else lives in the arena: no per-shape frees
+    svg_store_release(&doc->shapes);
+    svg_arena_release(&doc->arena);
+    svg_unmap_file(&doc->source);
+    free(doc->element_hashes);
+    svg_version_release(doc->snapshot);
     free(doc);
 }
 
@@ -0,0 +1,106 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "../include/svg_platform.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+
+static DWORD WINAPI thread_entry(LPVOID param) {
+    SvgThread *thread = (SvgThread *)param;
+    thread->func(thread->arg);
+    return 0;
+}
+
+int svg_thread_start(SvgThread *thread, SvgThreadFunc fn, void *arg) {
+    thread->func = fn;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+    return thread->handle ? 0 : -1;
+}
+
+void svg_thread_join(SvgThread *thread) {
+    if (!thread->handle) return;
+    WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+    CloseHandle((HANDLE)thread->handle);
+    thread->handle = NULL;
+}
+
+long svg_atomic_add(volatile long *value, long delta) {
+    return InterlockedExchangeAdd(value, delta) + delta;
+}
+
+int svg_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+double svg_wall_seconds(void) {
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+}
+
+FILE *svg_stdin_binary(void) {
+    _setmode(_fileno(stdin), _O_BINARY);
+    return stdin;
+}
+
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+static void *thread_entry(void *param) {
+    SvgThread *thread = (SvgThread *)param;
+    thread->func(thread->arg);
+    return NULL;
+}
+
+int svg_thread_start(SvgThread *thread, SvgThreadFunc fn, void *arg) {
+    pthread_t *handle = (pthread_t *)malloc(sizeof(pthread_t));
+    if (!handle) return -1;
+
+    thread->func = fn;
+    thread->arg = arg;
+    if (pthread_create(handle, NULL, thread_entry, thread) != 0) {
+        free(handle);
+        thread->handle = NULL;
+        return -1;
+    }
+    thread->handle = handle;
+    return 0;
+}
+
+void svg_thread_join(SvgThread *thread) {
+    if (!thread->handle) return;
+    pthread_join(*(pthread_t *)thread->handle, NULL);
+    free(thread->handle);
+    thread->handle = NULL;
+}
+
+long svg_atomic_add(volatile long *value, long delta) {
+    return __atomic_add_fetch(value, delta, __ATOMIC_ACQ_REL);
+}
+
+int svg_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+double svg_wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+FILE *svg_stdin_binary(void) {
+    return stdin;
+}
+#endif
@@ -0,0 +1,166 @@
+#include "../include/svg_polygon.h"
+#include "../include/svg_number.h"
+#include "../include/svg_transform.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define SVG_POLYGON_STACK_EDGES 64 // outlines up to this size are filled without allocating
+
+static const char *skip_separators(const char *p, const char *end) {
+    while (p < end && (*p == ',' || (unsigned char)*p <= 0x20)) p++;
+    return p;
+}
+
+int svg_points_count(const char *s, size_t len) {
+    const char *p = s, *end = s + len;
+    int numbers = 0;
+    double v;
+    while (numbers < INT_MAX) {
+        p = skip_separators(p, end);
+        const char *next = svg_parse_number(p, end, &v);
+        if (next == p) break; // the list ends at the first thing that is not a number
+        numbers++;
+        p = next;
+    }
+    return numbers / 2;
+}
+
+int svg_points_parse(const char *s, size_t len, double *out, int count) {
+    const char *p = s, *end = s + len;
+    int numbers = 0;
+    while (numbers < 2 * count) {
+        p = skip_separators(p, end);
+        const char *next = svg_parse_number(p, end, &out[numbers]);
+        if (next == p) break;
+        numbers++;
+        p = next;
+    }
+    return numbers / 2;
+}
+
+// One non-horizontal side, oriented top to bottom; rows y0 <= y < y1 cross it
+typedef struct {
+    double y0, y1;
+    double x0;//x at y0
+    double slope;//change of x per row
+    int dir;//+1 when the outline runs downwards here, -1 upwards
+} SvgEdge;
+
+typedef struct {
+    double x;
+    int dir;
+} SvgCrossing;
+
+static int compare_edges(const void *a, const void *b) {
+    double ya = ((const SvgEdge *)a)->y0, yb = ((const SvgEdge *)b)->y0;
+    return ya < yb ? -1 : ya > yb;
+}
+
+// Pixels start <= x < stop of row y, clipped
+static void emit_span(int y, double start, double stop, const int clip[4], SvgSpanFunc span, void *ctx) {
+    double x0 = ceil(start), x1 = ceil(stop) - 1.0;
+    if (x0 < clip[0]) x0 = clip[0];
+    if (x1 > clip[2]) x1 = clip[2];
+    if (x0 <= x1) span(ctx, y, (int)x0, (int)x1);
+}
+
+int svg_polygon_fill(const double *points, int count, const SvgMatrix *m, int evenodd,
+                     const int clip[4], SvgSpanFunc span, void *ctx) {
+    if (count < 3) return 0;
+
+    SvgEdge stack_edges[SVG_POLYGON_STACK_EDGES];
+    SvgCrossing stack_crossings[SVG_POLYGON_STACK_EDGES];
+    const SvgEdge *stack_active[SVG_POLYGON_STACK_EDGES];
+    SvgEdge *edges = stack_edges;
+    SvgCrossing *crossings = stack_crossings;
+    const SvgEdge **active = stack_active;
+    void *block = NULL;
+    if (count > SVG_POLYGON_STACK_EDGES) {
+        // Edges and crossings hold doubles, so they go first in the block
+        block = malloc((size_t)count * (sizeof(SvgEdge) + sizeof(SvgCrossing) + sizeof(SvgEdge *)));
+        if (!block) return -1;
+        edges = (SvgEdge *)block;
+        crossings = (SvgCrossing *)(edges + count);
+        active = (const SvgEdge **)(crossings + count);
+    }
+
+    // Sides in device coordinates; horizontal ones never cross a row
+    int edge_count = 0;
+    double top = HUGE_VAL, bottom = -HUGE_VAL;
+    double px, py;
+    svg_matrix_apply(m, points[2 * (count - 1)], points[2 * count - 1], &px, &py);
+    for (int i = 0; i < count; i++) {
+        double qx, qy;
+        svg_matrix_apply(m, points[2 * i], points[2 * i + 1], &qx, &qy);
+        if (py != qy && isfinite(px) && isfinite(py) && isfinite(qx) && isfinite(qy)) {
+            SvgEdge *e = &edges[edge_count++];
+            e->dir = py < qy ? 1 : -1;
+            e->y0 = py < qy ? py : qy;
+            e->y1 = py < qy ? qy : py;
+            e->x0 = py < qy ? px : qx;
+            e->slope = (qx - px) / (qy - py);
+            if (e->y0 < top) top = e->y0;
+            if (e->y1 > bottom) bottom = e->y1;
+        }
+        px = qx;
+        py = qy;
+    }
+    qsort(edges, edge_count, sizeof(SvgEdge), compare_edges);
+
+    double first = ceil(top) > clip[1] ? ceil(top) : clip[1];
+    double last = ceil(bottom) - 1.0 < clip[3] ? ceil(bottom) - 1.0 : clip[3];
+    if (!(first <= last)) edge_count = 0; // nothing within the clip rows
+    int y0 = edge_count ? (int)first : 0, y1 = edge_count ? (int)last : -1;
+    int next = 0, active_count = 0;
+    for (int y = y0; y <= y1; y++) {
+        // Drop the sides that ended above this row, take the ones that reach it
+        int kept = 0;
+        for (int i = 0; i < active_count; i++) {
+            if (active[i]->y1 > y) active[kept++] = active[i];
+        }
+        active_count = kept;
+        for (; next < edge_count && edges[next].y0 <= y; next++) {
+            if (edges[next].y1 > y) active[active_count++] = &edges[next];
+        }
+
+        // A few crossings per row: insertion sort by x
+        for (int i = 0; i < active_count; i++) {
+            double x = active[i]->x0 + (y - active[i]->y0) * active[i]->slope;
+            int j = i;
+            for (; j > 0 && crossings[j - 1].x > x; j--) crossings[j] = crossings[j - 1];
+            crossings[j].x = x;
+            crossings[j].dir = active[i]->dir;
+        }
+
+        // Inside stretches between crossings; neighbours with no gap merge
+        int winding = 0;
+        double start = 0.0;
+        for (int i = 0; i < active_count; i++) {
+            int was_inside = evenodd ? (i & 1) : winding != 0;
+            winding += crossings[i].dir;
+            int inside = evenodd ? !(i & 1) : winding != 0;
+            if (!was_inside && inside) start = crossings[i].x;
+            else if (was_inside && !inside) emit_span(y, start, crossings[i].x, clip, span, ctx);
+        }
+    }
+
+    free(block);
+    return 0;
+}
+
+int svg_polygon_contains(const double *points, int count, int evenodd, double x, double y) {
+    if (count < 3) return 0;
+
+    // Same sampling as the fill: count the sides crossing row y at or left of x
+    int winding = 0, crossed = 0;
+    for (int i = 0, j = count - 1; i < count; j = i++) {
+        double x0 = points[2 * j], y0 = points[2 * j + 1];
+        double x1 = points[2 * i], y1 = points[2 * i + 1];
+        if ((y0 <= y) == (y1 <= y)) continue;
+        if (x0 + (y - y0) * (x1 - x0) / (y1 - y0) > x) continue;
+        winding += y1 > y0 ? 1 : -1;
+        crossed++;
+    }
+    return evenodd ? crossed & 1 : winding != 0;
+}
@@ -0,0 +1,470 @@
+#include "../include/svg_raster.h"
+#include "../include/svg_color.h"
+#include "../include/svg_transform.h"
+#include "../include/svg_style.h"
+#include "../include/svg_polygon.h"
+#include "../include/svg_parser.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SVG_SPRITE_MAX_PIXELS (1 << 22) // larger definitions are drawn per instance
+
+// Where drawing lands: the canvas, or a definition's tile; mask (tiles only)
+// records which pixels were painted
+typedef struct {
+    uint8_t *pixels;
+    uint8_t *mask;
+    int width, height;
+    int origin_x, origin_y;//document position of pixel (0, 0)
+} SvgTarget;
+
+// One horizontal stretch of painted pixels in a definition's tile
+typedef struct {
+    int x, y;//tile position
+    int length;
+    int offset;//first of its RGB triples in SvgSprite.colors
+} SvgSpriteRun;
+
+// A definition rendered once at its own origin, kept as runs of painted pixels
+typedef struct SvgSprite {
+    int state;//SPRITE_*
+    int origin_x, origin_y;//document position of tile pixel (0, 0)
+    SvgSpriteRun *runs;
+    int run_count;
+    uint8_t *colors;
+} SvgSprite;
+
+enum { SPRITE_UNBUILT, SPRITE_READY, SPRITE_UNUSABLE };
+
+static void draw_shape(SvgRaster *raster, const SvgTarget *target, const SvgShape *shape, int depth);
+
+static void draw_pixel(const SvgTarget *target, int x, int y, uint32_t color) {
+    x -= target->origin_x;
+    y -= target->origin_y;
+    if (x < 0 || x >= target->width || y < 0 || y >= target->height) return;
+    
+    size_t index = ((size_t)y * target->width + x) * 3;
+    target->pixels[index + 0] = (color >> 16) & 0xFF; // R
+    target->pixels[index + 1] = (color >> 8) & 0xFF;  // G
+    target->pixels[index + 2] = color & 0xFF;         // B
+    if (target->mask) target->mask[index / 3] = 1;
+}
+
+// Pixels x0..x1 of row y, in document coordinates already clipped to the target
+static void paint_run(const SvgTarget *target, int y, int x0, int x1, uint32_t color) {
+    size_t row = (size_t)(y - target->origin_y) * target->width - target->origin_x;
+    for (int x = x0; x <= x1; x++) {
+        uint8_t *pixel = target->pixels + (row + x) * 3;
+        pixel[0] = (color >> 16) & 0xFF;
+        pixel[1] = (color >> 8) & 0xFF;
+        pixel[2] = color & 0xFF;
+        if (target->mask) target->mask[row + x] = 1;
+    }
+}
+
+// Clip [*lo, *hi] to the target's columns (axis 0) or rows (axis 1)
+static void clip_range(const SvgTarget *target, int axis, int *lo, int *hi) {
+    int first = axis ? target->origin_y : target->origin_x;
+    int last = first + (axis ? target->height : target->width) - 1;
+    if (*lo < first) *lo = first;
+    if (*hi > last) *hi = last;
+}
+
+static void draw_circle(const SvgTarget *target, const SvgCircle *circle, const SvgPaint *fill) {
+    int cx = (int)circle->cx;
+    int cy = (int)circle->cy;
+    int r = (int)circle->r;
+
+    if (fill->kind == SVG_PAINT_NONE) return;
+    uint32_t color = svg_paint_to_rgb(fill, 0xFFFFFF); // default white
+
+    // Only the part of the bounding square on the target
+    int y0 = cy - r, y1 = cy + r, x0 = cx - r, x1 = cx + r;
+    clip_range(target, 1, &y0, &y1);
+    clip_range(target, 0, &x0, &x1);
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            int dx = x - cx;
+            int dy = y - cy;
+            if (dx * dx + dy * dy <= r * r) {
+                draw_pixel(target, x, y, color);
+            }
+        }
+    }
+}
+
+static void draw_rect(const SvgTarget *target, const SvgRect *rect, const SvgPaint *fill) {
+    int x1 = (int)rect->x;
+    int y1 = (int)rect->y;
+    int x2 = x1 + (int)rect->width - 1;
+    int y2 = y1 + (int)rect->height - 1;
+
+    if (fill->kind == SVG_PAINT_NONE) return;
+    uint32_t color = svg_paint_to_rgb(fill, 0xFFFFFF); // default white
+
+    clip_range(target, 1, &y1, &y2);
+    clip_range(target, 0, &x1, &x2);
+    for (int y = y1; y <= y2; y++) paint_run(target, y, x1, x2, color);
+}
+
+// Bresenham's line algorithm; ends are floored so a whole-pixel shift of the
+// line shifts its pixels the same, on either side of the origin
+static void draw_line(const SvgTarget *target, const SvgLine *line, const SvgPaint *stroke) {
+    int x1 = (int)floor(line->x1);
+    int y1 = (int)floor(line->y1);
+    int x2 = (int)floor(line->x2);
+    int y2 = (int)floor(line->y2);
+
+    if (stroke->kind == SVG_PAINT_NONE) return;
+    uint32_t color = svg_paint_to_rgb(stroke, 0x000000); // default black
+
+    int dx = abs(x2 - x1);
+    int dy = abs(y2 - y1);
+    int sx = x1 < x2 ? 1 : -1;
+    int sy = y1 < y2 ? 1 : -1;
+    int err = dx - dy;
+
+    while (1) {
+        draw_pixel(target, x1, y1, color);
+
+        if (x1 == x2 && y1 == y2) break;
+
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x1 += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y1 += sy;
+        }
+    }
+}
+
+// Circle or rect under a transform: the matrix is inverted once and each row
+// becomes one span; pixels are sampled at integer positions like above
+static void fill_transformed(const SvgTarget *target, const SvgShape *shape, uint32_t color) {
+    SvgMatrix inverse;
+    if (svg_matrix_invert(shape->transform, &inverse) != 0) return; // flattened to nothing
+
+    // Rows and columns of the target, in document coordinates
+    double top = target->origin_y, bottom = target->origin_y + target->height - 1;
+    double first = target->origin_x, last = target->origin_x + target->width - 1;
+
+    double bounds[4];
+    svg_shape_bounds(shape, bounds);
+    if (!(bounds[1] <= bottom && bounds[3] >= top)) return; // off the target (or NaN)
+    int y0 = bounds[1] > top ? (int)ceil(bounds[1]) : (int)top;
+    int y1 = bounds[3] < bottom ? (int)floor(bounds[3]) : (int)bottom;
+
+    for (int y = y0; y <= y1; y++) {
+        double left, right;
+        if (!svg_shape_row_span(shape, &inverse, y, &left, &right)) continue;
+        if (left < first) left = first;
+        if (right > last) right = last;
+        if (!(left <= right)) continue;
+        paint_run(target, y, (int)ceil(left), (int)floor(right), color);
+    }
+}
+
+typedef struct {
+    const SvgTarget *target;
+    uint32_t color;
+} SvgRasterFill;
+
+static void fill_span(void *ctx, int y, int x0, int x1) {
+    const SvgRasterFill *fill = (const SvgRasterFill *)ctx;
+    paint_run(fill->target, y, x0, x1, fill->color);
+}
+
+// Polygon or polyline: one scanline fill over the covered pixels, transform
+// applied to the points, then the outline on top. Polygons are filled unless
+// fill is none and only outlined when stroke is set; polylines the other way round
+static void draw_poly(const SvgTarget *target, const SvgShape *shape) {
+    const SvgPoly *poly = &shape->data.poly;
+    const SvgStyle *style = shape->style;
+    int closed = shape->type == SVG_SHAPE_POLYGON;
+
+    if (style->fill.kind != SVG_PAINT_NONE && (closed || svg_paint_is_set(&style->fill))) {
+        SvgRasterFill fill = {target, svg_paint_to_rgb(&style->fill, 0xFFFFFF)}; // default white
+        int clip[4] = {target->origin_x, target->origin_y,
+                       target->origin_x + target->width - 1, target->origin_y + target->height - 1};
+        svg_polygon_fill(poly->points, poly->count, shape->transform,
+                         style->fill_rule == SVG_FILL_RULE_EVENODD, clip, fill_span, &fill);
+    }
+
+    if (style->stroke.kind == SVG_PAINT_NONE || (closed && !svg_paint_is_set(&style->stroke))) return;
+    if (poly->count < 2) return;
+    int segments = closed ? poly->count : poly->count - 1;
+    for (int i = 0; i < segments; i++) {
+        int j = (i + 1) % poly->count;
+        SvgLine side;
+        svg_matrix_apply(shape->transform, poly->points[2 * i], poly->points[2 * i + 1], &side.x1, &side.y1);
+        svg_matrix_apply(shape->transform, poly->points[2 * j], poly->points[2 * j + 1], &side.x2, &side.y2);
+        draw_line(target, &side, &style->stroke);
+    }
+}
+
+static void draw_transformed(const SvgTarget *target, const SvgShape *shape) {
+    if (shape->type == SVG_SHAPE_POLYGON || shape->type == SVG_SHAPE_POLYLINE) {
+        draw_poly(target, shape);
+        return;
+    }
+    if (shape->type == SVG_SHAPE_LINE) {
+        SvgLine line = shape->data.line;
+        svg_matrix_apply(shape->transform, line.x1, line.y1, &line.x1, &line.y1);
+        svg_matrix_apply(shape->transform, line.x2, line.y2, &line.x2, &line.y2);
+        draw_line(target, &line, &shape->style->stroke);
+        return;
+    }
+
+    const SvgPaint *fill = &shape->style->fill;
+    if (fill->kind == SVG_PAINT_NONE) return;
+    fill_transformed(target, shape, svg_paint_to_rgb(fill, 0xFFFFFF));
+}
+
+// Every shape of the definition, placed by m
+static void draw_definition(SvgRaster *raster, const SvgTarget *target, const SvgDefinition *definition,
+                            const SvgMatrix *m, int depth) {
+    for (const SvgShape *part = definition->shapes; part; part = part->next) {
+        SvgShape placed = *part;
+        SvgMatrix composed;
+        if (m) {
+            if (part->transform) svg_matrix_multiply(m, part->transform, &composed);
+            else composed = *m;
+            placed.transform = &composed;
+        }
+        draw_shape(raster, target, &placed, depth + 1);
+    }
+}
+
+// Render the definition into a masked tile once and keep only the painted runs.
+// The parts are drawn under the identity at depth 0, through the same fills as
+// an instance drawn shape by shape, so a blit matches that pixel for pixel
+// wherever the use is nested
+static int build_sprite(SvgRaster *raster, SvgSprite *sprite, const SvgDefinition *definition) {
+    SvgShape instance;
+    memset(&instance, 0, sizeof(instance));
+    instance.type = SVG_SHAPE_USE;
+    instance.style = &svg_default_style;
+    instance.data.use.definition = definition;
+    double bounds[4];
+    svg_shape_bounds(&instance, bounds);
+
+    // One pixel of margin either side covers the integer rounding of the shapes
+    double left = floor(bounds[0]) - 1.0, top = floor(bounds[1]) - 1.0;
+    double width = ceil(bounds[2]) + 2.0 - left, height = ceil(bounds[3]) + 2.0 - top;
+    if (!(width * height <= SVG_SPRITE_MAX_PIXELS) || !(fabs(left) < 1e6 && fabs(top) < 1e6)) return -1;
+
+    SvgTarget tile;
+    tile.width = (int)width;
+    tile.height = (int)height;
+    tile.origin_x = (int)left;
+    tile.origin_y = (int)top;
+    size_t area = (size_t)tile.width * tile.height;
+    tile.pixels = (uint8_t *)malloc(area * 3);
+    tile.mask = (uint8_t *)calloc(area, 1);
+    if (!tile.pixels || !tile.mask) {
+        free(tile.pixels);
+        free(tile.mask);
+        return -1;
+    }
+    SvgMatrix identity;
+    svg_matrix_identity(&identity);
+    draw_definition(raster, &tile, definition, &identity, 0);
+
+    // Count first so both arrays are allocated exactly once
+    int run_count = 0, painted = 0;
+    for (size_t i = 0; i < area; i++) {
+        if (!tile.mask[i]) continue;
+        painted++;
+        if (i % tile.width == 0 || !tile.mask[i - 1]) run_count++;
+    }
+    sprite->runs = (SvgSpriteRun *)malloc((run_count ? run_count : 1) * sizeof(SvgSpriteRun));
+    sprite->colors = (uint8_t *)malloc(painted ? (size_t)painted * 3 : 1);
+    if (!sprite->runs || !sprite->colors) {
+        free(sprite->runs);
+        free(sprite->colors);
+        free(tile.pixels);
+        free(tile.mask);
+        return -1;
+    }
+
+    SvgSpriteRun *run = NULL;
+    int offset = 0;
+    for (size_t i = 0; i < area; i++) {
+        if (!tile.mask[i]) continue;
+        int x = (int)(i % tile.width);
+        if (x == 0 || !tile.mask[i - 1]) {
+            run = run ? run + 1 : sprite->runs;
+            run->x = x;
+            run->y = (int)(i / tile.width);
+            run->length = 0;
+            run->offset = offset;
+        }
+        memcpy(sprite->colors + (size_t)offset * 3, tile.pixels + i * 3, 3);
+        run->length++;
+        offset++;
+    }
+    sprite->run_count = run_count;
+    sprite->origin_x = tile.origin_x;
+    sprite->origin_y = tile.origin_y;
+
+    free(tile.pixels);
+    free(tile.mask);
+    return 0;
+}
+
+static SvgSprite *find_sprite(SvgRaster *raster, const SvgDefinition *definition) {
+    if (definition->index >= raster->sprite_count) {
+        int count = definition->index + 1;
+        if (count < raster->sprite_count * 2) count = raster->sprite_count * 2;
+        SvgSprite *sprites = (SvgSprite *)realloc(raster->sprites, count * sizeof(SvgSprite));
+        if (!sprites) return NULL;
+        memset(sprites + raster->sprite_count, 0, (count - raster->sprite_count) * sizeof(SvgSprite));
+        raster->sprites = sprites;
+        raster->sprite_count = count;
+    }
+
+    SvgSprite *sprite = &raster->sprites[definition->index];
+    if (sprite->state == SPRITE_UNBUILT) {
+        // Building may recurse into nested definitions and move the array
+        sprite->state = SPRITE_UNUSABLE;
+        SvgSprite built;
+        memset(&built, 0, sizeof(built));
+        int result = build_sprite(raster, &built, definition);
+        sprite = &raster->sprites[definition->index];
+        if (result == 0) {
+            built.state = SPRITE_READY;
+            *sprite = built;
+        }
+    }
+    return sprite->state == SPRITE_READY ? sprite : NULL;
+}
+
+static void blit_sprite(const SvgTarget *target, const SvgSprite *sprite, int dx, int dy) {
+    for (int i = 0; i < sprite->run_count; i++) {
+        const SvgSpriteRun *run = &sprite->runs[i];
+        long y = (long)sprite->origin_y + dy + run->y - target->origin_y;
+        long x = (long)sprite->origin_x + dx + run->x - target->origin_x;
+        if (y < 0 || y >= target->height) continue;
+
+        long skip = x < 0 ? -x : 0;
+        long length = run->length;
+        if (x + length > target->width) length = target->width - x;
+        if (length <= skip) continue;
+
+        size_t at = (size_t)y * target->width + x + skip;
+        memcpy(target->pixels + at * 3, sprite->colors + ((size_t)run->offset + skip) * 3,
+               (size_t)(length - skip) * 3);
+        if (target->mask) memset(target->mask + at, 1, (size_t)(length - skip));
+    }
+}
+
+// Whole-pixel offsets reuse the definition's runs; anything else draws each
+// of its shapes under the composed matrix
+static void draw_use(SvgRaster *raster, const SvgTarget *target, const SvgShape *shape, int depth) {
+    const SvgDefinition *definition = shape->data.use.definition;
+    if (!definition || depth >= SVG_MAX_USE_DEPTH) return;
+
+    SvgMatrix m;
+    svg_use_matrix(shape, &m);
+    if (m.a == 1.0 && m.b == 0.0 && m.c == 0.0 && m.d == 1.0 &&
+        m.e == floor(m.e) && m.f == floor(m.f) && fabs(m.e) < 1e6 && fabs(m.f) < 1e6) {
+        const SvgSprite *sprite = find_sprite(raster, definition);
+        if (sprite) {
+            blit_sprite(target, sprite, (int)m.e, (int)m.f);
+            return;
+        }
+    }
+    draw_definition(raster, target, definition, &m, depth);
+}
+
+static void draw_shape(SvgRaster *raster, const SvgTarget *target, const SvgShape *shape, int depth) {
+    if (shape->type == SVG_SHAPE_USE) {
+        draw_use(raster, target, shape, depth);
+        return;
+    }
+    if (shape->transform) {
+        draw_transformed(target, shape);
+        return;
+    }
+    switch (shape->type) {
+        case SVG_SHAPE_CIRCLE:
+            draw_circle(target, &shape->data.circle, &shape->style->fill);
+            break;
+        case SVG_SHAPE_RECT:
+            draw_rect(target, &shape->data.rect, &shape->style->fill);
+            break;
+        case SVG_SHAPE_LINE:
+            draw_line(target, &shape->data.line, &shape->style->stroke);
+            break;
+        case SVG_SHAPE_POLYGON:
+        case SVG_SHAPE_POLYLINE:
+            draw_poly(target, shape);
+            break;
+        case SVG_SHAPE_USE:
+            break;
+    }
+}
+
+int svg_raster_init(SvgRaster *raster, int width, int height) {
+    raster->pixels = NULL;
+    raster->width = width;
+    raster->height = height;
+    raster->sprites = NULL;
+    raster->sprite_count = 0;
+    if (width <= 0 || height <= 0) return -1;
+
+    raster->pixels = (uint8_t *)malloc((size_t)width * height * 3);
+    if (!raster->pixels) return -1;
+
+    // Fill with white background
+    memset(raster->pixels, 255, (size_t)width * height * 3);
+    return 0;
+}
+
+void svg_raster_draw_shape(SvgRaster *raster, const SvgShape *shape) {
+    SvgTarget canvas = {raster->pixels, NULL, raster->width, raster->height, 0, 0};
+    draw_shape(raster, &canvas, shape, 0);
+}
+
+void svg_raster_draw_document(SvgRaster *raster, const SvgDocument *doc) {
+    SvgShapeIter it;
+    for (const SvgShape *current = svg_shapes_first(&it, doc); current; current = svg_shapes_next(&it)) {
+        // Skip shapes wholly off the canvas; the pixel either side covers the
+        // rounding of untransformed shapes to whole pixels (NaN bounds are drawn)
+        const double *box = it.bounds;
+        if (box[2] < -1.0 || box[3] < -1.0 || box[0] > raster->width || box[1] > raster->height) continue;
+        svg_raster_draw_shape(raster, current);
+    }
+}
+
+int svg_raster_draw_region(SvgRaster *raster, const SvgDocument *doc, int x, int y) {
+    SvgTarget region = {raster->pixels, NULL, raster->width, raster->height, x, y};
+    double rect[4] = {x - 1.0, y - 1.0, (double)x + raster->width, (double)y + raster->height};
+    SvgShapeQuery query = {NULL, 0, 0};
+    if (svg_document_query_rect(doc, rect, &query) != 0) return -1;
+
+    int result = 0;
+    for (size_t i = 0; i < query.count && result == 0; i++) {
+        SvgShape shape;
+        result = svg_document_get_shape(doc, query.handles[i], &shape);
+        if (result == 0) draw_shape(raster, &region, &shape, 0);
+    }
+    svg_shape_query_release(&query);
+    return result;
+}
+
+void svg_raster_release(SvgRaster *raster) {
+    free(raster->pixels);
+    raster->pixels = NULL;
+    for (int i = 0; i < raster->sprite_count; i++) {
+        free(raster->sprites[i].runs);
+        free(raster->sprites[i].colors);
+    }
+    free(raster->sprites);
+    raster->sprites = NULL;
+    raster->sprite_count = 0;
+}
@@ -1,55 +1,97 @@
 #include "../include/svg_render.h"
+#include "../include/svg_color.h"
+#include "../include/svg_parser.h"
 #include <stdio.h>
+#include <string.h>
 
 void svg_print_summary(const SvgDocument *doc) {
     if (!doc) return;
     
-    int count = 0;
-    SvgShape *current = doc->shapes;
-    while (current) {
-        count++;
-        current = current->next;
-    }
-    
     printf("SVG Document: width=%.2f, height=%.2f\n", doc->width, doc->height);
-    printf("Total shapes: %d\n", count);
+    printf("Total shapes: %lu\n", (unsigned long)svg_document_shape_count(doc));
+    printf("By type: circle=%lu, rect=%lu, line=%lu, polygon=%lu, polyline=%lu, use=%lu\n",
+           (unsigned long)svg_document_type_count(doc, SVG_SHAPE_CIRCLE),
+           (unsigned long)svg_document_type_count(doc, SVG_SHAPE_RECT),
+           (unsigned long)svg_document_type_count(doc, SVG_SHAPE_LINE),
+           (unsigned long)svg_document_type_count(doc, SVG_SHAPE_POLYGON),
+           (unsigned long)svg_document_type_count(doc, SVG_SHAPE_POLYLINE),
+           (unsigned long)svg_document_type_count(doc, SVG_SHAPE_USE));
+
+    // Known without decoding anything; a lazy summary leaves it out
+    double bounds[4];
+    if (svg_document_bounds(doc, bounds) == 0)
+        printf("Bounds: min=(%.2f,%.2f), max=(%.2f,%.2f)\n", bounds[0], bounds[1], bounds[2], bounds[3]);
 }
 
 void svg_print_shapes(const SvgDocument *doc) {
     if (!doc) return;
     
-    SvgShape *current = doc->shapes;
-    while (current) {
+    SvgShapeIter it;
+    char color[16];
+    for (const SvgShape *current = svg_shapes_first(&it, doc); current; current = svg_shapes_next(&it)) {
         switch (current->type) {
             case SVG_SHAPE_CIRCLE:
-                printf("[%d] CIRCLE: cx=%.2f, cy=%.2f, r=%.2f, fill=%s\n",
+                printf("[%d] CIRCLE: cx=%.2f, cy=%.2f, r=%.2f, fill=%s",
                        current->id,
                        current->data.circle.cx,
                        current->data.circle.cy,
                        current->data.circle.r,
-                       current->data.circle.fill ? current->data.circle.fill : "none");
+                       svg_paint_format(&current->style->fill, color, "none"));
                 break;
             
             case SVG_SHAPE_RECT:
-                printf("[%d] RECT: x=%.2f, y=%.2f, width=%.2f, height=%.2f, fill=%s\n",
+                printf("[%d] RECT: x=%.2f, y=%.2f, width=%.2f, height=%.2f, fill=%s",
                        current->id,
                        current->data.rect.x,
                        current->data.rect.y,
                        current->data.rect.width,
                        current->data.rect.height,
-                       current->data.rect.fill ? current->data.rect.fill : "none");
+                       svg_paint_format(&current->style->fill, color, "none"));
                 break;
             
             case SVG_SHAPE_LINE:
-                printf("[%d] LINE: from (%.2f,%.2f) to (%.2f,%.2f), stroke=%s\n",
+                printf("[%d] LINE: from (%.2f,%.2f) to (%.2f,%.2f), stroke=%s",
                        current->id,
                        current->data.line.x1,
                        current->data.line.y1,
                        current->data.line.x2,
                        current->data.line.y2,
-                       current->data.line.stroke ? current->data.line.stroke : "none");
+                       svg_paint_format(&current->style->stroke, color, "none"));
                 break;
+
+            case SVG_SHAPE_USE: {
+                const SvgUse *use = &current->data.use;
+                const char *href = use->definition ? use->definition->id : use->href;
+                // A use the parser cut (see SVG_MAX_USE_DEPTH) still names its definition
+                const char *note = "";
+                if (!use->definition)
+                    note = href && svg_document_find_definition(doc, href, strlen(href)) ? " (not drawn)" : " (undefined)";
+                printf("[%d] USE: href=#%s, x=%.2f, y=%.2f%s",
+                       current->id,
+                       href ? href : "",
+                       use->x,
+                       use->y,
+                       note);
+                break;
+            }
+
+            case SVG_SHAPE_POLYGON:
+            case SVG_SHAPE_POLYLINE: {
+                const SvgPoly *poly = &current->data.poly;
+                printf("[%d] %s: points=", current->id,
+                       current->type == SVG_SHAPE_POLYGON ? "POLYGON" : "POLYLINE");
+                for (int i = 0; i < poly->count; i++)
+                    printf("%s(%.2f,%.2f)", i ? " " : "", poly->points[2 * i], poly->points[2 * i + 1]);
+                printf(", fill=%s", svg_paint_format(&current->style->fill, color, "none"));
+                printf(", stroke=%s", svg_paint_format(&current->style->stroke, color, "none"));
+                if (current->style->fill_rule == SVG_FILL_RULE_EVENODD) printf(", fill-rule=evenodd");
+                break;
+            }
+        }
+        if (current->transform) {
+            const SvgMatrix *m = current->transform;
+            printf(", transform=matrix(%g, %g, %g, %g, %g, %g)", m->a, m->b, m->c, m->d, m->e, m->f);
         }
-        current = current->next;
+        printf("\n");
     }
 }
@@ -0,0 +1,211 @@
+#include "../include/svg_scan.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define SVG_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+static int is_structural(unsigned char c) {
+    return c <= 0x20 || c == '<' || c == '>' || c == '/' || c == '=' || c == '"' || c == '\'';
+}
+
+static const char *scan_structural_scalar(const char *p, const char *end) {
+    while (p < end && !is_structural((unsigned char)*p)) p++;
+    return p;
+}
+
+// Bytes that close a tag or open a quoted value
+static const char *scan_tag_stop_scalar(const char *p, const char *end) {
+    while (p < end && *p != '>' && *p != '"' && *p != '\'') p++;
+    return p;
+}
+
+#ifdef SVG_SCAN_X86
+
+// One compare per delimiter plus an unsigned (v <= 0x20) test for whitespace,
+// OR'ed into a single mask per 16 bytes
+static const char *scan_structural_sse2(const char *p, const char *end) {
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i eq = _mm_set1_epi8('=');
+    const __m128i dq = _mm_set1_epi8('"');
+    const __m128i sq = _mm_set1_epi8('\'');
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i hit = _mm_cmpeq_epi8(_mm_min_epu8(v, space), v);
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, lt));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, gt));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, slash));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, eq));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, dq));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, sq));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz((unsigned)mask);
+        p += 16;
+    }
+    return scan_structural_scalar(p, end);
+}
+
+static const char *scan_tag_stop_sse2(const char *p, const char *end) {
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i dq = _mm_set1_epi8('"');
+    const __m128i sq = _mm_set1_epi8('\'');
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, gt),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, dq), _mm_cmpeq_epi8(v, sq)));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz((unsigned)mask);
+        p += 16;
+    }
+    return scan_tag_stop_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char *scan_structural_avx2(const char *p, const char *end) {
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i lt = _mm256_set1_epi8('<');
+    const __m256i gt = _mm256_set1_epi8('>');
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i eq = _mm256_set1_epi8('=');
+    const __m256i dq = _mm256_set1_epi8('"');
+    const __m256i sq = _mm256_set1_epi8('\'');
+
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i hit = _mm256_cmpeq_epi8(_mm256_min_epu8(v, space), v);
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, lt));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, gt));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, slash));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, eq));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, dq));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, sq));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return scan_structural_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char *scan_tag_stop_avx2(const char *p, const char *end) {
+    const __m256i gt = _mm256_set1_epi8('>');
+    const __m256i dq = _mm256_set1_epi8('"');
+    const __m256i sq = _mm256_set1_epi8('\'');
+
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, gt),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, dq), _mm256_cmpeq_epi8(v, sq)));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return scan_tag_stop_sse2(p, end);
+}
+
+// -1 until the first call checks the CPU, then 0 (SSE2 only) or 1 (AVX2).
+// Parser threads may make that first call together: the flag is read and
+// written atomically, and every thread that checks stores the same answer
+static int has_avx2 = -1;
+
+static int use_avx2(void) {
+    int avx2 = __atomic_load_n(&has_avx2, __ATOMIC_RELAXED);
+    if (avx2 < 0) {
+        __builtin_cpu_init();
+        avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+        __atomic_store_n(&has_avx2, avx2, __ATOMIC_RELAXED);
+    }
+    return avx2;
+}
+
+const char *svg_scan_structural(const char *p, const char *end) {
+    // Most stops are only a few bytes away; try them before vector setup
+    for (int i = 0; i < 8 && p < end; i++, p++) {
+        if (is_structural((unsigned char)*p)) return p;
+    }
+    return use_avx2() ? scan_structural_avx2(p, end) : scan_structural_sse2(p, end);
+}
+
+static const char *scan_tag_stop(const char *p, const char *end) {
+    return use_avx2() ? scan_tag_stop_avx2(p, end) : scan_tag_stop_sse2(p, end);
+}
+
+#else
+
+const char *svg_scan_structural(const char *p, const char *end) {
+    return scan_structural_scalar(p, end);
+}
+
+static const char *scan_tag_stop(const char *p, const char *end) {
+    return scan_tag_stop_scalar(p, end);
+}
+
+#endif
+
+const char *svg_scan_tag_end(const char *p, const char *end) {
+    for (;;) {
+        p = scan_tag_stop(p, end);
+        if (p >= end || *p == '>') return p;
+
+        // Jump over the quoted value in one memchr
+        const char *close = memchr(p + 1, *p, end - (p + 1));
+        if (!close) return end;
+        p = close + 1;
+    }
+}
+
+// Pack up to 8 name bytes into an integer, first byte lowest
+#define NAME_BYTE(c, i) ((uint64_t)(unsigned char)(c) << (8 * (i)))
+#define NAME3(a, b, c) (NAME_BYTE(a, 0) | NAME_BYTE(b, 1) | NAME_BYTE(c, 2))
+#define NAME4(a, b, c, d) (NAME3(a, b, c) | NAME_BYTE(d, 3))
+#define NAME5(a, b, c, d, e) (NAME4(a, b, c, d) | NAME_BYTE(e, 4))
+#define NAME6(a, b, c, d, e, f) (NAME5(a, b, c, d, e) | NAME_BYTE(f, 5))
+#define NAME7(a, b, c, d, e, f, g) (NAME6(a, b, c, d, e, f) | NAME_BYTE(g, 6))
+#define NAME8(a, b, c, d, e, f, g, h) (NAME7(a, b, c, d, e, f, g) | NAME_BYTE(h, 7))
+
+SvgElementKind svg_classify_element(const char *name, const char *end, const char **name_end) {
+    const char *stop = svg_scan_structural(name, end);
+    *name_end = stop;
+
+    size_t len = stop - name;
+    if (len == 0 || len > 8) return SVG_ELEMENT_OTHER;
+
+    uint64_t packed = 0;
+    for (size_t i = 0; i < len; i++) packed |= NAME_BYTE(name[i], i);
+
+    switch (len) {
+        case 1:
+            if (packed == NAME_BYTE('g', 0)) return SVG_ELEMENT_GROUP;
+            break;
+        case 3:
+            if (packed == NAME3('s', 'v', 'g')) return SVG_ELEMENT_SVG;
+            if (packed == NAME3('u', 's', 'e')) return SVG_ELEMENT_USE;
+            break;
+        case 4:
+            if (packed == NAME4('r', 'e', 'c', 't')) return SVG_ELEMENT_RECT;
+            if (packed == NAME4('l', 'i', 'n', 'e')) return SVG_ELEMENT_LINE;
+            if (packed == NAME4('d', 'e', 'f', 's')) return SVG_ELEMENT_DEFS;
+            break;
+        case 5:
+            if (packed == NAME5('s', 't', 'y', 'l', 'e')) return SVG_ELEMENT_STYLE;
+            break;
+        case 6:
+            if (packed == NAME6('c', 'i', 'r', 'c', 'l', 'e')) return SVG_ELEMENT_CIRCLE;
+            if (packed == NAME6('s', 'y', 'm', 'b', 'o', 'l')) return SVG_ELEMENT_SYMBOL;
+            break;
+        case 7:
+            if (packed == NAME7('p', 'o', 'l', 'y', 'g', 'o', 'n')) return SVG_ELEMENT_POLYGON;
+            break;
+        case 8:
+            if (packed == NAME8('p', 'o', 'l', 'y', 'l', 'i', 'n', 'e')) return SVG_ELEMENT_POLYLINE;
+            break;
+    }
+    return SVG_ELEMENT_OTHER;
+}
@@ -0,0 +1,186 @@
+#include "../include/svg_snapshot.h"
+#include "../include/svg_store.h"
+#include "../include/svg_platform.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SVG_VERSION_FIRST_CHUNKS 16
+
+// SVG_VERSION_CHUNK consecutive positions; a gap has a NULL style
+typedef struct {
+    volatile long refs;//versions listing this chunk
+    SvgShape shapes[SVG_VERSION_CHUNK];
+    double bounds[SVG_VERSION_CHUNK][4];
+} SvgVersionChunk;
+
+struct SvgShapeVersion {
+    volatile long refs;
+    size_t count, live;
+    SvgVersionChunk **chunks;
+    size_t chunk_count, chunk_capacity;
+};
+
+static void put(SvgVersionChunk *chunk, size_t slot, const SvgShape *shape, const double box[4]) {
+    chunk->shapes[slot] = *shape;
+    chunk->shapes[slot].next = NULL;
+    memcpy(chunk->bounds[slot], box, sizeof(chunk->bounds[slot]));
+}
+
+static void release_chunk(SvgVersionChunk *chunk) {
+    if (svg_atomic_add(&chunk->refs, -1) == 0) free(chunk);
+}
+
+static int reserve_chunks(SvgShapeVersion *version, size_t needed) {
+    if (needed <= version->chunk_capacity) return 0;
+    size_t capacity = version->chunk_capacity ? version->chunk_capacity : SVG_VERSION_FIRST_CHUNKS;
+    while (capacity < needed) capacity *= 2;
+    SvgVersionChunk **chunks = (SvgVersionChunk **)realloc(version->chunks, capacity * sizeof(*chunks));
+    if (!chunks) return -1;
+    version->chunks = chunks;
+    version->chunk_capacity = capacity;
+    return 0;
+}
+
+// A chunk past the last one, held by this version only
+static SvgVersionChunk *add_chunk(SvgShapeVersion *version) {
+    if (reserve_chunks(version, version->chunk_count + 1) != 0) return NULL;
+    SvgVersionChunk *chunk = (SvgVersionChunk *)malloc(sizeof(SvgVersionChunk));
+    if (!chunk) return NULL;
+    chunk->refs = 1;
+    version->chunks[version->chunk_count++] = chunk;
+    return chunk;
+}
+
+SvgShapeVersion *svg_version_build(const SvgShapeStore *store) {
+    SvgShapeVersion *version = (SvgShapeVersion *)calloc(1, sizeof(SvgShapeVersion));
+    if (!version) return NULL;
+    version->refs = 1;
+    if (reserve_chunks(version, (store->count + SVG_VERSION_CHUNK - 1) / SVG_VERSION_CHUNK) != 0) {
+        svg_version_release(version);
+        return NULL;
+    }
+
+    SvgVersionChunk *chunk = NULL;
+    for (size_t i = 0; i < store->count; i++) {
+        if (i % SVG_VERSION_CHUNK == 0 && !(chunk = add_chunk(version))) {
+            svg_version_release(version);
+            return NULL;
+        }
+        SvgShape shape;
+        if (store->items[i].type == SVG_STORE_REMOVED) {
+            memset(&shape, 0, sizeof(shape));
+        } else {
+            svg_store_get(store, i, &shape);
+            if (shape.style) version->live++;
+        }
+        put(chunk, i % SVG_VERSION_CHUNK, &shape, store->bounds[i]);
+    }
+    version->count = store->count;
+    return version;
+}
+
+SvgShapeVersion *svg_version_share(SvgShapeVersion *version) {
+    svg_atomic_add(&version->refs, 1);
+    return version;
+}
+
+void svg_version_release(SvgShapeVersion *version) {
+    if (!version || svg_atomic_add(&version->refs, -1) != 0) return;
+    for (size_t i = 0; i < version->chunk_count; i++) release_chunk(version->chunks[i]);
+    free(version->chunks);
+    free(version);
+}
+
+// A version no one else holds: a shared one is replaced by a new list of the
+// same chunks, which the old version goes on holding too
+static SvgShapeVersion *own_version(SvgShapeVersion **version) {
+    SvgShapeVersion *shared = *version;
+    if (svg_atomic_add(&shared->refs, 0) == 1) return shared;
+
+    SvgShapeVersion *copy = (SvgShapeVersion *)calloc(1, sizeof(SvgShapeVersion));
+    if (!copy) return NULL;
+    copy->refs = 1;
+    if (reserve_chunks(copy, shared->chunk_count + 1) != 0) {
+        free(copy);
+        return NULL;
+    }
+    for (size_t i = 0; i < shared->chunk_count; i++) {
+        svg_atomic_add(&shared->chunks[i]->refs, 1);
+        copy->chunks[i] = shared->chunks[i];
+    }
+    copy->chunk_count = shared->chunk_count;
+    copy->count = shared->count;
+    copy->live = shared->live;
+    svg_version_release(shared);
+    *version = copy;
+    return copy;
+}
+
+// The chunk holding position, copied first if another version lists it too
+static SvgVersionChunk *own_chunk(SvgShapeVersion *version, size_t position) {
+    size_t index = position / SVG_VERSION_CHUNK;
+    if (index == version->chunk_count) return add_chunk(version);
+    SvgVersionChunk *chunk = version->chunks[index];
+    if (svg_atomic_add(&chunk->refs, 0) == 1) return chunk;
+
+    SvgVersionChunk *copy = (SvgVersionChunk *)malloc(sizeof(SvgVersionChunk));
+    if (!copy) return NULL;
+    memcpy(copy, chunk, sizeof(SvgVersionChunk));
+    copy->refs = 1;
+    release_chunk(chunk);
+    version->chunks[index] = copy;
+    return copy;
+}
+
+int svg_version_write(SvgShapeVersion **version, size_t position, const SvgShape *shape, const double box[4]) {
+    SvgShapeVersion *own = own_version(version);
+    SvgVersionChunk *chunk = own ? own_chunk(own, position) : NULL;
+    if (!chunk) return -1;
+    size_t slot = position % SVG_VERSION_CHUNK;
+    if (position < own->count && chunk->shapes[slot].style) own->live--;
+    put(chunk, slot, shape, box);
+    if (shape->style) own->live++;
+    if (position == own->count) own->count++;
+    return 0;
+}
+
+int svg_version_remove(SvgShapeVersion **version, size_t position) {
+    SvgShapeVersion *own = own_version(version);
+    SvgVersionChunk *chunk = own ? own_chunk(own, position) : NULL;
+    if (!chunk) return -1;
+    SvgShape *shape = &chunk->shapes[position % SVG_VERSION_CHUNK];
+    if (shape->style) own->live--;
+    shape->style = NULL;
+    return 0;
+}
+
+size_t svg_version_count(const SvgShapeVersion *version) {
+    return version->count;
+}
+
+size_t svg_version_live(const SvgShapeVersion *version) {
+    return version->live;
+}
+
+const SvgShape *svg_version_shape(const SvgShapeVersion *version, size_t position, const double **bounds) {
+    const SvgVersionChunk *chunk = version->chunks[position / SVG_VERSION_CHUNK];
+    size_t slot = position % SVG_VERSION_CHUNK;
+    if (!chunk->shapes[slot].style) return NULL;
+    *bounds = chunk->bounds[slot];
+    return &chunk->shapes[slot];
+}
+
+int svg_version_extent(const SvgShapeVersion *version, double out[4]) {
+    out[0] = out[1] = HUGE_VAL;
+    out[2] = out[3] = -HUGE_VAL;
+    for (size_t i = 0; i < version->count; i++) {
+        const double *box;
+        if (!svg_version_shape(version, i, &box)) continue;
+        if (box[0] < out[0]) out[0] = box[0];
+        if (box[1] < out[1]) out[1] = box[1];
+        if (box[2] > out[2]) out[2] = box[2];
+        if (box[3] > out[3]) out[3] = box[3];
+    }
+    return out[0] <= out[2] ? 0 : -1;
+}
@@ -0,0 +1,605 @@
+#include "../include/svg_store.h"
+#include "../include/svg_index.h"
+#include "../include/svg_snapshot.h"
+#include "../include/svg_transform.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SVG_STORE_FIRST_ROWS 64
+
+// Resize one array of a table; on failure the arrays already resized are only
+// bigger than the capacity says, which is harmless
+#define RESIZE(array, capacity)                                           \
+    do {                                                                  \
+        void *resized = realloc((array), (capacity) * sizeof(*(array)));  \
+        if (!resized) return -1;                                          \
+        (array) = resized;                                                \
+    } while (0)
+
+// Bounds that contain nothing: any box grows them to itself
+static void empty_box(double box[4]) {
+    box[0] = box[1] = HUGE_VAL;
+    box[2] = box[3] = -HUGE_VAL;
+}
+
+static void grow_box(double box[4], const double add[4]) {
+    if (add[0] < box[0]) box[0] = add[0];
+    if (add[1] < box[1]) box[1] = add[1];
+    if (add[2] > box[2]) box[2] = add[2];
+    if (add[3] > box[3]) box[3] = add[3];
+}
+
+// Whether losing box could shrink extent; a waiting shape's empty box never can
+static int on_edge(const double box[4], const double extent[4]) {
+    if (box[0] > box[2]) return 0;
+    return box[0] <= extent[0] || box[1] <= extent[1] || box[2] >= extent[2] || box[3] >= extent[3];
+}
+
+void svg_store_init(SvgShapeStore *store) {
+    memset(store, 0, sizeof(*store));
+    store->generation = 1;
+    empty_box(store->extent);
+}
+
+void svg_store_release(SvgShapeStore *store) {
+    svg_index_free(store->index);
+    svg_version_release(store->version);
+    free(store->items);
+    free(store->ids);
+    free(store->styles);
+    free(store->transforms);
+    free(store->sources);
+    free(store->slot_of);
+    free(store->bounds);
+    free(store->slots);
+    free(store->id_slots);
+    free(store->circles.cx);
+    free(store->circles.cy);
+    free(store->circles.r);
+    free(store->rects.x);
+    free(store->rects.y);
+    free(store->rects.width);
+    free(store->rects.height);
+    free(store->lines.x1);
+    free(store->lines.y1);
+    free(store->lines.x2);
+    free(store->lines.y2);
+    free(store->polygons.points);
+    free(store->polygons.point_count);
+    free(store->polylines.points);
+    free(store->polylines.point_count);
+    free(store->uses.x);
+    free(store->uses.y);
+    free(store->uses.definition);
+    free(store->uses.href);
+    svg_store_init(store);
+}
+
+// Doubling, so appending n shapes costs O(n) copies in total
+static size_t next_capacity(size_t capacity, size_t needed) {
+    if (capacity < SVG_STORE_FIRST_ROWS) capacity = SVG_STORE_FIRST_ROWS;
+    while (capacity < needed) capacity *= 2;
+    return capacity;
+}
+
+static int reserve_positions(SvgShapeStore *store, size_t needed) {
+    if (needed <= store->capacity) return 0;
+    size_t capacity = next_capacity(store->capacity, needed);
+    RESIZE(store->items, capacity);
+    RESIZE(store->ids, capacity);
+    RESIZE(store->styles, capacity);
+    RESIZE(store->transforms, capacity);
+    RESIZE(store->slot_of, capacity);
+    RESIZE(store->bounds, capacity);
+    if (store->sources) RESIZE(store->sources, capacity);
+    store->capacity = capacity;
+    return 0;
+}
+
+static int reserve_polys(SvgPolyTable *t, size_t needed) {
+    if (needed <= t->capacity) return 0;
+    size_t capacity = next_capacity(t->capacity, needed);
+    RESIZE(t->points, capacity);
+    RESIZE(t->point_count, capacity);
+    t->capacity = capacity;
+    return 0;
+}
+
+static int reserve_rows(SvgShapeStore *store, SvgShapeType type, size_t needed) {
+    size_t capacity;
+    switch (type) {
+        case SVG_SHAPE_CIRCLE: {
+            SvgCircleTable *t = &store->circles;
+            if (needed <= t->capacity) return 0;
+            capacity = next_capacity(t->capacity, needed);
+            RESIZE(t->cx, capacity);
+            RESIZE(t->cy, capacity);
+            RESIZE(t->r, capacity);
+            t->capacity = capacity;
+            return 0;
+        }
+        case SVG_SHAPE_RECT: {
+            SvgRectTable *t = &store->rects;
+            if (needed <= t->capacity) return 0;
+            capacity = next_capacity(t->capacity, needed);
+            RESIZE(t->x, capacity);
+            RESIZE(t->y, capacity);
+            RESIZE(t->width, capacity);
+            RESIZE(t->height, capacity);
+            t->capacity = capacity;
+            return 0;
+        }
+        case SVG_SHAPE_LINE: {
+            SvgLineTable *t = &store->lines;
+            if (needed <= t->capacity) return 0;
+            capacity = next_capacity(t->capacity, needed);
+            RESIZE(t->x1, capacity);
+            RESIZE(t->y1, capacity);
+            RESIZE(t->x2, capacity);
+            RESIZE(t->y2, capacity);
+            t->capacity = capacity;
+            return 0;
+        }
+        case SVG_SHAPE_POLYGON:
+            return reserve_polys(&store->polygons, needed);
+        case SVG_SHAPE_POLYLINE:
+            return reserve_polys(&store->polylines, needed);
+        case SVG_SHAPE_USE: {
+            SvgUseTable *t = &store->uses;
+            if (needed <= t->capacity) return 0;
+            capacity = next_capacity(t->capacity, needed);
+            RESIZE(t->x, capacity);
+            RESIZE(t->y, capacity);
+            RESIZE(t->definition, capacity);
+            RESIZE(t->href, capacity);
+            t->capacity = capacity;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static size_t *row_count(SvgShapeStore *store, SvgShapeType type) {
+    switch (type) {
+        case SVG_SHAPE_CIRCLE: return &store->circles.count;
+        case SVG_SHAPE_RECT: return &store->rects.count;
+        case SVG_SHAPE_LINE: return &store->lines.count;
+        case SVG_SHAPE_POLYGON: return &store->polygons.count;
+        case SVG_SHAPE_POLYLINE: return &store->polylines.count;
+        case SVG_SHAPE_USE: return &store->uses.count;
+    }
+    return NULL;
+}
+
+static void write_row(SvgShapeStore *store, SvgShapeType type, size_t row, const SvgShape *shape) {
+    switch (type) {
+        case SVG_SHAPE_CIRCLE:
+            store->circles.cx[row] = shape->data.circle.cx;
+            store->circles.cy[row] = shape->data.circle.cy;
+            store->circles.r[row] = shape->data.circle.r;
+            break;
+        case SVG_SHAPE_RECT:
+            store->rects.x[row] = shape->data.rect.x;
+            store->rects.y[row] = shape->data.rect.y;
+            store->rects.width[row] = shape->data.rect.width;
+            store->rects.height[row] = shape->data.rect.height;
+            break;
+        case SVG_SHAPE_LINE:
+            store->lines.x1[row] = shape->data.line.x1;
+            store->lines.y1[row] = shape->data.line.y1;
+            store->lines.x2[row] = shape->data.line.x2;
+            store->lines.y2[row] = shape->data.line.y2;
+            break;
+        case SVG_SHAPE_POLYGON:
+        case SVG_SHAPE_POLYLINE: {
+            SvgPolyTable *t = type == SVG_SHAPE_POLYGON ? &store->polygons : &store->polylines;
+            t->points[row] = shape->data.poly.points;
+            t->point_count[row] = shape->data.poly.count;
+            break;
+        }
+        case SVG_SHAPE_USE:
+            store->uses.x[row] = shape->data.use.x;
+            store->uses.y[row] = shape->data.use.y;
+            store->uses.definition[row] = shape->data.use.definition;
+            store->uses.href[row] = shape->data.use.href;
+            break;
+    }
+}
+
+static void read_row(const SvgShapeStore *store, SvgShapeType type, size_t row, SvgShape *out) {
+    switch (type) {
+        case SVG_SHAPE_CIRCLE:
+            out->data.circle.cx = store->circles.cx[row];
+            out->data.circle.cy = store->circles.cy[row];
+            out->data.circle.r = store->circles.r[row];
+            break;
+        case SVG_SHAPE_RECT:
+            out->data.rect.x = store->rects.x[row];
+            out->data.rect.y = store->rects.y[row];
+            out->data.rect.width = store->rects.width[row];
+            out->data.rect.height = store->rects.height[row];
+            break;
+        case SVG_SHAPE_LINE:
+            out->data.line.x1 = store->lines.x1[row];
+            out->data.line.y1 = store->lines.y1[row];
+            out->data.line.x2 = store->lines.x2[row];
+            out->data.line.y2 = store->lines.y2[row];
+            break;
+        case SVG_SHAPE_POLYGON:
+        case SVG_SHAPE_POLYLINE: {
+            const SvgPolyTable *t = type == SVG_SHAPE_POLYGON ? &store->polygons : &store->polylines;
+            out->data.poly.points = t->points[row];
+            out->data.poly.count = t->point_count[row];
+            break;
+        }
+        case SVG_SHAPE_USE:
+            out->data.use.x = store->uses.x[row];
+            out->data.use.y = store->uses.y[row];
+            out->data.use.definition = store->uses.definition[row];
+            out->data.use.href = store->uses.href[row];
+            break;
+    }
+}
+
+// A slot is free or can be made without failing later
+static int reserve_slot(SvgShapeStore *store) {
+    if (store->free_slot || store->slot_count < store->slot_capacity) return 0;
+    if (store->slot_count >= UINT32_MAX) return -1;
+    size_t capacity = next_capacity(store->slot_capacity, store->slot_count + 1);
+    RESIZE(store->slots, capacity);
+    store->slot_capacity = capacity;
+    return 0;
+}
+
+static uint32_t take_slot(SvgShapeStore *store, size_t position) {
+    uint32_t slot;
+    if (store->free_slot) {
+        slot = store->free_slot - 1;
+        store->free_slot = store->slots[slot].position;
+    } else {
+        slot = (uint32_t)store->slot_count++;
+        store->slots[slot].generation = store->generation;
+    }
+    store->slots[slot].position = (uint32_t)position;
+    store->slot_of[position] = slot;
+    return slot;
+}
+
+// Ids come from numbering the shapes, so a dense array indexes them
+static int reserve_id(SvgShapeStore *store, int id) {
+    if (id <= 0 || (size_t)id < store->id_capacity) return 0;
+    size_t capacity = next_capacity(store->id_capacity, (size_t)id + 1);
+    RESIZE(store->id_slots, capacity);
+    memset(store->id_slots + store->id_capacity, 0, (capacity - store->id_capacity) * sizeof(uint32_t));
+    store->id_capacity = capacity;
+    return 0;
+}
+
+static void index_id(SvgShapeStore *store, int id, uint32_t slot) {
+    if (id <= 0) return;
+    store->id_slots[id] = slot + 1;
+    if (id > store->max_id) store->max_id = id;
+}
+
+static void unindex_id(SvgShapeStore *store, int id, uint32_t slot) {
+    if (id > 0 && (size_t)id < store->id_capacity && store->id_slots[id] == slot + 1) store->id_slots[id] = 0;
+}
+
+// Room for one more shape of type, then its draw position, row and handle
+static int add_position(SvgShapeStore *store, SvgShapeType type, int id, const SvgMatrix *transform,
+                        const SvgStyle *style) {
+    size_t *rows = row_count(store, type);
+    if (!rows || reserve_positions(store, store->count + 1) != 0 || reserve_rows(store, type, *rows + 1) != 0 ||
+        reserve_slot(store) != 0 || reserve_id(store, id) != 0)
+        return -1;
+    size_t position = store->count++;
+    store->items[position].type = (uint32_t)type;
+    store->items[position].index = (uint32_t)(*rows)++;
+    store->ids[position] = id;
+    store->styles[position] = style;
+    store->transforms[position] = transform;
+    index_id(store, id, take_slot(store, position));
+    return 0;
+}
+
+// The grid follows every change to the bounds; when it cannot, it is dropped
+// and the next query builds it again
+static void drop_index(SvgShapeStore *store) {
+    svg_index_free(store->index);
+    store->index = NULL;
+}
+
+static void index_shape(SvgShapeStore *store, size_t position) {
+    if (store->index && svg_index_insert(store->index, position, store->bounds[position]) != 0) drop_index(store);
+}
+
+static void unindex_shape(SvgShapeStore *store, size_t position) {
+    if (store->index) svg_index_remove(store->index, position, store->bounds[position]);
+}
+
+// Likewise the chunked copy snapshots share, once one has been taken
+static void drop_version(SvgShapeStore *store) {
+    svg_version_release(store->version);
+    store->version = NULL;
+}
+
+static void version_shape(SvgShapeStore *store, size_t position) {
+    if (!store->version) return;
+    SvgShape shape;
+    svg_store_get(store, position, &shape);
+    if (svg_version_write(&store->version, position, &shape, store->bounds[position]) != 0) drop_version(store);
+}
+
+int svg_store_reserve(SvgShapeStore *store, size_t extra) {
+    return reserve_positions(store, store->count + extra);
+}
+
+int svg_store_append(SvgShapeStore *store, const SvgShape *shape) {
+    if (add_position(store, shape->type, shape->id, shape->transform, shape->style) != 0) return -1;
+    size_t position = store->count - 1;
+    write_row(store, shape->type, store->items[position].index, shape);
+    svg_shape_bounds(shape, store->bounds[position]);
+    grow_box(store->extent, store->bounds[position]);
+    index_shape(store, position);
+    version_shape(store, position);
+    store->edits++;
+    return 0;
+}
+
+int svg_store_append_pending(SvgShapeStore *store, SvgShapeType type, int id,
+                             const SvgMatrix *transform, const SvgSource *source) {
+    if (!store->sources) {
+        if (reserve_positions(store, store->count + 1) != 0) return -1;
+        store->sources = (SvgSource *)malloc(store->capacity * sizeof(SvgSource));
+        if (!store->sources) return -1;
+    }
+    if (add_position(store, type, id, transform, NULL) != 0) return -1;
+
+    SvgShape zero;
+    memset(&zero, 0, sizeof(zero));
+    write_row(store, type, store->items[store->count - 1].index, &zero);
+    store->sources[store->count - 1] = *source;
+    empty_box(store->bounds[store->count - 1]);
+    store->pending++;
+    version_shape(store, store->count - 1);
+    store->edits++;
+    return 0;
+}
+
+// Whole columns at once: rows of src land after dst's rows of the same type
+#define APPEND_COLUMN(dst_table, src_table, field)                                    \
+    if ((src_table).count)                                                             \
+        memcpy((dst_table).field + (dst_table).count, (src_table).field,               \
+               (src_table).count * sizeof(*(src_table).field))
+
+int svg_store_append_store(SvgShapeStore *dst, const SvgShapeStore *src) {
+    if (src->count == 0) return 0;
+    if (reserve_positions(dst, dst->count + src->count) != 0) return -1;
+    if (dst->slot_count + src->count > dst->slot_capacity) {
+        if (dst->slot_count + src->count > UINT32_MAX) return -1;
+        size_t capacity = next_capacity(dst->slot_capacity, dst->slot_count + src->count);
+        RESIZE(dst->slots, capacity);
+        dst->slot_capacity = capacity;
+    }
+    // The caller may have renumbered src, so its own index is no guide
+    int max_id = 0;
+    for (size_t i = 0; i < src->count; i++) {
+        if (src->ids[i] > max_id) max_id = src->ids[i];
+    }
+    if (reserve_id(dst, max_id) != 0) return -1;
+    if (src->sources && !dst->sources) {
+        dst->sources = (SvgSource *)malloc(dst->capacity * sizeof(SvgSource));
+        if (!dst->sources) return -1;
+    }
+    if (reserve_rows(dst, SVG_SHAPE_CIRCLE, dst->circles.count + src->circles.count) != 0 ||
+        reserve_rows(dst, SVG_SHAPE_RECT, dst->rects.count + src->rects.count) != 0 ||
+        reserve_rows(dst, SVG_SHAPE_LINE, dst->lines.count + src->lines.count) != 0 ||
+        reserve_rows(dst, SVG_SHAPE_POLYGON, dst->polygons.count + src->polygons.count) != 0 ||
+        reserve_rows(dst, SVG_SHAPE_POLYLINE, dst->polylines.count + src->polylines.count) != 0 ||
+        reserve_rows(dst, SVG_SHAPE_USE, dst->uses.count + src->uses.count) != 0)
+        return -1;
+
+    // Draw items point at rows, which move up by the rows dst already has
+    uint32_t base[SVG_SHAPE_POLYLINE + 1];
+    base[SVG_SHAPE_CIRCLE] = (uint32_t)dst->circles.count;
+    base[SVG_SHAPE_RECT] = (uint32_t)dst->rects.count;
+    base[SVG_SHAPE_LINE] = (uint32_t)dst->lines.count;
+    base[SVG_SHAPE_USE] = (uint32_t)dst->uses.count;
+    base[SVG_SHAPE_POLYGON] = (uint32_t)dst->polygons.count;
+    base[SVG_SHAPE_POLYLINE] = (uint32_t)dst->polylines.count;
+    for (size_t i = 0; i < src->count; i++) {
+        SvgDrawItem item = src->items[i];
+        item.index += base[item.type];
+        dst->items[dst->count + i] = item;
+    }
+    memcpy(dst->ids + dst->count, src->ids, src->count * sizeof(*src->ids));
+    memcpy(dst->styles + dst->count, src->styles, src->count * sizeof(*src->styles));
+    memcpy(dst->transforms + dst->count, src->transforms, src->count * sizeof(*src->transforms));
+    memcpy(dst->bounds + dst->count, src->bounds, src->count * sizeof(*src->bounds));
+    if (src->sources) memcpy(dst->sources + dst->count, src->sources, src->count * sizeof(*src->sources));
+    for (size_t i = 0; i < src->count; i++)
+        index_id(dst, src->ids[i], take_slot(dst, dst->count + i));
+    dst->count += src->count;
+    for (size_t i = dst->count - src->count; i < dst->count; i++) index_shape(dst, i);
+    dst->pending += src->pending;
+    dst->edits += src->count;
+    if (src->extent_stale) dst->extent_stale = 1;
+    else grow_box(dst->extent, src->extent);
+
+    APPEND_COLUMN(dst->circles, src->circles, cx);
+    APPEND_COLUMN(dst->circles, src->circles, cy);
+    APPEND_COLUMN(dst->circles, src->circles, r);
+    dst->circles.count += src->circles.count;
+    APPEND_COLUMN(dst->rects, src->rects, x);
+    APPEND_COLUMN(dst->rects, src->rects, y);
+    APPEND_COLUMN(dst->rects, src->rects, width);
+    APPEND_COLUMN(dst->rects, src->rects, height);
+    dst->rects.count += src->rects.count;
+    APPEND_COLUMN(dst->lines, src->lines, x1);
+    APPEND_COLUMN(dst->lines, src->lines, y1);
+    APPEND_COLUMN(dst->lines, src->lines, x2);
+    APPEND_COLUMN(dst->lines, src->lines, y2);
+    dst->lines.count += src->lines.count;
+    APPEND_COLUMN(dst->polygons, src->polygons, points);
+    APPEND_COLUMN(dst->polygons, src->polygons, point_count);
+    dst->polygons.count += src->polygons.count;
+    APPEND_COLUMN(dst->polylines, src->polylines, points);
+    APPEND_COLUMN(dst->polylines, src->polylines, point_count);
+    dst->polylines.count += src->polylines.count;
+    APPEND_COLUMN(dst->uses, src->uses, x);
+    APPEND_COLUMN(dst->uses, src->uses, y);
+    APPEND_COLUMN(dst->uses, src->uses, definition);
+    APPEND_COLUMN(dst->uses, src->uses, href);
+    dst->uses.count += src->uses.count;
+    for (size_t i = dst->count - src->count; i < dst->count; i++) version_shape(dst, i);
+    return 0;
+}
+
+void svg_store_get(const SvgShapeStore *store, size_t position, SvgShape *out) {
+    SvgDrawItem item = store->items[position];
+    out->type = (SvgShapeType)item.type;
+    out->id = store->ids[position];
+    out->transform = store->transforms[position];
+    out->style = store->styles[position];
+    out->next = NULL;
+    read_row(store, out->type, item.index, out);
+}
+
+int svg_store_set(SvgShapeStore *store, size_t position, const SvgShape *shape) {
+    int id = store->ids[position];
+    if (shape->id != id) {
+        if (reserve_id(store, shape->id) != 0) return -1;
+        uint32_t slot = store->slot_of[position];
+        unindex_id(store, id, slot);
+        index_id(store, shape->id, slot);
+    }
+    // Filling in a waiting lazy shape decodes it; it does not edit it
+    if (store->styles[position]) store->edits++;
+    else if (shape->style) store->pending--;
+    store->ids[position] = shape->id;
+    store->transforms[position] = shape->transform;
+    store->styles[position] = shape->style;
+    write_row(store, shape->type, store->items[position].index, shape);
+
+    double *box = store->bounds[position];
+    if (!store->extent_stale && on_edge(box, store->extent)) store->extent_stale = 1;
+    unindex_shape(store, position);
+    svg_shape_bounds(shape, box);
+    if (!store->extent_stale) grow_box(store->extent, box);
+    index_shape(store, position);
+    version_shape(store, position);
+    return 0;
+}
+
+size_t svg_store_live(const SvgShapeStore *store) {
+    return store->count - store->removed;
+}
+
+SvgShapeHandle svg_store_handle(const SvgShapeStore *store, size_t position) {
+    uint32_t slot = store->slot_of[position];
+    return (SvgShapeHandle)store->slots[slot].generation << 32 | slot;
+}
+
+int svg_store_position(const SvgShapeStore *store, SvgShapeHandle handle, size_t *position) {
+    uint32_t slot = (uint32_t)handle, generation = (uint32_t)(handle >> 32);
+    if (slot >= store->slot_count || store->slots[slot].generation != generation) return -1;
+    *position = store->slots[slot].position;
+    return 0;
+}
+
+int svg_store_find_id(const SvgShapeStore *store, int id, size_t *position) {
+    if (id <= 0 || (size_t)id >= store->id_capacity || !store->id_slots[id]) return -1;
+    *position = store->slots[store->id_slots[id] - 1].position;
+    return 0;
+}
+
+void svg_store_remove(SvgShapeStore *store, size_t position) {
+    unindex_shape(store, position);
+    uint32_t slot = store->slot_of[position];
+    unindex_id(store, store->ids[position], slot);
+
+    // The slot goes on the free list under a new generation, so old handles miss
+    SvgShapeSlot *freed = &store->slots[slot];
+    if (++freed->generation == 0) freed->generation = 1;
+    if (freed->generation > store->generation) store->generation = freed->generation;
+    freed->position = store->free_slot;
+    store->free_slot = slot + 1;
+
+    if (!store->styles[position]) store->pending--;
+    if (on_edge(store->bounds[position], store->extent)) store->extent_stale = 1;
+    store->items[position].type = SVG_STORE_REMOVED;
+    store->removed++;
+    store->edits++;
+    if (store->version && svg_version_remove(&store->version, position) != 0) drop_version(store);
+    if (store->removed > SVG_STORE_FIRST_ROWS && store->removed * 2 > store->count) svg_store_compact(store);
+}
+
+void svg_store_compact(SvgShapeStore *store) {
+    if (store->removed == 0) return;
+    // Both know shapes by position
+    drop_index(store);
+    drop_version(store);
+
+    // Rows of a type follow the draw order, so every move is down or in place
+    size_t rows[SVG_SHAPE_POLYLINE + 1] = {0};
+    size_t kept = 0;
+    for (size_t i = 0; i < store->count; i++) {
+        SvgDrawItem item = store->items[i];
+        if (item.type == SVG_STORE_REMOVED) continue;
+        SvgShapeType type = (SvgShapeType)item.type;
+        size_t row = rows[type]++;
+        if (row != item.index) {
+            SvgShape moved;
+            read_row(store, type, item.index, &moved);
+            write_row(store, type, row, &moved);
+        }
+        store->items[kept].type = item.type;
+        store->items[kept].index = (uint32_t)row;
+        store->ids[kept] = store->ids[i];
+        store->styles[kept] = store->styles[i];
+        store->transforms[kept] = store->transforms[i];
+        memmove(store->bounds[kept], store->bounds[i], sizeof(store->bounds[kept]));
+        if (store->sources) store->sources[kept] = store->sources[i];
+        store->slot_of[kept] = store->slot_of[i];
+        store->slots[store->slot_of[kept]].position = (uint32_t)kept;
+        kept++;
+    }
+    store->count = kept;
+    store->removed = 0;
+    store->circles.count = rows[SVG_SHAPE_CIRCLE];
+    store->rects.count = rows[SVG_SHAPE_RECT];
+    store->lines.count = rows[SVG_SHAPE_LINE];
+    store->uses.count = rows[SVG_SHAPE_USE];
+    store->polygons.count = rows[SVG_SHAPE_POLYGON];
+    store->polylines.count = rows[SVG_SHAPE_POLYLINE];
+}
+
+SvgShapeIndex *svg_store_index(SvgShapeStore *store) {
+    if (!store->index) store->index = svg_index_build(store);
+    return store->index;
+}
+
+SvgShapeVersion *svg_store_snapshot(SvgShapeStore *store) {
+    if (!store->version) store->version = svg_version_build(store);
+    return store->version ? svg_version_share(store->version) : NULL;
+}
+
+void svg_store_succeed(SvgShapeStore *store, const SvgShapeStore *old) {
+    uint32_t base = (old->generation > store->generation ? old->generation : store->generation) + 1;
+    if (base == 0) base = 1;
+    for (size_t i = 0; i < store->slot_count; i++) store->slots[i].generation = base;
+    store->generation = base;
+}
+
+int svg_store_extent(SvgShapeStore *store, double out[4]) {
+    if (store->extent_stale) {
+        empty_box(store->extent);
+        for (size_t i = 0; i < store->count; i++) {
+            if (store->items[i].type != SVG_STORE_REMOVED) grow_box(store->extent, store->bounds[i]);
+        }
+        store->extent_stale = 0;
+    }
+    memcpy(out, store->extent, sizeof(store->extent));
+    return store->extent[0] <= store->extent[2] ? 0 : -1;
+}
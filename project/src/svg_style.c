@@ -0,0 +1,261 @@
+#include "../include/svg_style.h"
+#include "../include/svg_color.h"
+#include <string.h>
+
+const SvgStyle svg_default_style = {{0, SVG_PAINT_UNSET, NULL}, {0, SVG_PAINT_UNSET, NULL},
+                                    SVG_FILL_RULE_UNSET, 0, NULL};
+
+int svg_paint_is_set(const SvgPaint *paint) {
+    return paint->kind != SVG_PAINT_UNSET || paint->text != NULL;
+}
+
+void svg_style_merge(SvgStyle *style, const SvgStyle *over) {
+    if (svg_paint_is_set(&over->fill)) style->fill = over->fill;
+    if (svg_paint_is_set(&over->stroke)) style->stroke = over->stroke;
+    if (over->fill_rule != SVG_FILL_RULE_UNSET) style->fill_rule = over->fill_rule;
+}
+
+static int is_space(char c) {
+    return (unsigned char)c <= 0x20;
+}
+
+static const char *skip_space(const char *p, const char *end) {
+    while (p < end && is_space(*p)) p++;
+    return p;
+}
+
+static const char *trim_end(const char *start, const char *end) {
+    while (end > start && is_space(end[-1])) end--;
+    return end;
+}
+
+static int slice_is(const char *s, const char *end, const char *word) {
+    size_t len = strlen(word);
+    return (size_t)(end - s) == len && memcmp(s, word, len) == 0;
+}
+
+int svg_style_parse_paint(const char *s, size_t len, SvgPaint *out, SvgArena *arena) {
+    const char *end = trim_end(s, s + len);
+    s = skip_space(s, end);
+    if (s == end) return 0;
+    // A value that cannot be decoded still replaces the inherited one, whether
+    // or not its text is kept, so streamed and loaded shapes look the same
+    return svg_paint_parse(s, end - s, out, arena) == 0 ? 1 : -1;
+}
+
+SvgFillRule svg_style_parse_fill_rule(const char *s, size_t len) {
+    const char *end = trim_end(s, s + len);
+    s = skip_space(s, end);
+    if (slice_is(s, end, "nonzero")) return SVG_FILL_RULE_NONZERO;
+    if (slice_is(s, end, "evenodd")) return SVG_FILL_RULE_EVENODD;
+    return SVG_FILL_RULE_UNSET;
+}
+
+int svg_style_parse_declarations(const char *s, size_t len, SvgStyle *style, SvgArena *arena) {
+    const char *p = s, *end = s + len;
+    while (p < end) {
+        const char *stop = memchr(p, ';', end - p);
+        if (!stop) stop = end;
+
+        const char *colon = memchr(p, ':', stop - p);
+        if (colon) {
+            const char *name = skip_space(p, colon);
+            const char *name_end = trim_end(name, colon);
+            const char *value = skip_space(colon + 1, stop);
+            const char *value_end = trim_end(value, stop);
+
+            // "!important" only matters between rules of one sheet; drop it
+            const char *bang = memchr(value, '!', value_end - value);
+            if (bang) value_end = trim_end(value, bang);
+
+            SvgPaint *target = slice_is(name, name_end, "fill")     ? &style->fill
+                             : slice_is(name, name_end, "stroke")   ? &style->stroke
+                             : NULL;
+            if (target) {
+                SvgPaint paint;
+                int given = svg_style_parse_paint(value, value_end - value, &paint, arena);
+                if (given < 0) return -1;
+                if (given) *target = paint;
+            } else if (slice_is(name, name_end, "fill-rule")) {
+                SvgFillRule rule = svg_style_parse_fill_rule(value, value_end - value);
+                if (rule != SVG_FILL_RULE_UNSET) style->fill_rule = rule;
+            }
+        }
+        p = stop + 1;
+    }
+    return 0;
+}
+
+// Blank /* comments */ so the rule scanner never sees them
+static void blank_comments(char *css, size_t len) {
+    char *end = css + len;
+    for (char *p = css; p + 1 < end; p++) {
+        if (p[0] != '/' || p[1] != '*') continue;
+        char *q = p + 2;
+        while (q + 1 < end && !(q[0] == '*' && q[1] == '/')) q++;
+        q = q + 1 < end ? q + 2 : end;
+        memset(p, ' ', q - p);
+        p = q - 1;
+    }
+}
+
+static int is_name_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '-' || c == '_';
+}
+
+// One compound selector; return -1 when it is not a supported form (the rule
+// is skipped), -2 when out of memory
+static int add_rule(SvgStyleSheet *sheet, const char *p, const char *end, const SvgStyle *declarations,
+                    SvgArena *arena) {
+    SvgElementKind element = SVG_ELEMENT_OTHER;
+    int specificity = 0;
+
+    const char *name = p;
+    while (p < end && is_name_char(*p)) p++;
+    if (p > name) {
+        const char *name_end;
+        element = svg_classify_element(name, p, &name_end);
+        // Elements the parser never styles cannot match anything
+        if (element == SVG_ELEMENT_OTHER || name_end != p) return 0;
+        specificity = 1;
+    } else if (p < end && *p == '*') {
+        p++;
+    }
+
+    const char *classes = p;
+    while (p < end && *p == '.') {
+        const char *class_name = ++p;
+        while (p < end && is_name_char(*p)) p++;
+        if (p == class_name) return -1;
+        specificity += 10;
+    }
+    if (p != end) return -1;
+
+    SvgStyleRule *rule = (SvgStyleRule *)svg_arena_alloc(arena, sizeof(SvgStyleRule));
+    if (!rule) return -2;
+    rule->element = element;
+    rule->classes = NULL;
+    if (classes < end) {
+        rule->classes = svg_arena_strndup(arena, classes, end - classes);
+        if (!rule->classes) return -2;
+    }
+    rule->specificity = specificity;
+    rule->declarations = *declarations;
+
+    // Later rules of equal specificity win, so they go after earlier ones
+    SvgStyleRule **link = &sheet->rules;
+    while (*link && (*link)->specificity <= specificity) link = &(*link)->next;
+    rule->next = *link;
+    *link = rule;
+    sheet->count++;
+    return 0;
+}
+
+// Skip an @-rule: up to its ';' or past its (possibly nested) block
+static const char *skip_at_rule(const char *p, const char *end) {
+    int depth = 0;
+    for (; p < end; p++) {
+        if (*p == ';' && depth == 0) return p + 1;
+        if (*p == '{') depth++;
+        if (*p == '}' && --depth <= 0) return p + 1;
+    }
+    return end;
+}
+
+int svg_stylesheet_parse(SvgStyleSheet *sheet, char *css, size_t len, SvgArena *arena) {
+    blank_comments(css, len);
+    const char *p = css, *end = css + len;
+
+    for (;;) {
+        p = skip_space(p, end);
+        if (p == end) return 0;
+        if (*p == '@') {
+            p = skip_at_rule(p, end);
+            continue;
+        }
+
+        const char *open = memchr(p, '{', end - p);
+        if (!open) return 0;
+        const char *close = memchr(open, '}', end - open);
+        if (!close) close = end;
+
+        SvgStyle declarations = svg_default_style;
+        if (svg_style_parse_declarations(open + 1, close - open - 1, &declarations, arena) != 0) return -1;
+
+        if (svg_paint_is_set(&declarations.fill) || svg_paint_is_set(&declarations.stroke) ||
+            declarations.fill_rule != SVG_FILL_RULE_UNSET) {
+            // Each selector of a comma-separated list is a rule of its own
+            const char *selector = p;
+            while (selector < open) {
+                const char *comma = memchr(selector, ',', open - selector);
+                if (!comma) comma = open;
+                const char *start = skip_space(selector, comma);
+                const char *stop = trim_end(start, comma);
+                if (start < stop && add_rule(sheet, start, stop, &declarations, arena) == -2) return -1;
+                selector = comma + 1;
+            }
+        }
+        p = close < end ? close + 1 : end;
+    }
+}
+
+// Whether the whitespace-separated class attribute lists the class [name, name_end)
+static int has_class(const char *classes, size_t len, const char *name, size_t name_len) {
+    const char *p = classes, *end = classes + len;
+    while (p < end) {
+        p = skip_space(p, end);
+        const char *word = p;
+        while (p < end && !is_space(*p)) p++;
+        if ((size_t)(p - word) == name_len && memcmp(word, name, name_len) == 0) return 1;
+    }
+    return 0;
+}
+
+static int rule_matches(const SvgStyleRule *rule, SvgElementKind kind, const char *classes, size_t classes_len) {
+    if (rule->element != SVG_ELEMENT_OTHER && rule->element != kind) return 0;
+    if (!rule->classes) return 1;
+    if (!classes) return 0;
+
+    // Every class of the selector has to be present
+    const char *p = rule->classes;
+    while (*p == '.') {
+        const char *name = ++p;
+        while (is_name_char(*p)) p++;
+        if (!has_class(classes, classes_len, name, p - name)) return 0;
+    }
+    return 1;
+}
+
+void svg_stylesheet_apply(const SvgStyleSheet *sheet, SvgElementKind kind,
+                          const char *classes, size_t classes_len, SvgStyle *style) {
+    for (const SvgStyleRule *rule = sheet->rules; rule; rule = rule->next) {
+        if (rule_matches(rule, kind, classes, classes_len)) svg_style_merge(style, &rule->declarations);
+    }
+}
+
+// FNV-1a a byte at a time: the table is indexed by the low bits, which a
+// whole-word step would leave depending on the low byte (alpha) alone
+static uint32_t hash_paint(uint32_t h, const SvgPaint *paint) {
+    h = (h ^ (uint32_t)paint->kind) * 16777619u;
+    for (int shift = 24; shift >= 0; shift -= 8) h = (h ^ ((paint->rgba >> shift) & 0xFF)) * 16777619u;
+    if (paint->text) {
+        for (const char *p = paint->text; *p; p++) h = (h ^ (unsigned char)*p) * 16777619u;
+    }
+    return h;
+}
+
+uint32_t svg_style_hash(const SvgStyle *style) {
+    uint32_t h = hash_paint(hash_paint(2166136261u, &style->fill), &style->stroke);
+    return (h ^ (uint32_t)style->fill_rule) * 16777619u;
+}
+
+static int same_paint(const SvgPaint *a, const SvgPaint *b) {
+    if (a->kind != b->kind || a->rgba != b->rgba) return 0;
+    if (!a->text || !b->text) return a->text == b->text;
+    return strcmp(a->text, b->text) == 0;
+}
+
+int svg_style_equal(const SvgStyle *a, const SvgStyle *b) {
+    return same_paint(&a->fill, &b->fill) && same_paint(&a->stroke, &b->stroke) && a->fill_rule == b->fill_rule;
+}
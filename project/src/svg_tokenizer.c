@@ -0,0 +1,280 @@
+#include "../include/svg_tokenizer.h"
+#include "../include/svg_scan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    SCAN_MARKUP,
+    SCAN_COMMENT,//inside <!-- -->
+    SCAN_CDATA//inside <![CDATA[ ]]>
+};
+
+// Pass requested character data on; the first handler error stops the scan
+static int deliver_text(SvgTokenizer *tok, const char *text, const char *end) {
+    if (!tok->want_text || !tok->text || text >= end) return 0;
+    int result = tok->text(tok->ctx, text, end);
+    if (result != 0) tok->error = result;
+    return result;
+}
+
+// "]" characters held back at the end of a piece while looking for "]]>"
+static int deliver_brackets(SvgTokenizer *tok, int count) {
+    static const char brackets[] = "]]]]]]]]]]]]]]]]";
+    while (count > 0) {
+        int n = count < 16 ? count : 16;
+        if (deliver_text(tok, brackets, brackets + n) != 0) return -1;
+        count -= n;
+    }
+    return 0;
+}
+
+// CDATA whose content was asked for. A run of ']' at the end of a piece is
+// held back (tok->run) until it is known whether "]]>" follows
+static const char *scan_cdata_text(SvgTokenizer *tok, const char *p, const char *end) {
+    const char *from = p;
+    int held = tok->run;//brackets from earlier pieces, not delivered yet
+    for (; p < end; p++) {
+        if (*p == ']') {
+            tok->run++;
+        } else if (*p == '>' && tok->run >= 2) {
+            // The last two brackets close the section; any before them are content
+            if (held > 0) deliver_brackets(tok, tok->run - 2);
+            else deliver_text(tok, from, p - 2);
+            tok->mode = SCAN_MARKUP;
+            tok->run = 0;
+            return p + 1;
+        } else {
+            if (held > 0 && deliver_brackets(tok, held) != 0) return end;
+            held = 0;
+            tok->run = 0;
+        }
+    }
+    if (held == 0) deliver_text(tok, from, end - tok->run);
+    return end;
+}
+
+// Consume complete constructs in [p, end) and return the first byte that
+// has to wait for more input (an unfinished tag). Comments and CDATA are
+// consumed incrementally so they never need to fit in the window.
+static const char *scan(SvgTokenizer *tok, const char *p, const char *end, int final) {
+    while (p < end) {
+        if (tok->mode == SCAN_CDATA && tok->want_text) {
+            p = scan_cdata_text(tok, p, end);
+            if (tok->error) return end;
+            continue;
+        }
+        if (tok->mode == SCAN_COMMENT || tok->mode == SCAN_CDATA) {
+            char closer = tok->mode == SCAN_COMMENT ? '-' : ']';
+            for (; p < end; p++) {
+                if (*p == closer) {
+                    tok->run++;
+                } else if (*p == '>' && tok->run >= 2) {
+                    tok->mode = SCAN_MARKUP;
+                    tok->run = 0;
+                    p++;
+                    break;
+                } else {
+                    tok->run = 0;
+                }
+            }
+            continue;
+        }
+
+        const char *lt = memchr(p, '<', end - p);
+        if (!lt) {
+            // Character data is only kept when the last tag asked for it
+            deliver_text(tok, p, end);
+            return end;
+        }
+        if (lt > p && deliver_text(tok, p, lt) != 0) return end;
+
+        // Need enough lookahead to tell comments and CDATA from other markup
+        size_t avail = end - lt;
+        if (!final && (avail < 4 || (lt[1] == '!' && avail < 9))) return lt;
+
+        if (avail >= 4 && memcmp(lt, "<!--", 4) == 0) {
+            tok->mode = SCAN_COMMENT;
+            tok->run = 0;
+            p = lt + 4;
+            continue;
+        }
+        if (avail >= 9 && memcmp(lt, "<![CDATA[", 9) == 0) {
+            tok->mode = SCAN_CDATA;
+            tok->run = 0;
+            p = lt + 9;
+            continue;
+        }
+
+        // Find the closing '>' while skipping over quoted attribute values
+        const char *q = svg_scan_tag_end(lt + 1, end);
+        if (q >= end) return lt; // unfinished tag, wait for the rest
+
+        // Declarations and processing instructions carry no shapes
+        if (lt[1] != '?' && lt[1] != '!') {
+            int result = tok->handler(tok->ctx, lt + 1, q);
+            tok->want_text = result == SVG_TOKEN_WANT_TEXT;
+            if (result != 0 && !tok->want_text) {
+                tok->error = result;
+                return end;
+            }
+        }
+        p = q + 1;
+    }
+    return p;
+}
+
+static const char *skip_space(const char *p, const char *end) {
+    while (p < end && (unsigned char)*p <= 0x20) p++;
+    return p;
+}
+
+int svg_lex_attributes(const char *p, const char *end, SvgAttributeTable *table) {
+    table->count = 0;
+
+    for (;;) {
+        p = skip_space(p, end);
+        if (p >= end || *p == '/' || *p == '>') break;
+
+        // Attribute name runs up to '=' or whitespace
+        const char *name = p;
+        p = svg_scan_structural(p, end);
+        if (p == name) {
+            p++; // stray delimiter, step over it
+            continue;
+        }
+        const char *name_end = p;
+
+        p = skip_space(p, end);
+        if (p >= end || *p != '=') continue; // attribute without a value
+        p = skip_space(p + 1, end);
+        if (p >= end) break;
+
+        const char *value;
+        const char *value_end;
+        if (*p == '"' || *p == '\'') {
+            value = p + 1;
+            value_end = memchr(value, *p, end - value);
+            if (!value_end) break;
+            p = value_end + 1;
+        } else {
+            // Tolerate unquoted values
+            value = p;
+            value_end = p;
+            while (value_end < end && (unsigned char)*value_end > 0x20 && *value_end != '/')
+                value_end++;
+            p = value_end;
+        }
+
+        if (table->count < SVG_MAX_ATTRIBUTES) {
+            SvgAttribute *attr = &table->items[table->count++];
+            attr->name = name;
+            attr->name_len = name_end - name;
+            attr->value = value;
+            attr->value_len = value_end - value;
+        }
+    }
+    return table->count;
+}
+
+const SvgAttribute *svg_find_attribute(const SvgAttributeTable *table, const char *name) {
+    size_t len = strlen(name);
+    for (int i = 0; i < table->count; i++) {
+        const SvgAttribute *attr = &table->items[i];
+        if (attr->name_len == len && memcmp(attr->name, name, len) == 0) return attr;
+    }
+    return NULL;
+}
+
+int svg_tokenize_buffer(const char *data, size_t size, SvgElementHandler handler, SvgTextHandler text,
+                        void *ctx) {
+    int clean;
+    return svg_tokenize_piece(data, size, handler, text, ctx, 1, &clean);
+}
+
+int svg_tokenize_piece(const char *data, size_t size, SvgElementHandler handler, SvgTextHandler text,
+                       void *ctx, int last, int *clean) {
+    SvgTokenizer tok;
+    memset(&tok, 0, sizeof(tok));
+    tok.handler = handler;
+    tok.text = text;
+    tok.ctx = ctx;
+
+    const char *end = data + size;
+    const char *p = size ? scan(&tok, data, end, last) : end;
+    *clean = (p == end && tok.mode == SCAN_MARKUP);
+    return tok.error;
+}
+
+int svg_tokenizer_init(SvgTokenizer *tok, SvgElementHandler handler, SvgTextHandler text, void *ctx) {
+    memset(tok, 0, sizeof(*tok));
+    tok->window = (char *)malloc(SVG_TOKENIZER_WINDOW);
+    if (!tok->window) return -1;
+    tok->capacity = SVG_TOKENIZER_WINDOW;
+    tok->handler = handler;
+    tok->text = text;
+    tok->ctx = ctx;
+    return 0;
+}
+
+char *svg_tokenizer_space(SvgTokenizer *tok, size_t *avail) {
+    // Slide the unfinished tail to the front of the window
+    if (tok->start > 0) {
+        memmove(tok->window, tok->window + tok->start, tok->used - tok->start);
+        tok->used -= tok->start;
+        tok->start = 0;
+    }
+
+    // Back to the normal size once an oversized tag has been consumed
+    if (tok->capacity > SVG_TOKENIZER_WINDOW && tok->used <= SVG_TOKENIZER_WINDOW / 2) {
+        char *window = (char *)realloc(tok->window, SVG_TOKENIZER_WINDOW);
+        if (window) {
+            tok->window = window;
+            tok->capacity = SVG_TOKENIZER_WINDOW;
+        }
+    }
+
+    // A single tag fills the whole window (a long points list): grow it up to
+    // the cap. Dropping the tag would lose geometry and, for a container,
+    // unbalance the group stack, so above the cap the load fails instead
+    if (tok->used == tok->capacity && !tok->error) {
+        size_t capacity = tok->capacity * 2;
+        if (capacity > SVG_TOKENIZER_MAX_TAG) capacity = SVG_TOKENIZER_MAX_TAG;
+        char *window = capacity > tok->capacity ? (char *)realloc(tok->window, capacity) : NULL;
+        if (window) {
+            tok->window = window;
+            tok->capacity = capacity;
+        } else {
+            fprintf(stderr, "Error: element larger than %lu bytes\n", (unsigned long)tok->capacity);
+            tok->error = -1;
+        }
+    }
+    if (tok->error) {
+        *avail = 0;
+        return tok->window + tok->used;
+    }
+
+    *avail = tok->capacity - tok->used;
+    return tok->window + tok->used;
+}
+
+int svg_tokenizer_advance(SvgTokenizer *tok, size_t len) {
+    tok->used += len;
+    const char *p = scan(tok, tok->window + tok->start, tok->window + tok->used, 0);
+    tok->start = p - tok->window;
+    return tok->error;
+}
+
+int svg_tokenizer_finish(SvgTokenizer *tok) {
+    if (tok->error) return tok->error;
+    // Whatever is still pending is a tag cut off by the end of input
+    scan(tok, tok->window + tok->start, tok->window + tok->used, 1);
+    tok->start = tok->used = 0;
+    return tok->error;
+}
+
+void svg_tokenizer_release(SvgTokenizer *tok) {
+    free(tok->window);
+    tok->window = NULL;
+    tok->capacity = 0;
+}
@@ -0,0 +1,295 @@
+#include "../include/svg_transform.h"
+#include "../include/svg_number.h"
+#include <math.h>
+#include <string.h>
+
+#define SVG_PI 3.14159265358979323846
+
+void svg_matrix_identity(SvgMatrix *m) {
+    m->a = 1.0;
+    m->b = 0.0;
+    m->c = 0.0;
+    m->d = 1.0;
+    m->e = 0.0;
+    m->f = 0.0;
+}
+
+void svg_matrix_multiply(const SvgMatrix *outer, const SvgMatrix *inner, SvgMatrix *out) {
+    SvgMatrix r;
+    r.a = outer->a * inner->a + outer->c * inner->b;
+    r.b = outer->b * inner->a + outer->d * inner->b;
+    r.c = outer->a * inner->c + outer->c * inner->d;
+    r.d = outer->b * inner->c + outer->d * inner->d;
+    r.e = outer->a * inner->e + outer->c * inner->f + outer->e;
+    r.f = outer->b * inner->e + outer->d * inner->f + outer->f;
+    *out = r;
+}
+
+int svg_matrix_invert(const SvgMatrix *m, SvgMatrix *out) {
+    double det = m->a * m->d - m->b * m->c;
+    if (det == 0.0 || !isfinite(det)) return -1;
+
+    SvgMatrix r;
+    r.a = m->d / det;
+    r.b = -m->b / det;
+    r.c = -m->c / det;
+    r.d = m->a / det;
+    r.e = (m->c * m->f - m->d * m->e) / det;
+    r.f = (m->b * m->e - m->a * m->f) / det;
+    *out = r;
+    return 0;
+}
+
+void svg_matrix_apply(const SvgMatrix *m, double x, double y, double *out_x, double *out_y) {
+    if (!m) {
+        *out_x = x;
+        *out_y = y;
+        return;
+    }
+    *out_x = m->a * x + m->c * y + m->e;
+    *out_y = m->b * x + m->d * y + m->f;
+}
+
+static const char *skip_separators(const char *p, const char *end) {
+    while (p < end && (*p == ',' || (unsigned char)*p <= 0x20)) p++;
+    return p;
+}
+
+// "( n n ... )" after a transform name; return the byte after ')' or NULL
+static const char *parse_arguments(const char *p, const char *end, double *args, int *count) {
+    while (p < end && (unsigned char)*p <= 0x20) p++;
+    if (p == end || *p != '(') return NULL;
+    p++;
+
+    *count = 0;
+    for (;;) {
+        p = skip_separators(p, end);
+        if (p == end) return NULL;
+        if (*p == ')') return p + 1;
+        if (*count == 6) return NULL;
+        const char *next = svg_parse_number(p, end, &args[*count]);
+        if (next == p) return NULL;
+        (*count)++;
+        p = next;
+    }
+}
+
+static int name_is(const char *name, size_t len, const char *expected) {
+    return strlen(expected) == len && memcmp(name, expected, len) == 0;
+}
+
+int svg_transform_parse(const char *s, size_t len, SvgMatrix *out) {
+    const char *p = s;
+    const char *end = s + len;
+    svg_matrix_identity(out);
+
+    for (;;) {
+        p = skip_separators(p, end);
+        if (p == end) return 0;
+
+        const char *name = p;
+        while (p < end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z'))) p++;
+        size_t name_len = p - name;
+
+        double v[6];
+        int n;
+        p = parse_arguments(p, end, v, &n);
+        if (!p) break;
+
+        // Each item applies inside the ones before it: out = out * item
+        SvgMatrix t;
+        svg_matrix_identity(&t);
+        if (name_is(name, name_len, "matrix") && n == 6) {
+            t.a = v[0];
+            t.b = v[1];
+            t.c = v[2];
+            t.d = v[3];
+            t.e = v[4];
+            t.f = v[5];
+        } else if (name_is(name, name_len, "translate") && (n == 1 || n == 2)) {
+            t.e = v[0];
+            t.f = n == 2 ? v[1] : 0.0;
+        } else if (name_is(name, name_len, "scale") && (n == 1 || n == 2)) {
+            t.a = v[0];
+            t.d = n == 2 ? v[1] : v[0];
+        } else if (name_is(name, name_len, "rotate") && (n == 1 || n == 3)) {
+            double angle = v[0] * SVG_PI / 180.0;
+            double cs = cos(angle), sn = sin(angle);
+            t.a = cs;
+            t.b = sn;
+            t.c = -sn;
+            t.d = cs;
+            if (n == 3) { // about (cx, cy)
+                t.e = v[1] - cs * v[1] + sn * v[2];
+                t.f = v[2] - sn * v[1] - cs * v[2];
+            }
+        } else if (name_is(name, name_len, "skewX") && n == 1) {
+            t.c = tan(v[0] * SVG_PI / 180.0);
+        } else if (name_is(name, name_len, "skewY") && n == 1) {
+            t.b = tan(v[0] * SVG_PI / 180.0);
+        } else {
+            break;
+        }
+        svg_matrix_multiply(out, &t, out);
+    }
+
+    svg_matrix_identity(out);
+    return -1;
+}
+
+// Narrow [*lo, *hi] to the x where min <= p + u*x <= max
+static void clip_axis(double p, double u, double min, double max, double *lo, double *hi) {
+    if (min > max) { double t = min; min = max; max = t; }
+    if (u == 0.0) {
+        if (p < min || p > max) *hi = -HUGE_VAL;
+        return;
+    }
+    double t0 = (min - p) / u, t1 = (max - p) / u;
+    if (t0 > t1) { double t = t0; t0 = t1; t1 = t; }
+    if (t0 > *lo) *lo = t0;
+    if (t1 < *hi) *hi = t1;
+}
+
+int svg_shape_row_span(const SvgShape *shape, const SvgMatrix *inverse, double y, double *x0, double *x1) {
+    // Along the row, local coordinates move linearly: p + u*x
+    double px = inverse->c * y + inverse->e, ux = inverse->a;
+    double py = inverse->d * y + inverse->f, uy = inverse->b;
+
+    if (shape->type == SVG_SHAPE_CIRCLE) {
+        const SvgCircle *c = &shape->data.circle;
+        double qx = px - c->cx, qy = py - c->cy;
+        double a = ux * ux + uy * uy;
+        double b = 2.0 * (qx * ux + qy * uy);
+        double k = qx * qx + qy * qy - c->r * c->r;
+        double disc = b * b - 4.0 * a * k;
+        if (a == 0.0 || disc < 0.0) return 0;
+        double root = sqrt(disc);
+        *x0 = (-b - root) / (2.0 * a);
+        *x1 = (-b + root) / (2.0 * a);
+        return 1;
+    }
+    if (shape->type == SVG_SHAPE_RECT) {
+        const SvgRect *r = &shape->data.rect;
+        double lo = -HUGE_VAL, hi = HUGE_VAL;
+        clip_axis(px, ux, r->x, r->x + r->width, &lo, &hi);
+        clip_axis(py, uy, r->y, r->y + r->height, &lo, &hi);
+        if (lo > hi) return 0;
+        *x0 = lo;
+        *x1 = hi;
+        return 1;
+    }
+    return 0;
+}
+
+static void grow_bounds(double out[4], const SvgMatrix *m, double x, double y, int first) {
+    svg_matrix_apply(m, x, y, &x, &y);
+    if (first || x < out[0]) out[0] = x;
+    if (first || y < out[1]) out[1] = y;
+    if (first || x > out[2]) out[2] = x;
+    if (first || y > out[3]) out[3] = y;
+}
+
+void svg_use_matrix(const SvgShape *shape, SvgMatrix *out) {
+    SvgMatrix offset;
+    svg_matrix_identity(&offset);
+    offset.e = shape->data.use.x;
+    offset.f = shape->data.use.y;
+    if (shape->transform) svg_matrix_multiply(shape->transform, &offset, out);
+    else *out = offset;
+}
+
+// Bounds of shape placed by outer (NULL for identity); return 0 when it covers nothing
+static int bounds_under(const SvgShape *shape, const SvgMatrix *outer, double out[4], int depth) {
+    SvgMatrix composed;
+    const SvgMatrix *m = shape->transform;
+    if (outer) {
+        if (m) svg_matrix_multiply(outer, m, &composed);
+        else composed = *outer;
+        m = &composed;
+    }
+
+    switch (shape->type) {
+        case SVG_SHAPE_CIRCLE: {
+            // A transformed circle is an ellipse; these are its exact extents
+            const SvgCircle *c = &shape->data.circle;
+            double r = fabs(c->r);
+            double hx = m ? r * sqrt(m->a * m->a + m->c * m->c) : r;
+            double hy = m ? r * sqrt(m->b * m->b + m->d * m->d) : r;
+            double x, y;
+            svg_matrix_apply(m, c->cx, c->cy, &x, &y);
+            out[0] = x - hx;
+            out[1] = y - hy;
+            out[2] = x + hx;
+            out[3] = y + hy;
+            return 1;
+        }
+        case SVG_SHAPE_RECT: {
+            const SvgRect *r = &shape->data.rect;
+            grow_bounds(out, m, r->x, r->y, 1);
+            grow_bounds(out, m, r->x + r->width, r->y, 0);
+            grow_bounds(out, m, r->x, r->y + r->height, 0);
+            grow_bounds(out, m, r->x + r->width, r->y + r->height, 0);
+            return 1;
+        }
+        case SVG_SHAPE_LINE: {
+            const SvgLine *l = &shape->data.line;
+            grow_bounds(out, m, l->x1, l->y1, 1);
+            grow_bounds(out, m, l->x2, l->y2, 0);
+            return 1;
+        }
+        case SVG_SHAPE_POLYGON:
+        case SVG_SHAPE_POLYLINE: {
+            const SvgPoly *poly = &shape->data.poly;
+            for (int i = 0; i < poly->count; i++)
+                grow_bounds(out, m, poly->points[2 * i], poly->points[2 * i + 1], i == 0);
+            return poly->count > 0;
+        }
+        case SVG_SHAPE_USE: {
+            const SvgDefinition *definition = shape->data.use.definition;
+            if (!definition || depth >= SVG_MAX_USE_DEPTH) return 0;
+            SvgMatrix placed;
+            svg_use_matrix(shape, &placed);
+            if (outer) svg_matrix_multiply(outer, &placed, &placed);
+
+            // The parser caches every definition's box when it settles it
+            if (definition->settled == SVG_DEFINITION_SETTLED) {
+                const double *box = definition->box;
+                if (!(box[0] <= box[2])) return 0;
+                grow_bounds(out, &placed, box[0], box[1], 1);
+                grow_bounds(out, &placed, box[2], box[1], 0);
+                grow_bounds(out, &placed, box[0], box[3], 0);
+                grow_bounds(out, &placed, box[2], box[3], 0);
+                return 1;
+            }
+            int any = 0;
+            for (const SvgShape *part = definition->shapes; part; part = part->next) {
+                double box[4];
+                if (!bounds_under(part, &placed, box, depth + 1)) continue;
+                if (!any || box[0] < out[0]) out[0] = box[0];
+                if (!any || box[1] < out[1]) out[1] = box[1];
+                if (!any || box[2] > out[2]) out[2] = box[2];
+                if (!any || box[3] > out[3]) out[3] = box[3];
+                any = 1;
+            }
+            return any;
+        }
+    }
+    return 0;
+}
+
+int svg_shape_covered_bounds(const SvgShape *shape, double out[4]) {
+    return bounds_under(shape, NULL, out, 0);
+}
+
+void svg_shape_bounds(const SvgShape *shape, double out[4]) {
+    if (bounds_under(shape, NULL, out, 0)) return;
+    // An empty instance still has a position; an empty point list sits at the origin
+    double x = 0.0, y = 0.0;
+    if (shape->type == SVG_SHAPE_USE) {
+        x = shape->data.use.x;
+        y = shape->data.use.y;
+    }
+    svg_matrix_apply(shape->transform, x, y, &x, &y);
+    out[0] = out[2] = x;
+    out[1] = out[3] = y;
+}
@@ -1,6 +1,95 @@
 #include "../include/svg_writer.h"
+#include "../include/svg_color.h"
+#include "../include/svg_parser.h"
+#include "../include/svg_style.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// One element per line at the given indent
+static void write_shape(FILE *file, const SvgShape *current, const char *indent) {
+    char color[16];
+    switch (current->type) {
+        case SVG_SHAPE_CIRCLE:
+            fprintf(file, "%s<circle cx=\"%.2f\" cy=\"%.2f\" r=\"%.2f\" fill=\"%s\"", indent,
+                   current->data.circle.cx,
+                   current->data.circle.cy,
+                   current->data.circle.r,
+                   svg_paint_format(&current->style->fill, color, "#000000"));
+            break;
+        
+        case SVG_SHAPE_RECT:
+            fprintf(file, "%s<rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" fill=\"%s\"", indent,
+                   current->data.rect.x,
+                   current->data.rect.y,
+                   current->data.rect.width,
+                   current->data.rect.height,
+                   svg_paint_format(&current->style->fill, color, "#000000"));
+            break;
+        
+        case SVG_SHAPE_LINE:
+            fprintf(file, "%s<line x1=\"%.2f\" y1=\"%.2f\" x2=\"%.2f\" y2=\"%.2f\" stroke=\"%s\"", indent,
+                   current->data.line.x1,
+                   current->data.line.y1,
+                   current->data.line.x2,
+                   current->data.line.y2,
+                   svg_paint_format(&current->style->stroke, color, "#000000"));
+            break;
+
+        case SVG_SHAPE_USE: {
+            const SvgUse *use = &current->data.use;
+            const char *href = use->definition ? use->definition->id : use->href;
+            fprintf(file, "%s<use href=\"#%s\" x=\"%.2f\" y=\"%.2f\"", indent, href ? href : "", use->x, use->y);
+            break;
+        }
+
+        case SVG_SHAPE_POLYGON:
+        case SVG_SHAPE_POLYLINE: {
+            const SvgPoly *poly = &current->data.poly;
+            const SvgStyle *style = current->style;
+            int closed = current->type == SVG_SHAPE_POLYGON;
+            fprintf(file, "%s<%s points=\"", indent, closed ? "polygon" : "polyline");
+            for (int i = 0; i < poly->count; i++)
+                fprintf(file, "%s%.2f,%.2f", i ? " " : "", poly->points[2 * i], poly->points[2 * i + 1]);
+            // A polygon's outline and a polyline's inside are only drawn when set
+            fprintf(file, "\" fill=\"%s\"", svg_paint_format(&style->fill, color, closed ? "#000000" : "none"));
+            if (!closed || svg_paint_is_set(&style->stroke))
+                fprintf(file, " stroke=\"%s\"", svg_paint_format(&style->stroke, color, "#000000"));
+            if (style->fill_rule == SVG_FILL_RULE_EVENODD) fprintf(file, " fill-rule=\"evenodd\"");
+            break;
+        }
+    }
+    // Groups were flattened at load time; each shape carries its whole transform
+    if (current->transform) {
+        const SvgMatrix *m = current->transform;
+        fprintf(file, " transform=\"matrix(%.9g %.9g %.9g %.9g %.9g %.9g)\"",
+                m->a, m->b, m->c, m->d, m->e, m->f);
+    }
+    fprintf(file, "/>\n");
+}
+
+// Each definition once, as a <g id> inside <defs>, in document order
+static int write_definitions(FILE *file, const SvgDocument *doc) {
+    if (doc->definition_count == 0) return 0;
+    const SvgDefinition **ordered = (const SvgDefinition **)calloc(doc->definition_count, sizeof(*ordered));
+    if (!ordered) return -1;
+    for (const SvgDefinition *definition = doc->definitions; definition; definition = definition->next)
+        ordered[definition->index] = definition;
+
+    fprintf(file, "  <defs>\n");
+    for (int i = 0; i < doc->definition_count; i++) {
+        const SvgDefinition *definition = ordered[i];
+        // A repeated id is unreachable; writing it again would make the output ambiguous
+        if (svg_document_find_definition(doc, definition->id, strlen(definition->id)) != definition) continue;
+        fprintf(file, "    <g id=\"%s\">\n", definition->id);
+        for (const SvgShape *part = definition->shapes; part; part = part->next)
+            write_shape(file, part, "      ");
+        fprintf(file, "    </g>\n");
+    }
+    fprintf(file, "  </defs>\n");
+    free(ordered);
+    return 0;
+}
 
 int svg_save_to_file(const char *filename, const SvgDocument *doc) {
     if (!doc || !filename) return -1;
@@ -15,38 +104,19 @@ int svg_save_to_file(const char *filename, const SvgDocument *doc) {
     fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
     fprintf(file, "<svg width=\"%.0f\" height=\"%.0f\" xmlns=\"http://www.w3.org/2000/svg\">\n", 
             doc->width, doc->height);
+
+    if (write_definitions(file, doc) != 0) {
+        fclose(file);
+        return -1;
+    }
     
     // Write all shapes
-    SvgShape *current = doc->shapes;
-    while (current) {
-        switch (current->type) {
-            case SVG_SHAPE_CIRCLE:
-                fprintf(file, "  <circle cx=\"%.2f\" cy=\"%.2f\" r=\"%.2f\" fill=\"%s\"/>\n",
-                       current->data.circle.cx,
-                       current->data.circle.cy,
-                       current->data.circle.r,
-                       current->data.circle.fill ? current->data.circle.fill : "#000000");
-                break;
-            
-            case SVG_SHAPE_RECT:
-                fprintf(file, "  <rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" fill=\"%s\"/>\n",
-                       current->data.rect.x,
-                       current->data.rect.y,
-                       current->data.rect.width,
-                       current->data.rect.height,
-                       current->data.rect.fill ? current->data.rect.fill : "#000000");
-                break;
-            
-            case SVG_SHAPE_LINE:
-                fprintf(file, "  <line x1=\"%.2f\" y1=\"%.2f\" x2=\"%.2f\" y2=\"%.2f\" stroke=\"%s\"/>\n",
-                       current->data.line.x1,
-                       current->data.line.y1,
-                       current->data.line.x2,
-                       current->data.line.y2,
-                       current->data.line.stroke ? current->data.line.stroke : "#000000");
-                break;
-        }
-        current = current->next;
+    SvgShapeIter it;
+    for (const SvgShape *current = svg_shapes_first(&it, doc); current; current = svg_shapes_next(&it))
+        write_shape(file, current, "  ");
+    if (it.failed) {
+        fclose(file);
+        return -1;
     }
     
     // Write SVG footer
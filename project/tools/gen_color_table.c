@@ -0,0 +1,135 @@
+// Generator for include/svg_color_table.h: the 147 SVG color keywords in a
+// perfect hash (hash and displace) over SVG_COLOR_SLOTS slots, so a name
+// decodes with two hashes and one comparison
+// Build and run: make colors
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../include/svg_color_hash.h"
+
+typedef struct {
+    const char *name;
+    uint32_t rgb;
+} NamedColor;
+
+static const NamedColor colors[] = {
+    {"aliceblue", 0xF0F8FF}, {"antiquewhite", 0xFAEBD7}, {"aqua", 0x00FFFF},
+    {"aquamarine", 0x7FFFD4}, {"azure", 0xF0FFFF}, {"beige", 0xF5F5DC},
+    {"bisque", 0xFFE4C4}, {"black", 0x000000}, {"blanchedalmond", 0xFFEBCD},
+    {"blue", 0x0000FF}, {"blueviolet", 0x8A2BE2}, {"brown", 0xA52A2A},
+    {"burlywood", 0xDEB887}, {"cadetblue", 0x5F9EA0}, {"chartreuse", 0x7FFF00},
+    {"chocolate", 0xD2691E}, {"coral", 0xFF7F50}, {"cornflowerblue", 0x6495ED},
+    {"cornsilk", 0xFFF8DC}, {"crimson", 0xDC143C}, {"cyan", 0x00FFFF},
+    {"darkblue", 0x00008B}, {"darkcyan", 0x008B8B}, {"darkgoldenrod", 0xB8860B},
+    {"darkgray", 0xA9A9A9}, {"darkgreen", 0x006400}, {"darkgrey", 0xA9A9A9},
+    {"darkkhaki", 0xBDB76B}, {"darkmagenta", 0x8B008B}, {"darkolivegreen", 0x556B2F},
+    {"darkorange", 0xFF8C00}, {"darkorchid", 0x9932CC}, {"darkred", 0x8B0000},
+    {"darksalmon", 0xE9967A}, {"darkseagreen", 0x8FBC8F}, {"darkslateblue", 0x483D8B},
+    {"darkslategray", 0x2F4F4F}, {"darkslategrey", 0x2F4F4F}, {"darkturquoise", 0x00CED1},
+    {"darkviolet", 0x9400D3}, {"deeppink", 0xFF1493}, {"deepskyblue", 0x00BFFF},
+    {"dimgray", 0x696969}, {"dimgrey", 0x696969}, {"dodgerblue", 0x1E90FF},
+    {"firebrick", 0xB22222}, {"floralwhite", 0xFFFAF0}, {"forestgreen", 0x228B22},
+    {"fuchsia", 0xFF00FF}, {"gainsboro", 0xDCDCDC}, {"ghostwhite", 0xF8F8FF},
+    {"gold", 0xFFD700}, {"goldenrod", 0xDAA520}, {"gray", 0x808080},
+    {"grey", 0x808080}, {"green", 0x008000}, {"greenyellow", 0xADFF2F},
+    {"honeydew", 0xF0FFF0}, {"hotpink", 0xFF69B4}, {"indianred", 0xCD5C5C},
+    {"indigo", 0x4B0082}, {"ivory", 0xFFFFF0}, {"khaki", 0xF0E68C},
+    {"lavender", 0xE6E6FA}, {"lavenderblush", 0xFFF0F5}, {"lawngreen", 0x7CFC00},
+    {"lemonchiffon", 0xFFFACD}, {"lightblue", 0xADD8E6}, {"lightcoral", 0xF08080},
+    {"lightcyan", 0xE0FFFF}, {"lightgoldenrodyellow", 0xFAFAD2}, {"lightgray", 0xD3D3D3},
+    {"lightgreen", 0x90EE90}, {"lightgrey", 0xD3D3D3}, {"lightpink", 0xFFB6C1},
+    {"lightsalmon", 0xFFA07A}, {"lightseagreen", 0x20B2AA}, {"lightskyblue", 0x87CEFA},
+    {"lightslategray", 0x778899}, {"lightslategrey", 0x778899}, {"lightsteelblue", 0xB0C4DE},
+    {"lightyellow", 0xFFFFE0}, {"lime", 0x00FF00}, {"limegreen", 0x32CD32},
+    {"linen", 0xFAF0E6}, {"magenta", 0xFF00FF}, {"maroon", 0x800000},
+    {"mediumaquamarine", 0x66CDAA}, {"mediumblue", 0x0000CD}, {"mediumorchid", 0xBA55D3},
+    {"mediumpurple", 0x9370DB}, {"mediumseagreen", 0x3CB371}, {"mediumslateblue", 0x7B68EE},
+    {"mediumspringgreen", 0x00FA9A}, {"mediumturquoise", 0x48D1CC}, {"mediumvioletred", 0xC71585},
+    {"midnightblue", 0x191970}, {"mintcream", 0xF5FFFA}, {"mistyrose", 0xFFE4E1},
+    {"moccasin", 0xFFE4B5}, {"navajowhite", 0xFFDEAD}, {"navy", 0x000080},
+    {"oldlace", 0xFDF5E6}, {"olive", 0x808000}, {"olivedrab", 0x6B8E23},
+    {"orange", 0xFFA500}, {"orangered", 0xFF4500}, {"orchid", 0xDA70D6},
+    {"palegoldenrod", 0xEEE8AA}, {"palegreen", 0x98FB98}, {"paleturquoise", 0xAFEEEE},
+    {"palevioletred", 0xDB7093}, {"papayawhip", 0xFFEFD5}, {"peachpuff", 0xFFDAB9},
+    {"peru", 0xCD853F}, {"pink", 0xFFC0CB}, {"plum", 0xDDA0DD},
+    {"powderblue", 0xB0E0E6}, {"purple", 0x800080}, {"red", 0xFF0000},
+    {"rosybrown", 0xBC8F8F}, {"royalblue", 0x4169E1}, {"saddlebrown", 0x8B4513},
+    {"salmon", 0xFA8072}, {"sandybrown", 0xF4A460}, {"seagreen", 0x2E8B57},
+    {"seashell", 0xFFF5EE}, {"sienna", 0xA0522D}, {"silver", 0xC0C0C0},
+    {"skyblue", 0x87CEEB}, {"slateblue", 0x6A5ACD}, {"slategray", 0x708090},
+    {"slategrey", 0x708090}, {"snow", 0xFFFAFA}, {"springgreen", 0x00FF7F},
+    {"steelblue", 0x4682B4}, {"tan", 0xD2B48C}, {"teal", 0x008080},
+    {"thistle", 0xD8BFD8}, {"tomato", 0xFF6347}, {"turquoise", 0x40E0D0},
+    {"violet", 0xEE82EE}, {"wheat", 0xF5DEB3}, {"white", 0xFFFFFF},
+    {"whitesmoke", 0xF5F5F5}, {"yellow", 0xFFFF00}, {"yellowgreen", 0x9ACD32},
+};
+
+#define COLOR_COUNT (int)(sizeof(colors) / sizeof(colors[0]))
+
+static uint32_t key_hash(const char *name, uint32_t seed) {
+    return svg_color_hash(name, strlen(name), seed);
+}
+
+int main(void) {
+    int bucket_of[COLOR_COUNT], size[SVG_COLOR_BUCKETS] = {0};
+    int order[SVG_COLOR_BUCKETS];
+    int slot_of[SVG_COLOR_SLOTS];
+    uint32_t displacement[SVG_COLOR_BUCKETS] = {0};
+
+    for (int i = 0; i < COLOR_COUNT; i++) {
+        bucket_of[i] = key_hash(colors[i].name, 0) & (SVG_COLOR_BUCKETS - 1);
+        size[bucket_of[i]]++;
+    }
+    for (int i = 0; i < SVG_COLOR_SLOTS; i++) slot_of[i] = -1;
+
+    // Place the fullest buckets first; each gets the first seed that sends
+    // all of its names to free slots
+    for (int i = 0; i < SVG_COLOR_BUCKETS; i++) order[i] = i;
+    for (int i = 1; i < SVG_COLOR_BUCKETS; i++) {
+        for (int j = i; j > 0 && size[order[j]] > size[order[j - 1]]; j--) {
+            int t = order[j]; order[j] = order[j - 1]; order[j - 1] = t;
+        }
+    }
+    for (int n = 0; n < SVG_COLOR_BUCKETS; n++) {
+        int bucket = order[n];
+        if (size[bucket] == 0) break;
+        for (uint32_t seed = 1;; seed++) {
+            if (seed == 1000000) {
+                fprintf(stderr, "No displacement for bucket %d\n", bucket);
+                return 1;
+            }
+            int placed[SVG_COLOR_SLOTS], count = 0, ok = 1;
+            for (int i = 0; i < COLOR_COUNT && ok; i++) {
+                if (bucket_of[i] != bucket) continue;
+                int slot = key_hash(colors[i].name, seed) & (SVG_COLOR_SLOTS - 1);
+                for (int k = 0; k < count; k++) if (placed[k] == slot) ok = 0;
+                if (slot_of[slot] >= 0) ok = 0;
+                placed[count++] = slot;
+            }
+            if (!ok) continue;
+            count = 0;
+            for (int i = 0; i < COLOR_COUNT; i++)
+                if (bucket_of[i] == bucket) slot_of[placed[count++]] = i;
+            displacement[bucket] = seed;
+            break;
+        }
+    }
+
+    printf("// Generated by tools/gen_color_table.c (make colors); do not edit\n");
+    printf("#ifndef SVG_COLOR_TABLE_H\n#define SVG_COLOR_TABLE_H\n\n");
+    printf("#include \"svg_color_hash.h\"\n\n");
+    printf("//%d SVG color keywords\n", COLOR_COUNT);
+    printf("static const uint32_t svg_color_displacement[SVG_COLOR_BUCKETS] = {");
+    for (int i = 0; i < SVG_COLOR_BUCKETS; i++)
+        printf("%s%u%s", i % 12 ? " " : "\n    ", (unsigned)displacement[i], i + 1 < SVG_COLOR_BUCKETS ? "," : "\n");
+    printf("};\n\n");
+    printf("static const SvgNamedColor svg_color_slots[SVG_COLOR_SLOTS] = {\n");
+    for (int i = 0; i < SVG_COLOR_SLOTS; i++) {
+        if (slot_of[i] < 0) printf("    {NULL, 0, 0},\n");
+        else printf("    {\"%s\", %u, 0x%06X},\n", colors[slot_of[i]].name,
+                    (unsigned)strlen(colors[slot_of[i]].name), (unsigned)colors[slot_of[i]].rgb);
+    }
+    printf("};\n\n#endif\n");
+    return 0;
+}